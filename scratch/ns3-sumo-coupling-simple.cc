@@ -129,7 +129,7 @@ main (int argc, char *argv[])
   sumoClient->SetAttribute ("SumoStepLog", BooleanValue (false));
   sumoClient->SetAttribute ("SumoSeed", IntegerValue (10));
   sumoClient->SetAttribute ("SumoAdditionalCmdOptions", StringValue ("--verbose true"));
-  sumoClient->SetAttribute ("SumoWaitForSocket", TimeValue (Seconds (1.0)));
+  sumoClient->SetAttribute ("SumoWaitForSocket", TimeValue (Seconds (10.0)));
 
   /*** 8. Create and Setup Applications for the RSU node and set position ***/
   Ptr<OpenGymInterface> openGymInterface;
@@ -171,48 +171,44 @@ main (int argc, char *argv[])
       "Client",
       (PointerValue) sumoClient); // pass TraciClient object for accessing sumo in application
 
-  // callback function for node creation
-  std::function<Ptr<Node> ()> setupNewWifiNode = [&] () -> Ptr<Node> {
-    if (nodeCounter >= nodePool.GetN ())
-      {
-        // NS_FATAL_ERROR ("Node Pool empty!: " << nodeCounter << " nodes created.");
-        nodeCounter = 1;
-      }
-
-    // don't create and install the protocol stack of the node at simulation time -> take from "node pool"
-    Ptr<Node> includedNode = nodePool.Get (nodeCounter);
-
-    // Install Application
-    ApplicationContainer vehicleSpeedControlApps = vehicleSpeedControlHelper.Install (includedNode);
-
-    srand (std::time (0));
-    vehicleSpeedControlApps.Start (Seconds (0.00001 * (rand () % 100000)));
-    vehicleSpeedControlApps.Stop (simulationTime);
-    nodeCounter++; // increment counter for next node
-
-    return includedNode;
-  };
-
-  // callback function for node shutdown
-  std::function<void (Ptr<Node>)> shutdownWifiNode = [] (Ptr<Node> exNode) {
-    // stop all applications
-    Ptr<VehicleSpeedControl> vehicleSpeedControl =
-        exNode->GetApplication (0)->GetObject<VehicleSpeedControl> ();
-    if (vehicleSpeedControl)
-      {
-        vehicleSpeedControl->StopApplicationNow ();
-      }
-
-    // set position outside communication range
-    Ptr<ConstantPositionMobilityModel> mob = exNode->GetObject<ConstantPositionMobilityModel> ();
-    mob->SetPosition (Vector (320.0 + (rand () % 25), 320.0 + (rand () % 25),
-                              0.0)); // rand() for visualization purposes
-
-    // NOTE: further actions could be required for a save shut down!
-  };
-
-  // start traci client with given function pointers
-  sumoClient->SumoSetup (setupNewWifiNode, shutdownWifiNode);
+  // install the applications of all remaining nodes once; nothing is created at simulation time
+  NodeContainer vehicleNodes;
+  for (uint32_t i = nodeCounter; i < nodePool.GetN (); ++i)
+    {
+      vehicleNodes.Add (nodePool.Get (i));
+    }
+  ApplicationContainer vehicleSpeedControlApps = vehicleSpeedControlHelper.Install (vehicleNodes);
+  vehicleSpeedControlApps.Start (Seconds (0.0));
+  vehicleSpeedControlApps.Stop (simulationTime);
+
+  // park unused nodes outside communication range; their applications keep the sockets but pause
+  Ptr<VehicleNodePool> vehicleNodePool = CreateObject<VehicleNodePool> ();
+  vehicleNodePool->SetActivateCallback ([] (Ptr<Node> node) {
+    node->GetApplication (0)->GetObject<VehicleSpeedControl> ()->Resume ();
+  });
+  vehicleNodePool->SetParkCallback ([] (Ptr<Node> node) {
+    node->GetApplication (0)->GetObject<VehicleSpeedControl> ()->Suspend ();
+  });
+  vehicleNodePool->Add (vehicleNodes);
+
+  // more vehicles than nodes: grow the pool with nodes built like the ones above instead of stopping the run;
+  // the application starts suspended, the activate callback resumes it
+  vehicleNodePool->SetCreateCallback ([&] () {
+    Ptr<Node> node = CreateObject<Node> ();
+    NetDeviceContainer device = wifi80211p.Install (wifiPhy, wifi80211pMac, node);
+    stack.Install (node);
+    address.Assign (device);
+    mobility.Install (node);
+    ApplicationContainer app = vehicleSpeedControlHelper.Install (node);
+    app.Get (0)->GetObject<VehicleSpeedControl> ()->Suspend ();
+    // start and stop times of applications added at simulation time are relative to now
+    app.Start (Seconds (0.0));
+    app.Stop (simulationTime - Simulator::Now ());
+    return node;
+  });
+
+  // start traci client; the pool links nodes to departing vehicles and parks them at arrival
+  sumoClient->SumoSetup (vehicleNodePool->GetIncludeFunction (), vehicleNodePool->GetExcludeFunction ());
 
   /*** 10. Setup and Start Simulation + Animation ***/
   AnimationInterface anim ("rl_fyp/netanim/ns3-sumo-coupling.xml"); // Mandatory
@@ -19,6 +19,7 @@
  *
  */
 
+#include <cstring>
 #include "ns3/log.h"
 #include "container.h"
 
@@ -61,6 +62,52 @@ OpenGymDataContainer::DoInitialize (void)
   //NS_LOG_FUNCTION (this);
 }
 
+void
+OpenGymDataContainer::FillDataContainerPbMsg(ns3opengym::DataContainer &dataContainerPbMsg, google::protobuf::Arena *arena)
+{
+  // field by field; CopyFrom would clear the message and drop its Any
+  ns3opengym::DataContainer msg = GetDataContainerPbMsg();
+  dataContainerPbMsg.set_type(msg.type());
+  dataContainerPbMsg.mutable_data()->set_type_url(msg.data().type_url());
+  dataContainerPbMsg.mutable_data()->set_value(msg.data().value());
+  dataContainerPbMsg.set_name(msg.name());
+}
+
+bool
+OpenGymDataContainer::GetRawTensor(ns3opengym::RawTensor &header, const uint8_t* &data, size_t &size)
+{
+  return false;
+}
+
+template <typename T>
+static Ptr<OpenGymDataContainer>
+CreateBoxFromRawTensor(const ns3opengym::RawTensor &header, const uint8_t *data, size_t size)
+{
+  std::vector<uint32_t> shape(header.shape().begin(), header.shape().end());
+  Ptr<OpenGymBoxContainer<T> > box = CreateObject<OpenGymBoxContainer<T> >(shape);
+  std::vector<T> &myData = box->GetMutableData();
+  myData.resize(size / sizeof(T));
+  std::memcpy(myData.data(), data, myData.size() * sizeof(T));
+  return box;
+}
+
+Ptr<OpenGymDataContainer>
+OpenGymDataContainer::CreateFromRawTensor(const ns3opengym::RawTensor &header, const uint8_t *data, size_t size)
+{
+  // same element types as the protobuf boxes
+  if (header.dtype() == ns3opengym::INT && header.itemsize() == sizeof(int32_t)) {
+    return CreateBoxFromRawTensor<int32_t>(header, data, size);
+  } else if (header.dtype() == ns3opengym::UINT && header.itemsize() == sizeof(uint32_t)) {
+    return CreateBoxFromRawTensor<uint32_t>(header, data, size);
+  } else if (header.dtype() == ns3opengym::DOUBLE && header.itemsize() == sizeof(double)) {
+    return CreateBoxFromRawTensor<double>(header, data, size);
+  } else if (header.itemsize() == sizeof(float)) {
+    return CreateBoxFromRawTensor<float>(header, data, size);
+  }
+  NS_LOG_ERROR("Unsupported raw tensor: dtype " << header.dtype() << ", item size " << header.itemsize());
+  return 0;
+}
+
 Ptr<OpenGymDataContainer>
 OpenGymDataContainer::CreateFromDataContainerPbMsg(ns3opengym::DataContainer &dataContainerPbMsg)
 {
@@ -84,35 +131,35 @@ OpenGymDataContainer::CreateFromDataContainerPbMsg(ns3opengym::DataContainer &da
       Ptr<OpenGymBoxContainer<int32_t> > box = CreateObject<OpenGymBoxContainer<int32_t> >();
       std::vector<int32_t> myData;
       myData.assign(boxContainerPbMsg.intdata().begin(), boxContainerPbMsg.intdata().end());
-      box->SetData(myData);
+      box->SetData(std::move(myData));
       actDataContainer = box;
 
     } else if (boxContainerPbMsg.dtype() == ns3opengym::UINT) {
       Ptr<OpenGymBoxContainer<uint32_t> > box = CreateObject<OpenGymBoxContainer<uint32_t> >();
       std::vector<uint32_t> myData;
       myData.assign(boxContainerPbMsg.uintdata().begin(), boxContainerPbMsg.uintdata().end());
-      box->SetData(myData);
+      box->SetData(std::move(myData));
       actDataContainer = box;
 
     } else if (boxContainerPbMsg.dtype() == ns3opengym::FLOAT) {
       Ptr<OpenGymBoxContainer<float> > box = CreateObject<OpenGymBoxContainer<float> >();
       std::vector<float> myData;
       myData.assign(boxContainerPbMsg.floatdata().begin(), boxContainerPbMsg.floatdata().end());
-      box->SetData(myData);
+      box->SetData(std::move(myData));
       actDataContainer = box;
 
     } else if (boxContainerPbMsg.dtype() == ns3opengym::DOUBLE) {
       Ptr<OpenGymBoxContainer<double> > box = CreateObject<OpenGymBoxContainer<double> >();
       std::vector<double> myData;
       myData.assign(boxContainerPbMsg.doubledata().begin(), boxContainerPbMsg.doubledata().end());
-      box->SetData(myData);
+      box->SetData(std::move(myData));
       actDataContainer = box;
 
     } else {
       Ptr<OpenGymBoxContainer<float> > box = CreateObject<OpenGymBoxContainer<float> >();
       std::vector<float> myData;
       myData.assign(boxContainerPbMsg.floatdata().begin(), boxContainerPbMsg.floatdata().end());
-      box->SetData(myData);
+      box->SetData(std::move(myData));
       actDataContainer = box;
     }
   }
@@ -202,12 +249,19 @@ ns3opengym::DataContainer
 OpenGymDiscreteContainer::GetDataContainerPbMsg()
 {
   ns3opengym::DataContainer dataContainerPbMsg;
-  ns3opengym::DiscreteDataContainer discreteContainerPbMsg;
-  discreteContainerPbMsg.set_data(GetValue());
+  FillDataContainerPbMsg(dataContainerPbMsg, 0);
+  return dataContainerPbMsg;
+}
+
+void
+OpenGymDiscreteContainer::FillDataContainerPbMsg(ns3opengym::DataContainer &dataContainerPbMsg, google::protobuf::Arena *arena)
+{
+  std::unique_ptr<ns3opengym::DiscreteDataContainer> holder;
+  ns3opengym::DiscreteDataContainer *discreteContainerPbMsg = CreatePbSubMsg(arena, holder);
+  discreteContainerPbMsg->set_data(GetValue());
 
   dataContainerPbMsg.set_type(ns3opengym::Discrete);
-  dataContainerPbMsg.mutable_data()->PackFrom(discreteContainerPbMsg);
-  return dataContainerPbMsg;
+  PackPbSubMsg(*dataContainerPbMsg.mutable_data(), *discreteContainerPbMsg);
 }
 
 bool
@@ -266,21 +320,27 @@ ns3opengym::DataContainer
 OpenGymTupleContainer::GetDataContainerPbMsg()
 {
   ns3opengym::DataContainer dataContainerPbMsg;
+  FillDataContainerPbMsg(dataContainerPbMsg, 0);
+  return dataContainerPbMsg;
+}
+
+void
+OpenGymTupleContainer::FillDataContainerPbMsg(ns3opengym::DataContainer &dataContainerPbMsg, google::protobuf::Arena *arena)
+{
   dataContainerPbMsg.set_type(ns3opengym::Tuple);
 
-  ns3opengym::TupleDataContainer tupleContainerPbMsg;
+  std::unique_ptr<ns3opengym::TupleDataContainer> holder;
+  ns3opengym::TupleDataContainer *tupleContainerPbMsg = CreatePbSubMsg(arena, holder);
 
+  // elements are filled in place, no copies
   std::vector< Ptr<OpenGymDataContainer> >::iterator it;
   for (it=m_tuple.begin(); it!=m_tuple.end(); ++it)
   {
     Ptr<OpenGymDataContainer> subSpace = *it;
-    ns3opengym::DataContainer subDataContainer = subSpace->GetDataContainerPbMsg();
-
-    tupleContainerPbMsg.add_element()->CopyFrom(subDataContainer);
+    subSpace->FillDataContainerPbMsg(*tupleContainerPbMsg->add_element(), arena);
   }
 
-  dataContainerPbMsg.mutable_data()->PackFrom(tupleContainerPbMsg);
-  return dataContainerPbMsg;
+  PackPbSubMsg(*dataContainerPbMsg.mutable_data(), *tupleContainerPbMsg);
 }
 
 bool
@@ -362,24 +422,28 @@ ns3opengym::DataContainer
 OpenGymDictContainer::GetDataContainerPbMsg()
 {
   ns3opengym::DataContainer dataContainerPbMsg;
+  FillDataContainerPbMsg(dataContainerPbMsg, 0);
+  return dataContainerPbMsg;
+}
+
+void
+OpenGymDictContainer::FillDataContainerPbMsg(ns3opengym::DataContainer &dataContainerPbMsg, google::protobuf::Arena *arena)
+{
   dataContainerPbMsg.set_type(ns3opengym::Dict);
 
-  ns3opengym::DictDataContainer dictContainerPbMsg;
+  std::unique_ptr<ns3opengym::DictDataContainer> holder;
+  ns3opengym::DictDataContainer *dictContainerPbMsg = CreatePbSubMsg(arena, holder);
 
   std::map< std::string, Ptr<OpenGymDataContainer> >::iterator it;
   for (it=m_dict.begin(); it!=m_dict.end(); ++it)
   {
-    std::string name = it->first;
     Ptr<OpenGymDataContainer> subSpace = it->second;
-
-    ns3opengym::DataContainer subDataContainer = subSpace->GetDataContainerPbMsg();
-    subDataContainer.set_name(name);
-
-    dictContainerPbMsg.add_element()->CopyFrom(subDataContainer);
+    ns3opengym::DataContainer *subDataContainer = dictContainerPbMsg->add_element();
+    subSpace->FillDataContainerPbMsg(*subDataContainer, arena);
+    subDataContainer->set_name(it->first);
   }
 
-  dataContainerPbMsg.mutable_data()->PackFrom(dictContainerPbMsg);
-  return dataContainerPbMsg;
+  PackPbSubMsg(*dataContainerPbMsg.mutable_data(), *dictContainerPbMsg);
 }
 
 bool
@@ -22,12 +22,36 @@
 #ifndef OPENGYM_CONTAINER_H
 #define OPENGYM_CONTAINER_H
 
+#include <memory>
+#include <utility>
 #include "ns3/object.h"
 #include "ns3/type-name.h"
 #include "messages.pb.h"
 
 namespace ns3 {
 
+// temporary message of type M on arena, or on the heap owned by holder without arena
+template <typename M>
+M*
+CreatePbSubMsg(google::protobuf::Arena *arena, std::unique_ptr<M> &holder)
+{
+  if (arena) {
+    return google::protobuf::Arena::CreateMessage<M>(arena);
+  }
+  holder.reset(new M());
+  return holder.get();
+}
+
+// Any::PackFrom without building the type url every time; a cleared Any keeps its buffers
+template <typename M>
+void
+PackPbSubMsg(google::protobuf::Any &any, const M &msg)
+{
+  static const std::string typeUrl = "type.googleapis.com/" + M::descriptor()->full_name();
+  any.set_type_url(typeUrl);
+  msg.SerializeToString(any.mutable_value());
+}
+
 class OpenGymDataContainer : public Object
 {
 public:
@@ -37,8 +61,15 @@ public:
   static TypeId GetTypeId ();
 
   virtual ns3opengym::DataContainer GetDataContainerPbMsg() = 0;
+  // fill a message in place, e.g. one reused every step: type and data are overwritten, the Any keeps its
+  // buffers. Temporary sub messages are created on arena (heap if 0). The default copies GetDataContainerPbMsg
+  virtual void FillDataContainerPbMsg(ns3opengym::DataContainer &dataContainer, google::protobuf::Arena *arena);
   static Ptr<OpenGymDataContainer> CreateFromDataContainerPbMsg(ns3opengym::DataContainer &dataContainer);
 
+  // header and contiguous data for the raw tensor transport; false if the container has no such representation
+  virtual bool GetRawTensor(ns3opengym::RawTensor &header, const uint8_t* &data, size_t &size);
+  static Ptr<OpenGymDataContainer> CreateFromRawTensor(const ns3opengym::RawTensor &header, const uint8_t *data, size_t size);
+
   virtual void Print(std::ostream& where) const = 0;
   friend std::ostream& operator<< (std::ostream& os, const Ptr<OpenGymDataContainer> container)
   {
@@ -63,6 +94,7 @@ public:
   static TypeId GetTypeId ();
 
   virtual ns3opengym::DataContainer GetDataContainerPbMsg();
+  virtual void FillDataContainerPbMsg(ns3opengym::DataContainer &dataContainer, google::protobuf::Arena *arena);
 
   virtual void Print(std::ostream& where) const;
   friend std::ostream& operator<< (std::ostream& os, const Ptr<OpenGymDiscreteContainer> container)
@@ -94,6 +126,8 @@ public:
   static TypeId GetTypeId ();
 
   virtual ns3opengym::DataContainer GetDataContainerPbMsg();
+  virtual void FillDataContainerPbMsg(ns3opengym::DataContainer &dataContainer, google::protobuf::Arena *arena);
+  virtual bool GetRawTensor(ns3opengym::RawTensor &header, const uint8_t* &data, size_t &size);
 
   virtual void Print(std::ostream& where) const;
   friend std::ostream& operator<< (std::ostream& os, const Ptr<OpenGymBoxContainer> container)
@@ -105,9 +139,20 @@ public:
   bool AddValue(T value);
   T GetValue(uint32_t idx);
 
-  bool SetData(std::vector<T> data);
+  bool SetData(const std::vector<T> &data);
+  // takes over the buffer of data without copying it
+  bool SetData(std::vector<T> &&data);
   std::vector<T> GetData();
 
+  // views on the data without copying; valid until the data is changed
+  const T* GetDataPtr() const;
+  uint32_t GetDataSize() const;
+  const std::vector<T>& GetDataRef() const;
+  // fill or modify large boxes in place, e.g. after the shape constructor reserved the space
+  std::vector<T>& GetMutableData();
+  // moves the data out, the container is empty afterwards
+  std::vector<T> TakeData();
+
   std::vector<uint32_t> GetShape();
 
 protected:
@@ -146,6 +191,14 @@ OpenGymBoxContainer<T>::OpenGymBoxContainer(std::vector<uint32_t> shape):
 	m_shape(shape)
 {
   SetDtype();
+  // AddValue does not reallocate while filling the box
+  size_t size = 1;
+  for (uint32_t dim : m_shape) {
+    size *= dim;
+  }
+  if (!m_shape.empty()) {
+    m_data.reserve(size);
+  }
 }
 
 template <typename T>
@@ -187,34 +240,53 @@ ns3opengym::DataContainer
 OpenGymBoxContainer<T>::GetDataContainerPbMsg()
 {
   ns3opengym::DataContainer dataContainerPbMsg;
-  ns3opengym::BoxDataContainer boxContainerPbMsg;
-
-  std::vector<uint32_t> shape = GetShape();
-  *boxContainerPbMsg.mutable_shape() = {shape.begin(), shape.end()};
+  FillDataContainerPbMsg(dataContainerPbMsg, 0);
+  return dataContainerPbMsg;
+}
 
+template <typename T>
+void
+OpenGymBoxContainer<T>::FillDataContainerPbMsg(ns3opengym::DataContainer &dataContainerPbMsg, google::protobuf::Arena *arena)
+{
+  std::unique_ptr<ns3opengym::BoxDataContainer> holder;
+  ns3opengym::BoxDataContainer *boxContainerPbMsg = CreatePbSubMsg(arena, holder);
 
-  boxContainerPbMsg.set_dtype(m_dtype);
-  std::vector<T> data = GetData();
+  boxContainerPbMsg->mutable_shape()->Add(m_shape.begin(), m_shape.end());
+  boxContainerPbMsg->set_dtype(m_dtype);
 
+  // copied straight from m_data, converted to the element type of the dtype
   if (m_dtype == ns3opengym::INT) {
-    *boxContainerPbMsg.mutable_intdata() = {data.begin(), data.end()};
+    boxContainerPbMsg->mutable_intdata()->Add(m_data.begin(), m_data.end());
 
   } else if (m_dtype == ns3opengym::UINT) {
-    *boxContainerPbMsg.mutable_uintdata() = {data.begin(), data.end()};
-
-  } else if (m_dtype == ns3opengym::FLOAT) {
-    *boxContainerPbMsg.mutable_floatdata() = {data.begin(), data.end()};
+    boxContainerPbMsg->mutable_uintdata()->Add(m_data.begin(), m_data.end());
 
   } else if (m_dtype == ns3opengym::DOUBLE) {
-    *boxContainerPbMsg.mutable_doubledata() = {data.begin(), data.end()};
+    boxContainerPbMsg->mutable_doubledata()->Add(m_data.begin(), m_data.end());
 
   } else {
-    *boxContainerPbMsg.mutable_floatdata() = {data.begin(), data.end()};
+    boxContainerPbMsg->mutable_floatdata()->Add(m_data.begin(), m_data.end());
   }
 
   dataContainerPbMsg.set_type(ns3opengym::Box);
-  dataContainerPbMsg.mutable_data()->PackFrom(boxContainerPbMsg);
-  return dataContainerPbMsg;
+  PackPbSubMsg(*dataContainerPbMsg.mutable_data(), *boxContainerPbMsg);
+}
+
+template <typename T>
+bool
+OpenGymBoxContainer<T>::GetRawTensor(ns3opengym::RawTensor &header, const uint8_t* &data, size_t &size)
+{
+  header.set_dtype(m_dtype);
+  header.set_itemsize(sizeof(T));
+  // a box without shape is sent as flat vector
+  if (m_shape.empty()) {
+    header.add_shape(m_data.size());
+  } else {
+    *header.mutable_shape() = {m_shape.begin(), m_shape.end()};
+  }
+  data = reinterpret_cast<const uint8_t*>(m_data.data());
+  size = m_data.size() * sizeof(T);
+  return true;
 }
 
 template <typename T>
@@ -239,12 +311,20 @@ OpenGymBoxContainer<T>::GetValue(uint32_t idx)
 
 template <typename T>
 bool
-OpenGymBoxContainer<T>::SetData(std::vector<T> data)
+OpenGymBoxContainer<T>::SetData(const std::vector<T> &data)
 {
   m_data = data;
   return true;
 }
 
+template <typename T>
+bool
+OpenGymBoxContainer<T>::SetData(std::vector<T> &&data)
+{
+  m_data = std::move(data);
+  return true;
+}
+
 template <typename T>
 std::vector<uint32_t>
 OpenGymBoxContainer<T>::GetShape()
@@ -259,6 +339,43 @@ OpenGymBoxContainer<T>::GetData()
   return m_data;
 }
 
+template <typename T>
+const T*
+OpenGymBoxContainer<T>::GetDataPtr() const
+{
+  return m_data.data();
+}
+
+template <typename T>
+uint32_t
+OpenGymBoxContainer<T>::GetDataSize() const
+{
+  return m_data.size();
+}
+
+template <typename T>
+const std::vector<T>&
+OpenGymBoxContainer<T>::GetDataRef() const
+{
+  return m_data;
+}
+
+template <typename T>
+std::vector<T>&
+OpenGymBoxContainer<T>::GetMutableData()
+{
+  return m_data;
+}
+
+template <typename T>
+std::vector<T>
+OpenGymBoxContainer<T>::TakeData()
+{
+  std::vector<T> data;
+  data.swap(m_data);
+  return data;
+}
+
 template <typename T>
 void
 OpenGymBoxContainer<T>::Print(std::ostream& where) const
@@ -285,6 +402,7 @@ public:
   static TypeId GetTypeId ();
 
   virtual ns3opengym::DataContainer GetDataContainerPbMsg();
+  virtual void FillDataContainerPbMsg(ns3opengym::DataContainer &dataContainer, google::protobuf::Arena *arena);
 
   virtual void Print(std::ostream& where) const;
   friend std::ostream& operator<< (std::ostream& os, const Ptr<OpenGymTupleContainer> container)
@@ -314,6 +432,7 @@ public:
   static TypeId GetTypeId ();
 
   virtual ns3opengym::DataContainer GetDataContainerPbMsg();
+  virtual void FillDataContainerPbMsg(ns3opengym::DataContainer &dataContainer, google::protobuf::Arena *arena);
 
   virtual void Print(std::ostream& where) const;
   friend std::ostream& operator<< ( std::ostream& os, const Ptr<OpenGymDictContainer> container)
@@ -11,6 +11,7 @@ from gym.utils import seeding
 from enum import IntEnum
 
 from ns3gym.start_sim import start_sim_script, build_ns3_project
+from ns3gym import shm_channel
 
 import ns3gym.messages_pb2 as pb
 from google.protobuf.any_pb2 import Any
@@ -78,6 +79,11 @@ class Ns3ZmqBridge(object):
         self.gameOverReason = None
         self.extraInfo = None
         self.newStateRx = False
+        self.rawTensor = False
+        self.shm = None
+        # number of envs of a vectorized env, 0 for a single env
+        self.numEnvs = 0
+        self.envDone = None
 
     def close(self):
         try:
@@ -86,6 +92,9 @@ class Ns3ZmqBridge(object):
                 self.force_env_stop()
                 self.rx_env_state()
                 self.send_close_command()
+                if self.shm:
+                    self.shm.close()
+                    self.shm = None
                 self.ns3Process.kill()
                 if self.simPid:
                     os.kill(self.simPid, signal.SIGTERM)
@@ -156,10 +165,18 @@ class Ns3ZmqBridge(object):
         self.wafPid = int(simInitMsg.wafShellProcessId)
         self._action_space = self._create_space(simInitMsg.actSpace)
         self._observation_space = self._create_space(simInitMsg.obsSpace)
+        # box observations arrive as header plus raw data frame
+        self.rawTensor = simInitMsg.rawTensor
+        self.numEnvs = simInitMsg.numEnvs
+        # steps go through shared memory; map it before the ack, ns-3 removes the name afterwards
+        if simInitMsg.shmName:
+            self.shm = shm_channel.Ns3ShmChannel(simInitMsg.shmName, simInitMsg.shmSize)
 
         reply = pb.SimInitAck()
         reply.done = True
         reply.stopSimReq = False
+        # lets ns-3 notice a dead agent while it waits for an action in shared memory
+        reply.agentProcessId = os.getpid()
         replyMsg = reply.SerializeToString()
         self.socket.send(replyMsg)
         return True
@@ -177,11 +194,29 @@ class Ns3ZmqBridge(object):
         if self.newStateRx:
             return
 
-        request = self.socket.recv()
+        if self.shm:
+            self._rx_shm_env_state()
+            return
+
+        if self.numEnvs:
+            self._rx_env_state_batch()
+            return
+
+        if self.rawTensor:
+            frames = self.socket.recv_multipart(copy=False)
+            request = frames[0].bytes
+        else:
+            request = self.socket.recv()
         envStateMsg = pb.EnvStateMsg()
         envStateMsg.ParseFromString(request)
 
-        self.obsData = self._create_data(envStateMsg.obsData)
+        # unchanged observation and info are omitted, the last ones still hold
+        if envStateMsg.obsUnchanged:
+            pass
+        elif envStateMsg.HasField("obsTensor"):
+            self.obsData = self._create_tensor(envStateMsg.obsTensor, frames[1])
+        else:
+            self.obsData = self._create_data(envStateMsg.obsData)
         self.reward = envStateMsg.reward
         self.gameOver = envStateMsg.isGameOver
         self.gameOverReason = envStateMsg.reason
@@ -194,13 +229,86 @@ class Ns3ZmqBridge(object):
                 self.forceEnvStop = True
                 self.send_close_command()
 
-        self.extraInfo = envStateMsg.info
+        if not envStateMsg.infoUnchanged:
+            self.extraInfo = envStateMsg.info
+            if not self.extraInfo:
+                self.extraInfo = {}
+
+        self.newStateRx = True
+
+    def _sim_alive(self):
+        return self.ns3Process is None or self.ns3Process.poll() is None
+
+    def _rx_shm_env_state(self):
+        flags, reward, kind, dtype, itemSize, shape, data, info = self.shm.recv_state(self._sim_alive)
+
+        if kind == shm_channel.RAW_TENSOR:
+            tensor = pb.RawTensor(dtype=dtype, itemSize=itemSize, shape=shape)
+            self.obsData = self._create_tensor(tensor, data)
+        elif kind == shm_channel.PB_CONTAINER:
+            dataContainerPb = pb.DataContainer()
+            dataContainerPb.ParseFromString(data)
+            self.obsData = self._create_data(dataContainerPb)
+        else:
+            self.obsData = None
+        self.reward = reward
+        self.gameOver = bool(flags & shm_channel.GAME_OVER)
+        self.gameOverReason = pb.EnvStateMsg.SimulationEnd if flags & shm_channel.SIMULATION_END else pb.EnvStateMsg.GameOver
+
+        if self.gameOver:
+            if self.gameOverReason == pb.EnvStateMsg.SimulationEnd:
+                self.envStopped = True
+            else:
+                self.forceEnvStop = True
+            self.send_close_command()
+
+        self.extraInfo = info.decode('utf-8')
         if not self.extraInfo:
             self.extraInfo = {}
 
         self.newStateRx = True
 
+    def _rx_env_state_batch(self):
+        request = self.socket.recv()
+        batchMsg = pb.EnvStateBatchMsg()
+        batchMsg.ParseFromString(request)
+
+        # lists in env id order; unchanged observations and infos are omitted, the last ones still hold
+        lastObs = self.obsData if isinstance(self.obsData, list) else [None] * len(batchMsg.state)
+        lastInfo = self.extraInfo if isinstance(self.extraInfo, list) else [None] * len(batchMsg.state)
+        self.obsData = [lastObs[i] if state.obsUnchanged else self._create_data(state.obsData)
+                        for i, state in enumerate(batchMsg.state)]
+        self.reward = [state.reward for state in batchMsg.state]
+        self.envDone = [state.isGameOver for state in batchMsg.state]
+        self.extraInfo = [lastInfo[i] if state.infoUnchanged else state.info
+                          for i, state in enumerate(batchMsg.state)]
+
+        # the simulation ends with all envs
+        self.gameOver = all(self.envDone)
+        if self.gameOver:
+            simEnd = any(state.reason == pb.EnvStateMsg.SimulationEnd for state in batchMsg.state)
+            self.gameOverReason = pb.EnvStateMsg.SimulationEnd if simEnd else pb.EnvStateMsg.GameOver
+            if simEnd:
+                self.envStopped = True
+            else:
+                self.forceEnvStop = True
+            self.send_close_command()
+
+        self.newStateRx = True
+
     def send_close_command(self):
+        if self.numEnvs:
+            reply = pb.EnvActBatchMsg()
+            reply.stopSimReq = True
+            self.socket.send(reply.SerializeToString())
+            self.newStateRx = False
+            return True
+
+        if self.shm:
+            self.shm.send_action(shm_channel.NO_DATA, flags=shm_channel.STOP_SIM)
+            self.newStateRx = False
+            return True
+
         reply = pb.EnvActMsg()
         reply.stopSimReq = True
 
@@ -209,7 +317,51 @@ class Ns3ZmqBridge(object):
         self.newStateRx = False
         return True
 
+    def _send_shm_actions(self, actions):
+        flags = shm_channel.STOP_SIM if self.forceEnvStop else 0
+        spaceType = self._action_space.__class__
+
+        if spaceType == spaces.Discrete:
+            self.shm.send_action(shm_channel.DISCRETE, flags=flags, shape=[int(actions)])
+
+        elif spaceType == spaces.Box:
+            # boxes go as raw array in the dtype of the space
+            kind = np.dtype(self._action_space.dtype).kind
+            if kind == 'i':
+                dtype, npType = pb.INT, '<i4'
+            elif kind == 'u':
+                dtype, npType = pb.UINT, '<u4'
+            else:
+                dtype, npType = pb.FLOAT, '<f4'
+            data = np.ascontiguousarray(actions, dtype=npType)
+            self.shm.send_action(shm_channel.RAW_TENSOR, data.tobytes(), flags, dtype, data.itemsize, data.shape)
+
+        else:
+            actionMsg = self._pack_data(actions, self._action_space)
+            self.shm.send_action(shm_channel.PB_CONTAINER, actionMsg.SerializeToString(), flags)
+
+        self.newStateRx = False
+        return True
+
+    def _send_actions_batch(self, actions):
+        reply = pb.EnvActBatchMsg()
+        # one action per env; envs that are done ignore theirs
+        for envActions in actions:
+            envActMsg = reply.action.add()
+            envActMsg.actData.CopyFrom(self._pack_data(envActions, self._action_space))
+
+        reply.stopSimReq = self.forceEnvStop
+        self.socket.send(reply.SerializeToString())
+        self.newStateRx = False
+        return True
+
     def send_actions(self, actions):
+        if self.shm:
+            return self._send_shm_actions(actions)
+
+        if self.numEnvs:
+            return self._send_actions_batch(actions)
+
         reply = pb.EnvActMsg()
 
         actionMsg = self._pack_data(actions, self._action_space)
@@ -233,6 +385,20 @@ class Ns3ZmqBridge(object):
     def is_game_over(self):
         return self.gameOver
 
+    def get_done(self):
+        # per env for a vectorized env
+        if self.numEnvs:
+            return self.envDone
+        return self.gameOver
+
+    def _create_tensor(self, rawTensorPb, frame):
+        kind = {pb.INT: 'i', pb.UINT: 'u', pb.FLOAT: 'f', pb.DOUBLE: 'f'}.get(rawTensorPb.dtype, 'f')
+        dtype = np.dtype('<%s%d' % (kind, rawTensorPb.itemSize))
+        # read-only view on the zmq frame (or the bytes copied out of shared memory), no copy
+        buf = frame if isinstance(frame, bytes) else frame.buffer
+        data = np.frombuffer(buf, dtype=dtype)
+        return data.reshape(tuple(rawTensorPb.shape))
+
     def _create_data(self, dataContainerPb):
         if (dataContainerPb.type == pb.Discrete):
             discreteContainerPb = pb.DiscreteDataContainer()
@@ -381,6 +547,8 @@ class Ns3Env(gym.Env):
         self.ns3ZmqBridge.initialize_env(self.stepTime)
         self.action_space = self.ns3ZmqBridge.get_action_space()
         self.observation_space = self.ns3ZmqBridge.get_observation_space()
+        # vectorized env: observations, rewards, dones and infos are lists and step takes one action per env
+        self.num_envs = self.ns3ZmqBridge.numEnvs
         # get first observations
         self.ns3ZmqBridge.rx_env_state()
         self.envDirty = False
@@ -393,7 +561,7 @@ class Ns3Env(gym.Env):
     def get_state(self):
         obs = self.ns3ZmqBridge.get_obs()
         reward = self.ns3ZmqBridge.get_reward()
-        done = self.ns3ZmqBridge.is_game_over()
+        done = self.ns3ZmqBridge.get_done()
         extraInfo = self.ns3ZmqBridge.get_extra_info()
         return (obs, reward, done, extraInfo)
 
@@ -416,6 +584,7 @@ class Ns3Env(gym.Env):
         self.ns3ZmqBridge.initialize_env(self.stepTime)
         self.action_space = self.ns3ZmqBridge.get_action_space()
         self.observation_space = self.ns3ZmqBridge.get_observation_space()
+        self.num_envs = self.ns3ZmqBridge.numEnvs
         # get first observations
         self.ns3ZmqBridge.rx_env_state()
         obs = self.ns3ZmqBridge.get_obs()
@@ -425,6 +594,8 @@ class Ns3Env(gym.Env):
         return
 
     def get_random_action(self):
+        if self.num_envs:
+            return [self.action_space.sample() for _ in range(self.num_envs)]
         act = self.action_space.sample()
         return act
 
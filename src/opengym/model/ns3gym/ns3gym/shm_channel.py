@@ -0,0 +1,112 @@
+import os
+import errno
+import mmap
+import time
+import struct
+import ctypes
+import ctypes.util
+
+__author__ = "Piotr Gawlowicz"
+__copyright__ = "Copyright (c) 2018, Technische Universität Berlin"
+__version__ = "0.1.0"
+__email__ = "gawlowicz@tkn.tu-berlin.de"
+
+# layout of the shared memory, see OpenGymShmChannel in opengym_shm.h
+_HEADER = struct.Struct('<8sIIIIII')
+_SLOT = struct.Struct('<IIfIIII8III')
+_SLOT_HEADER_SIZE = 128
+_MAX_DIMS = 8
+_VERSION = 1
+
+# data kinds
+NO_DATA = 0
+RAW_TENSOR = 1
+PB_CONTAINER = 2
+DISCRETE = 3
+
+# slot flags
+GAME_OVER = 1
+SIMULATION_END = 2
+STOP_SIM = 4
+
+
+def _load_libc():
+    # sem_* live in libc since glibc 2.34, in libpthread before
+    for name in [None, ctypes.util.find_library('pthread')]:
+        lib = ctypes.CDLL(name, use_errno=True)
+        if hasattr(lib, 'sem_timedwait'):
+            return lib
+    raise OSError("POSIX semaphores not available")
+
+
+_libc = _load_libc()
+
+
+class _Timespec(ctypes.Structure):
+    _fields_ = [('tv_sec', ctypes.c_long), ('tv_nsec', ctypes.c_long)]
+
+
+class Ns3ShmChannel(object):
+    """Shared memory slots for the step exchange with ns-3 on the same host"""
+    def __init__(self, name, size):
+        super(Ns3ShmChannel, self).__init__()
+        fd = os.open('/dev/shm' + name, os.O_RDWR)
+        try:
+            self.mm = mmap.mmap(fd, size)
+        finally:
+            os.close(fd)
+
+        magic, version, stateSem, actSem, self.stateSlot, self.actSlot, self.slotSize = _HEADER.unpack_from(self.mm, 0)
+        if magic.rstrip(b'\0') != b'NS3GYM' or version != _VERSION:
+            raise RuntimeError("Unknown shared memory layout in %s" % name)
+
+        # semaphores are used in place; keep the buffer exports until close
+        self._stateSemBuf = ctypes.c_char.from_buffer(self.mm, stateSem)
+        self._actSemBuf = ctypes.c_char.from_buffer(self.mm, actSem)
+        self._stateSem = ctypes.c_void_p(ctypes.addressof(self._stateSemBuf))
+        self._actSem = ctypes.c_void_p(ctypes.addressof(self._actSemBuf))
+        self.seq = 0
+
+    def close(self):
+        self._stateSem = None
+        self._actSem = None
+        self._stateSemBuf = None
+        self._actSemBuf = None
+        self.mm.close()
+
+    def _wait_state(self, alive):
+        while True:
+            now = time.time() + 1.0
+            ts = _Timespec(int(now), int((now % 1.0) * 1e9))
+            if _libc.sem_timedwait(self._stateSem, ctypes.byref(ts)) == 0:
+                return
+            err = ctypes.get_errno()
+            if err not in (errno.ETIMEDOUT, errno.EINTR):
+                raise OSError(err, os.strerror(err))
+            if alive is not None and not alive():
+                raise RuntimeError("ns-3 simulation exited")
+
+    def recv_state(self, alive=None):
+        """Wait for the next env state; returns (flags, reward, kind, dtype, itemSize, shape, data, info).
+        data is a copy of the observation bytes, the slot is overwritten by the next step"""
+        self._wait_state(alive)
+        fields = _SLOT.unpack_from(self.mm, self.stateSlot)
+        flags, reward, kind, dtype, itemSize, ndim = fields[1:7]
+        shape = tuple(fields[7:7 + ndim])
+        dataSize, infoSize = fields[7 + _MAX_DIMS:]
+        start = self.stateSlot + _SLOT_HEADER_SIZE
+        data = self.mm[start:start + dataSize]
+        info = self.mm[start + dataSize:start + dataSize + infoSize]
+        return flags, reward, kind, dtype, itemSize, shape, data, info
+
+    def send_action(self, kind, data=b'', flags=0, dtype=0, itemSize=0, shape=()):
+        """Write the action into the slot and wake up ns-3"""
+        if len(data) > self.slotSize:
+            raise ValueError("Action of %d bytes exceeds the shared memory slot" % len(data))
+        shape = list(shape)[:_MAX_DIMS]
+        self.seq += 1
+        _SLOT.pack_into(self.mm, self.actSlot, self.seq, flags, 0.0, kind, dtype, itemSize, len(shape),
+                        *(shape + [0] * (_MAX_DIMS - len(shape)) + [len(data), 0]))
+        start = self.actSlot + _SLOT_HEADER_SIZE
+        self.mm[start:start + len(data)] = data
+        _libc.sem_post(self._actSem)
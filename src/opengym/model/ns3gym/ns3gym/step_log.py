@@ -0,0 +1,49 @@
+import struct
+
+__author__ = "Piotr Gawlowicz"
+__copyright__ = "Copyright (c) 2018, Technische Universität Berlin"
+__version__ = "0.1.0"
+__email__ = "gawlowicz@tkn.tu-berlin.de"
+
+# layout of the step log, see OpenGymStepLog in opengym_step_log.h
+_FILE_HEADER = struct.Struct('<8sII')
+_RECORD = struct.Struct('<IHHQqfBBBBIIII')
+_VERSION = 1
+
+# record types
+STATE = 1
+ACTION = 2
+
+# data kinds
+NO_DATA = 0
+RAW_TENSOR = 1
+PB_CONTAINER = 2
+
+
+def read_step_log(path):
+    """Yield the records of a step log as dicts; data are the raw bytes of the observation or action
+    (a box with dtype, itemSize and shape, or a serialized DataContainer)"""
+    with open(path, 'rb') as f:
+        buf = f.read()
+
+    magic, version, recordHeaderSize = _FILE_HEADER.unpack_from(buf, 0)
+    if magic != b'NS3GYMLG' or version != _VERSION or recordHeaderSize != _RECORD.size:
+        raise RuntimeError("Unknown step log format in %s" % path)
+
+    pos = _FILE_HEADER.size
+    while pos + _RECORD.size <= len(buf):
+        size, rtype, env, step, timeNs, reward, gameOver, kind, dtype, itemSize, ndim, dataSize, infoSize, _ = \
+            _RECORD.unpack_from(buf, pos)
+        if size < _RECORD.size or pos + size > len(buf):
+            break  # truncated by a crash
+        start = pos + _RECORD.size
+        shape = struct.unpack_from('<%dI' % ndim, buf, start)
+        start += 4 * ndim
+        yield {
+            'type': rtype, 'env': env, 'step': step, 'time': timeNs * 1e-9,
+            'reward': reward, 'gameOver': bool(gameOver),
+            'kind': kind, 'dtype': dtype, 'itemSize': itemSize, 'shape': shape,
+            'data': buf[start:start + dataSize],
+            'info': buf[start + dataSize:start + dataSize + infoSize].decode('utf-8'),
+        }
+        pos += size
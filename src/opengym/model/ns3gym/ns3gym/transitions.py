@@ -0,0 +1,210 @@
+import mmap
+import zlib
+import struct
+
+import numpy as np
+
+import gym
+from gym import spaces
+
+__author__ = "Piotr Gawlowicz"
+__copyright__ = "Copyright (c) 2018, Technische Universität Berlin"
+__version__ = "0.1.0"
+__email__ = "gawlowicz@tkn.tu-berlin.de"
+
+# layout of the transition file, see OpenGymTransitionRecorder in opengym_transition_recorder.h
+_MAX_DIMS = 8
+_FILE_HEADER = struct.Struct('<8sIIIIII%dIIII%dII' % (_MAX_DIMS, _MAX_DIMS))
+_CHUNK_HEADER = struct.Struct('<8sQ6Q6Q6Q')
+_TRAILER = struct.Struct('<QQQ8s')
+_ALIGNMENT = 64
+_VERSION = 1
+
+CODEC_NONE = 0
+CODEC_ZLIB = 1
+
+COLUMNS = ('env', 'step', 'obs', 'action', 'reward', 'done')
+
+
+def _align(pos):
+    return (pos + _ALIGNMENT - 1) // _ALIGNMENT * _ALIGNMENT
+
+
+def _dtype(dtype, itemSize):
+    kind = {1: 'i', 2: 'u', 3: 'f', 4: 'f'}.get(dtype, 'u')
+    return np.dtype('<%s%d' % (kind, itemSize)) if itemSize else np.dtype('u1')
+
+
+class TransitionDataset(object):
+    """Steps recorded by ns3::OpenGymTransitionRecorder, read from a memory mapping.
+
+    Columns are numpy arrays with one row per step: env, step, obs, action, reward, done.
+    Row t holds the state of step t and the action the agent answered with; the reward
+    and done of that action are in the next row of the same env (see transitions()).
+    Uncompressed columns are views on the mapping, compressed ones are inflated per chunk."""
+
+    def __init__(self, path):
+        self.path = path
+        with open(path, 'rb') as f:
+            self._mm = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+
+        fields = _FILE_HEADER.unpack_from(self._mm, 0)
+        magic, version, self.codec, self.chunkRows = fields[:4]
+        if magic != b'NS3GYMTR' or version != _VERSION:
+            raise RuntimeError("Unknown transition file format in %s" % path)
+        obsDtype, obsItemSize, obsNdim = fields[4:7]
+        obsShape = fields[7:7 + _MAX_DIMS]
+        actDtype, actItemSize, actNdim = fields[15:18]
+        actShape = fields[18:18 + _MAX_DIMS]
+
+        self.obsDtype = _dtype(obsDtype, obsItemSize)
+        self.obsShape = tuple(obsShape[:obsNdim])
+        self.actDtype = _dtype(actDtype, actItemSize)
+        self.actShape = tuple(actShape[:actNdim])
+        self.hasActions = actItemSize > 0
+        self._dtypes = {'env': np.dtype('<u4'), 'step': np.dtype('<u8'), 'obs': self.obsDtype,
+                        'action': self.actDtype, 'reward': np.dtype('<f4'), 'done': np.dtype('u1')}
+        self._shapes = {'obs': self.obsShape, 'action': self.actShape if self.hasActions else (0,)}
+
+        self.chunkOffsets = self._read_index()
+        self._columns = None
+
+    def _read_index(self):
+        size = len(self._mm)
+        if size >= _FILE_HEADER.size + _TRAILER.size:
+            indexOffset, chunks, _, magic = _TRAILER.unpack_from(self._mm, size - _TRAILER.size)
+            if magic == b'NS3GYMTE':
+                return list(struct.unpack_from('<%dQ' % chunks, self._mm, indexOffset))
+
+        # no index (the simulation did not end cleanly): scan the complete chunks
+        offsets = []
+        pos = _align(_FILE_HEADER.size)
+        while pos + _CHUNK_HEADER.size <= size:
+            fields = _CHUNK_HEADER.unpack_from(self._mm, pos)
+            if fields[0] != b'NS3CHUNK':
+                break
+            end = max(o + s for o, s in zip(fields[2:8], fields[8:14]))
+            if pos + end > size:
+                break
+            offsets.append(pos)
+            pos = _align(pos + end)
+        return offsets
+
+    def __len__(self):
+        return sum(_CHUNK_HEADER.unpack_from(self._mm, pos)[1] for pos in self.chunkOffsets)
+
+    def chunk(self, i):
+        """Columns of the i-th chunk as dict of numpy arrays"""
+        pos = self.chunkOffsets[i]
+        fields = _CHUNK_HEADER.unpack_from(self._mm, pos)
+        rows = fields[1]
+        columns = {}
+        for c, name in enumerate(COLUMNS):
+            offset, size, rawSize = fields[2 + c], fields[8 + c], fields[14 + c]
+            start = pos + offset
+            if self.codec == CODEC_ZLIB and size:
+                buf = zlib.decompress(self._mm[start:start + size], 15, rawSize)
+                data = np.frombuffer(buf, dtype=self._dtypes[name])
+            else:
+                data = np.frombuffer(self._mm, dtype=self._dtypes[name], count=rawSize // self._dtypes[name].itemsize,
+                                     offset=start)
+            columns[name] = data.reshape((rows,) + self._shapes.get(name, ()))
+        return columns
+
+    def columns(self):
+        """All rows as dict of numpy arrays"""
+        if self._columns is None:
+            chunks = [self.chunk(i) for i in range(len(self.chunkOffsets))]
+            if len(chunks) == 1:
+                self._columns = chunks[0]
+            else:
+                self._columns = {name: np.concatenate([c[name] for c in chunks]) if chunks else
+                                 np.zeros((0,) + self._shapes.get(name, ()), dtype=self._dtypes[name])
+                                 for name in COLUMNS}
+        return self._columns
+
+    def episodes(self):
+        """Yield the episodes, per env in recording order, as dicts of columns; the last one of an env may be cut"""
+        columns = self.columns()
+        for env in np.unique(columns['env']):
+            rows = np.flatnonzero(columns['env'] == env)
+            ends = np.flatnonzero(columns['done'][rows]) + 1
+            for part in np.split(rows, ends):
+                if len(part):
+                    yield {name: column[part] for name, column in columns.items()}
+
+    def transitions(self):
+        """(obs, action, reward, next_obs, done) arrays for offline training"""
+        parts = []
+        for episode in self.episodes():
+            if len(episode['obs']) < 2:
+                continue
+            parts.append((episode['obs'][:-1], episode['action'][:-1], episode['reward'][1:],
+                          episode['obs'][1:], episode['done'][1:].astype(bool)))
+        if not parts:
+            return tuple(np.zeros((0,) + self._shapes.get(name, ()), dtype=self._dtypes[name])
+                         for name in ('obs', 'action', 'reward', 'obs', 'done'))
+        return tuple(np.concatenate(column) for column in zip(*parts))
+
+    def close(self):
+        self._columns = None
+        self._mm.close()
+
+
+class Ns3ReplayEnv(gym.Env):
+    """Gym env replaying recorded episodes, without ns-3 and SUMO.
+
+    The recorded trajectory is followed whatever the agent does (open loop); the action of
+    the recording is in info['recorded_action'], e.g. for behaviour cloning or off-policy
+    evaluation. Episodes are replayed in order, or randomly with shuffle=True."""
+
+    def __init__(self, path, shuffle=False):
+        self.dataset = TransitionDataset(path)
+        self.episodes = [e for e in self.dataset.episodes() if len(e['obs']) > 1]
+        if not self.episodes:
+            raise RuntimeError("No episode with more than one step in %s" % path)
+        self.shuffle = shuffle
+
+        self.observation_space = self._box(self.dataset.obsShape, self.dataset.obsDtype)
+        actions = np.concatenate([e['action'] for e in self.episodes])
+        if not self.dataset.actShape and self.dataset.actDtype.kind == 'u':
+            self.action_space = spaces.Discrete(int(actions.max()) + 1)
+        else:
+            self.action_space = self._box(self.dataset.actShape, self.dataset.actDtype)
+
+        self.seed()
+        self.episode = -1
+        self.t = 0
+
+    @staticmethod
+    def _box(shape, dtype):
+        if dtype.kind == 'f':
+            return spaces.Box(low=-np.inf, high=np.inf, shape=shape, dtype=dtype)
+        info = np.iinfo(dtype)
+        return spaces.Box(low=info.min, high=info.max, shape=shape, dtype=dtype)
+
+    def seed(self, seed=None):
+        self.np_random = np.random.RandomState(seed)
+        return [seed]
+
+    def reset(self):
+        if self.shuffle:
+            self.episode = self.np_random.randint(len(self.episodes))
+        else:
+            self.episode = (self.episode + 1) % len(self.episodes)
+        self.t = 0
+        return self.episodes[self.episode]['obs'][0]
+
+    def step(self, action):
+        episode = self.episodes[self.episode]
+        info = {'recorded_action': episode['action'][self.t]}
+        self.t += 1
+        done = bool(episode['done'][self.t]) or self.t == len(episode['obs']) - 1
+        return episode['obs'][self.t], float(episode['reward'][self.t]), done, info
+
+    def render(self, mode='human'):
+        return
+
+    def close(self):
+        self.episodes = []
+        self.dataset.close()
@@ -19,8 +19,11 @@
  *
  */
 
+#include <cstring>
 #include "ns3/log.h"
 #include "ns3/object.h"
+#include "ns3/uinteger.h"
+#include "ns3/enum.h"
 #include "opengym_env.h"
 #include "container.h"
 #include "spaces.h"
@@ -32,19 +35,86 @@ NS_OBJECT_ENSURE_REGISTERED (OpenGymEnv);
 
 NS_LOG_COMPONENT_DEFINE ("OpenGymEnv");
 
+namespace {
+// element types of the boxes CreateFromRawTensor can rebuild
+bool
+IsReducible (uint32_t dtype, uint32_t itemSize)
+{
+  return (dtype == ns3opengym::DOUBLE) ? itemSize == sizeof(double) : itemSize == sizeof(float);
+}
+
+template <typename T>
+double
+ReadItem (const uint8_t *data)
+{
+  T value;
+  std::memcpy(&value, data, sizeof(T));
+  return value;
+}
+
+template <typename T>
+void
+WriteItem (uint8_t *data, double value)
+{
+  T item = static_cast<T>(value);
+  std::memcpy(data, &item, sizeof(T));
+}
+
+double
+ReadElement (uint32_t dtype, const uint8_t *data)
+{
+  switch (dtype) {
+    case ns3opengym::INT: return ReadItem<int32_t>(data);
+    case ns3opengym::UINT: return ReadItem<uint32_t>(data);
+    case ns3opengym::DOUBLE: return ReadItem<double>(data);
+    default: return ReadItem<float>(data);
+  }
+}
+
+void
+WriteElement (uint32_t dtype, uint8_t *data, double value)
+{
+  switch (dtype) {
+    case ns3opengym::INT: WriteItem<int32_t>(data, value); break;
+    case ns3opengym::UINT: WriteItem<uint32_t>(data, value); break;
+    case ns3opengym::DOUBLE: WriteItem<double>(data, value); break;
+    default: WriteItem<float>(data, value); break;
+  }
+}
+}
+
 TypeId
 OpenGymEnv::GetTypeId (void)
 {
   static TypeId tid = TypeId ("ns3::OpenGymEnv")
     .SetParent<Object> ()
     .SetGroupName ("OpenGym")
+    .AddAttribute ("FrameSkip",
+                   "Notifications per step: the agent is asked every FrameSkip-th notification (or at game over), "
+                   "the last action is repeated on the notifications in between.",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&OpenGymEnv::m_frameSkip),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("FrameReduction",
+                   "How the observations of the skipped frames are combined: Last, element-wise Mean or Sum, or "
+                   "Stack along a new first axis. Rewards are averaged for Mean, the last one for Last, and summed "
+                   "otherwise. Only box observations are combined; anything else is sent as Last.",
+                   EnumValue (OpenGymEnv::FRAME_LAST),
+                   MakeEnumAccessor (&OpenGymEnv::m_frameReduction),
+                   MakeEnumChecker (OpenGymEnv::FRAME_LAST, "Last",
+                                    OpenGymEnv::FRAME_MEAN, "Mean",
+                                    OpenGymEnv::FRAME_SUM, "Sum",
+                                    OpenGymEnv::FRAME_STACK, "Stack"))
     ;
   return tid;
 }
 
 OpenGymEnv::OpenGymEnv()
+  : m_cachedFields(0), m_validFields(0), m_evaluatedFields(0), m_cachedReward(0.0), m_cachedGameOver(false),
+    m_frameSkip(1), m_frameReduction(FRAME_LAST)
 {
   NS_LOG_FUNCTION (this);
+  ResetFrames();
 }
 
 OpenGymEnv::~OpenGymEnv ()
@@ -56,6 +126,11 @@ void
 OpenGymEnv::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  m_frameObs = 0;
+  m_lastAction = 0;
+  m_cachedObs = 0;
+  m_actionSpace = 0;
+  m_observationSpace = 0;
 }
 
 void
@@ -69,23 +144,50 @@ OpenGymEnv::SetOpenGymInterface(Ptr<OpenGymInterface> openGymInterface)
 {
   NS_LOG_FUNCTION (this);
   m_openGymInterface = openGymInterface;
-  openGymInterface->SetGetActionSpaceCb( MakeCallback (&OpenGymEnv::GetActionSpace, this) );
-  openGymInterface->SetGetObservationSpaceCb( MakeCallback (&OpenGymEnv::GetObservationSpace, this) );
-  openGymInterface->SetGetGameOverCb( MakeCallback (&OpenGymEnv::GetGameOver, this) );
-  openGymInterface->SetGetObservationCb( MakeCallback (&OpenGymEnv::GetObservation, this) );
-  openGymInterface->SetGetRewardCb( MakeCallback (&OpenGymEnv::GetReward, this) );
-  openGymInterface->SetGetExtraInfoCb( MakeCallback (&OpenGymEnv::GetExtraInfo, this) );
-  openGymInterface->SetExecuteActionsCb( MakeCallback (&OpenGymEnv::ExecuteActions, this) );
+  openGymInterface->SetGetActionSpaceCb( MakeCallback (&OpenGymEnv::GetStepActionSpace, this) );
+  openGymInterface->SetGetObservationSpaceCb( MakeCallback (&OpenGymEnv::GetStepObservationSpace, this) );
+  openGymInterface->SetGetGameOverCb( MakeCallback (&OpenGymEnv::GetStepGameOver, this) );
+  openGymInterface->SetGetObservationCb( MakeCallback (&OpenGymEnv::GetStepObservation, this) );
+  openGymInterface->SetGetRewardCb( MakeCallback (&OpenGymEnv::GetStepReward, this) );
+  openGymInterface->SetGetExtraInfoCb( MakeCallback (&OpenGymEnv::GetStepExtraInfo, this) );
+  openGymInterface->SetExecuteActionsCb( MakeCallback (&OpenGymEnv::ExecuteStepActions, this) );
+  openGymInterface->SetGetChangedFieldsCb( MakeCallback (&OpenGymEnv::GetStepChangedFields, this) );
+}
+
+void
+OpenGymEnv::AddToOpenGymInterface(Ptr<OpenGymInterface> openGymInterface)
+{
+  NS_LOG_FUNCTION (this);
+  m_openGymInterface = openGymInterface;
+  uint32_t id = openGymInterface->AddEnv(this);
+  NS_LOG_DEBUG("Env " << this << " has id " << id);
 }
 
 void
 OpenGymEnv::Notify()
 {
   NS_LOG_FUNCTION (this);
-  if (m_openGymInterface)
+  if (!m_openGymInterface)
   {
-    m_openGymInterface->Notify(this);
+    return;
   }
+
+  if (m_frameSkip > 1)
+  {
+    AddFrame();
+    if (m_frameCount < m_frameSkip && !m_frameGameOver)
+    {
+      // no step on this frame, the last action stays in effect
+      if (m_lastAction)
+      {
+        ExecuteActions(m_lastAction);
+      }
+      return;
+    }
+  }
+  m_openGymInterface->Notify(this);
+  ResetFrames();
+  m_evaluatedFields = 0;
 }
 
 void
@@ -98,4 +200,312 @@ OpenGymEnv::NotifySimulationEnd()
   }
 }
 
-}
\ No newline at end of file
+void
+OpenGymEnv::ResetFrames()
+{
+  m_frameCount = 0;
+  m_frameObs = 0;
+  m_frameReward = 0.0;
+  m_frameRewardSum = 0.0;
+  m_frameGameOver = false;
+  m_frameInfo.clear();
+  m_frameReducible = true;
+  m_frameData.clear();
+}
+
+void
+OpenGymEnv::SetCachedFields(uint32_t fields)
+{
+  NS_LOG_FUNCTION (this << fields);
+  m_cachedFields = fields & ALL_FIELDS;
+  m_validFields &= m_cachedFields;
+}
+
+void
+OpenGymEnv::MarkFieldsChanged(uint32_t fields)
+{
+  NS_LOG_FUNCTION (this << fields);
+  m_validFields &= ~fields;
+}
+
+uint32_t
+OpenGymEnv::GetStepChangedFields()
+{
+  return m_evaluatedFields;
+}
+
+Ptr<OpenGymDataContainer>
+OpenGymEnv::EvalObservation()
+{
+  if (!(m_cachedFields & OBSERVATION))
+  {
+    m_evaluatedFields |= OBSERVATION;
+    return GetObservation();
+  }
+  if (!(m_validFields & OBSERVATION))
+  {
+    m_cachedObs = GetObservation();
+    m_validFields |= OBSERVATION;
+    m_evaluatedFields |= OBSERVATION;
+  }
+  return m_cachedObs;
+}
+
+float
+OpenGymEnv::EvalReward()
+{
+  if (!(m_cachedFields & REWARD))
+  {
+    m_evaluatedFields |= REWARD;
+    return GetReward();
+  }
+  if (!(m_validFields & REWARD))
+  {
+    m_cachedReward = GetReward();
+    m_validFields |= REWARD;
+    m_evaluatedFields |= REWARD;
+  }
+  return m_cachedReward;
+}
+
+bool
+OpenGymEnv::EvalGameOver()
+{
+  if (!(m_cachedFields & GAME_OVER))
+  {
+    m_evaluatedFields |= GAME_OVER;
+    return GetGameOver();
+  }
+  if (!(m_validFields & GAME_OVER))
+  {
+    m_cachedGameOver = GetGameOver();
+    m_validFields |= GAME_OVER;
+    m_evaluatedFields |= GAME_OVER;
+  }
+  return m_cachedGameOver;
+}
+
+std::string
+OpenGymEnv::EvalExtraInfo()
+{
+  if (!(m_cachedFields & EXTRA_INFO))
+  {
+    m_evaluatedFields |= EXTRA_INFO;
+    return GetExtraInfo();
+  }
+  if (!(m_validFields & EXTRA_INFO))
+  {
+    m_cachedInfo = GetExtraInfo();
+    m_validFields |= EXTRA_INFO;
+    m_evaluatedFields |= EXTRA_INFO;
+  }
+  return m_cachedInfo;
+}
+
+void
+OpenGymEnv::AddFrame()
+{
+  NS_LOG_FUNCTION (this);
+  m_frameObs = EvalObservation();
+  m_frameReward = EvalReward();
+  m_frameRewardSum += m_frameReward;
+  m_frameGameOver = EvalGameOver() || m_frameGameOver;
+  m_frameInfo = EvalExtraInfo();
+  ++m_frameCount;
+
+  if (m_frameReduction == FRAME_LAST || !m_frameReducible)
+  {
+    return;
+  }
+
+  // boxes are combined on their raw data, which needs no knowledge of the element type of the container
+  ns3opengym::RawTensor header;
+  const uint8_t *data = nullptr;
+  size_t size = 0;
+  bool reducible = m_frameObs && m_frameObs->GetRawTensor(header, data, size)
+                   && IsReducible(header.dtype(), header.itemsize());
+  if (reducible && m_frameCount > 1)
+  {
+    reducible = uint32_t(header.dtype()) == m_frameDtype && header.itemsize() == m_frameItemSize
+                && size == m_frameSum.size() * m_frameItemSize;
+  }
+  if (!reducible)
+  {
+    NS_LOG_WARN("Observation of frame " << m_frameCount << " can not be combined, the last one is sent");
+    m_frameReducible = false;
+    return;
+  }
+
+  if (m_frameCount == 1)
+  {
+    m_frameDtype = header.dtype();
+    m_frameItemSize = header.itemsize();
+    m_frameShape.assign(header.shape().begin(), header.shape().end());
+    m_frameSum.assign(size / m_frameItemSize, 0.0);
+  }
+  if (m_frameReduction == FRAME_STACK)
+  {
+    m_frameData.insert(m_frameData.end(), data, data + size);
+  }
+  else
+  {
+    for (size_t i = 0; i < m_frameSum.size(); ++i)
+    {
+      m_frameSum[i] += ReadElement(m_frameDtype, data + i * m_frameItemSize);
+    }
+  }
+}
+
+Ptr<OpenGymSpace>
+OpenGymEnv::GetStepActionSpace()
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_actionSpace)
+  {
+    m_actionSpace = GetActionSpace();
+  }
+  return m_actionSpace;
+}
+
+Ptr<OpenGymSpace>
+OpenGymEnv::GetStepObservationSpace()
+{
+  NS_LOG_FUNCTION (this);
+  if (m_observationSpace)
+  {
+    return m_observationSpace;
+  }
+
+  m_observationSpace = GetObservationSpace();
+  Ptr<OpenGymBoxSpace> box = DynamicCast<OpenGymBoxSpace>(m_observationSpace);
+  if (m_frameSkip <= 1 || !box)
+  {
+    return m_observationSpace;
+  }
+
+  std::vector<uint32_t> shape = box->GetShape();
+  if (m_frameReduction == FRAME_STACK && !shape.empty())
+  {
+    shape.insert(shape.begin(), m_frameSkip);
+    m_observationSpace = CreateObject<OpenGymBoxSpace>(box->GetLow(), box->GetHigh(), shape, box->GetDtypeName());
+  }
+  else if (m_frameReduction == FRAME_SUM)
+  {
+    m_observationSpace = CreateObject<OpenGymBoxSpace>(box->GetLow() * m_frameSkip, box->GetHigh() * m_frameSkip, shape, box->GetDtypeName());
+  }
+  return m_observationSpace;
+}
+
+Ptr<OpenGymDataContainer>
+OpenGymEnv::GetStepObservation()
+{
+  NS_LOG_FUNCTION (this);
+  if (m_frameSkip <= 1)
+  {
+    return EvalObservation();
+  }
+  // e.g. the final state at the simulation end
+  if (m_frameCount == 0)
+  {
+    AddFrame();
+  }
+  if (m_frameReduction == FRAME_LAST || !m_frameReducible)
+  {
+    return m_frameObs;
+  }
+
+  ns3opengym::RawTensor header;
+  header.set_dtype(static_cast<ns3opengym::Dtype>(m_frameDtype));
+  header.set_itemsize(m_frameItemSize);
+  if (m_frameReduction == FRAME_STACK)
+  {
+    // a step cut short by game over repeats its last frame, the shape stays the one of the space
+    size_t frameSize = m_frameSum.size() * m_frameItemSize;
+    m_frameBuffer.assign(m_frameData.begin(), m_frameData.end());
+    for (uint32_t i = m_frameCount; i < m_frameSkip; ++i)
+    {
+      m_frameBuffer.insert(m_frameBuffer.end(), m_frameData.end() - frameSize, m_frameData.end());
+    }
+    header.add_shape(m_frameSkip);
+  }
+  else
+  {
+    double scale = (m_frameReduction == FRAME_MEAN) ? 1.0 / m_frameCount : 1.0;
+    m_frameBuffer.resize(m_frameSum.size() * m_frameItemSize);
+    for (size_t i = 0; i < m_frameSum.size(); ++i)
+    {
+      WriteElement(m_frameDtype, m_frameBuffer.data() + i * m_frameItemSize, m_frameSum[i] * scale);
+    }
+  }
+  for (uint32_t dim : m_frameShape)
+  {
+    header.add_shape(dim);
+  }
+  return OpenGymDataContainer::CreateFromRawTensor(header, m_frameBuffer.data(), m_frameBuffer.size());
+}
+
+float
+OpenGymEnv::GetStepReward()
+{
+  NS_LOG_FUNCTION (this);
+  if (m_frameSkip <= 1)
+  {
+    return EvalReward();
+  }
+  if (m_frameCount == 0)
+  {
+    AddFrame();
+  }
+  if (m_frameReduction == FRAME_LAST)
+  {
+    return m_frameReward;
+  }
+  else if (m_frameReduction == FRAME_MEAN)
+  {
+    return m_frameRewardSum / m_frameCount;
+  }
+  return m_frameRewardSum;
+}
+
+bool
+OpenGymEnv::GetStepGameOver()
+{
+  NS_LOG_FUNCTION (this);
+  if (m_frameSkip <= 1)
+  {
+    return EvalGameOver();
+  }
+  if (m_frameCount == 0)
+  {
+    AddFrame();
+  }
+  return m_frameGameOver;
+}
+
+std::string
+OpenGymEnv::GetStepExtraInfo()
+{
+  NS_LOG_FUNCTION (this);
+  if (m_frameSkip <= 1)
+  {
+    return EvalExtraInfo();
+  }
+  if (m_frameCount == 0)
+  {
+    AddFrame();
+  }
+  return m_frameInfo;
+}
+
+bool
+OpenGymEnv::ExecuteStepActions(Ptr<OpenGymDataContainer> action)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_frameSkip > 1)
+  {
+    m_lastAction = action;
+  }
+  return ExecuteActions(action);
+}
+
+}
@@ -23,6 +23,7 @@
 #define OPENGYM_ENV_H
 
 #include "ns3/object.h"
+#include <vector>
 
 namespace ns3 {
 
@@ -33,6 +34,25 @@ class OpenGymInterface;
 class OpenGymEnv : public Object
 {
 public:
+  // frame skip: how the observations of the frames between two steps become the observation of the step
+  enum FrameReduction
+  {
+    FRAME_LAST,     // observation of the last frame
+    FRAME_MEAN,     // element-wise mean of box observations
+    FRAME_SUM,      // element-wise sum of box observations
+    FRAME_STACK     // box observations stacked along a new first axis of size FrameSkip
+  };
+
+  // fields of the env state, as bit mask
+  enum StateField
+  {
+    OBSERVATION = 1,
+    REWARD = 2,
+    GAME_OVER = 4,
+    EXTRA_INFO = 8,
+    ALL_FIELDS = 15
+  };
+
   OpenGymEnv ();
   virtual ~OpenGymEnv ();
 
@@ -49,18 +69,75 @@ public:
   virtual bool ExecuteActions(Ptr<OpenGymDataContainer> action) = 0;
 
   void SetOpenGymInterface(Ptr<OpenGymInterface> openGymInterface);
+  // step together with the other envs of the interface (vectorized env)
+  void AddToOpenGymInterface(Ptr<OpenGymInterface> openGymInterface);
   void Notify();
   void NotifySimulationEnd();
 
+  // state of a step as the interface sends it; with FrameSkip > 1 reduced over the frames since the last step
+  Ptr<OpenGymSpace> GetStepActionSpace();
+  Ptr<OpenGymSpace> GetStepObservationSpace();
+  Ptr<OpenGymDataContainer> GetStepObservation();
+  float GetStepReward();
+  bool GetStepGameOver();
+  std::string GetStepExtraInfo();
+  // the action is repeated on the frames until the next step
+  bool ExecuteStepActions(Ptr<OpenGymDataContainer> action);
+  // fields evaluated for the current step; cached fields that did not change are not, and the interface omits them
+  uint32_t GetStepChangedFields();
 
 protected:
   // Inherited
   virtual void DoInitialize (void);
   virtual void DoDispose (void);
 
+  // the fields in the mask are evaluated once and then only after MarkFieldsChanged, e.g. a constant extra info
+  void SetCachedFields(uint32_t fields);
+  void MarkFieldsChanged(uint32_t fields);
+
   Ptr<OpenGymInterface> m_openGymInterface;
 private:
+  void AddFrame();
+  void ResetFrames();
+
+  // env callbacks behind the cache of the fields declared with SetCachedFields
+  Ptr<OpenGymDataContainer> EvalObservation();
+  float EvalReward();
+  bool EvalGameOver();
+  std::string EvalExtraInfo();
+
+  uint32_t m_cachedFields;
+  uint32_t m_validFields;       // cached fields that are up to date
+  uint32_t m_evaluatedFields;   // fields evaluated since the last step
+  Ptr<OpenGymDataContainer> m_cachedObs;
+  float m_cachedReward;
+  bool m_cachedGameOver;
+  std::string m_cachedInfo;
+  // spaces are asked once
+  Ptr<OpenGymSpace> m_actionSpace;
+  Ptr<OpenGymSpace> m_observationSpace;
+
+  uint32_t m_frameSkip;
+  FrameReduction m_frameReduction;
+
+  // frames since the last step
+  uint32_t m_frameCount;
+  Ptr<OpenGymDataContainer> m_frameObs;
+  float m_frameReward;
+  float m_frameRewardSum;
+  bool m_frameGameOver;
+  std::string m_frameInfo;
+  // box observations of the frames as element-wise sum or stacked raw data; false if one of them is no box
+  // of the same dtype and size, then the last observation is sent
+  bool m_frameReducible;
+  uint32_t m_frameDtype;
+  uint32_t m_frameItemSize;
+  std::vector<uint32_t> m_frameShape;
+  std::vector<double> m_frameSum;
+  std::vector<uint8_t> m_frameData;
+  std::vector<uint8_t> m_frameBuffer;
 
+  Ptr<OpenGymDataContainer> m_lastAction;
 };
 
 } // end of namespace ns3
@@ -21,13 +21,22 @@
 
 #include <sys/types.h>
 #include <unistd.h>
+#include <algorithm>
 #include "ns3/log.h"
+#include "ns3/abort.h"
 #include "ns3/config.h"
 #include "ns3/simulator.h"
+#include "ns3/boolean.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/nstime.h"
 #include "opengym_interface.h"
 #include "opengym_env.h"
 #include "container.h"
 #include "spaces.h"
+#include "opengym_shm.h"
+#include "opengym_step_log.h"
+#include "opengym_transition_recorder.h"
 #include "messages.pb.h"
 
 namespace ns3 {
@@ -44,6 +53,50 @@ OpenGymInterface::GetTypeId (void)
     .SetParent<Object> ()
     .SetGroupName ("OpenGym")
     .AddConstructor<OpenGymInterface> ()
+    .AddAttribute ("RawTensor",
+                   "Send box observations as compact header plus contiguous little-endian data frame (zero-copy) "
+                   "instead of protobuf repeated fields. Other observations are sent as before.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&OpenGymInterface::m_rawTensor),
+                   MakeBooleanChecker ())
+    .AddAttribute ("Transport",
+                   "Exchange observations and actions via zmq (Zmq), or via preallocated shared memory slots with "
+                   "semaphore signalling (SharedMemory; agent on the same host). The handshake always uses zmq.",
+                   EnumValue (OpenGymInterface::ZMQ_TRANSPORT),
+                   MakeEnumAccessor (&OpenGymInterface::m_transport),
+                   MakeEnumChecker (OpenGymInterface::ZMQ_TRANSPORT, "Zmq",
+                                    OpenGymInterface::SHM_TRANSPORT, "SharedMemory"))
+    .AddAttribute ("SharedMemorySlotSize",
+                   "Bytes per shared memory slot; the largest observation or action plus extra info has to fit.",
+                   UintegerValue (1 << 20),
+                   MakeUintegerAccessor (&OpenGymInterface::m_shmSlotSize),
+                   MakeUintegerChecker<uint32_t> (1024))
+    .AddAttribute ("SharedMemorySpin",
+                   "Polls of the action semaphore before blocking on it; trades cpu time for wake up latency.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&OpenGymInterface::m_shmSpin),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Async",
+                   "Do not block the simulation while the agent computes its action: the state is sent and the "
+                   "simulation goes on, the action is applied at the first poll after it arrived. Single env with "
+                   "the Zmq transport only; the final state at the simulation end is still exchanged in lockstep.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&OpenGymInterface::m_async),
+                   MakeBooleanChecker ())
+    .AddAttribute ("AsyncPollInterval",
+                   "Simulated time between two checks for arrived actions while states are in flight.",
+                   TimeValue (MilliSeconds (1)),
+                   MakeTimeAccessor (&OpenGymInterface::m_asyncPollInterval),
+                   MakeTimeChecker (TimeStep (1)))
+    .AddAttribute ("AsyncMaxPending",
+                   "States sent to the agent and not answered yet; further states are dropped until an action arrived.",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&OpenGymInterface::m_asyncMaxPending),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddTraceSource ("ActionLatency",
+                     "Simulated time between sending a state and applying the action of the agent (async mode).",
+                     MakeTraceSourceAccessor (&OpenGymInterface::m_actionLatencyTrace),
+                     "ns3::Time::TracedCallback")
     ;
   return tid;
 }
@@ -55,16 +108,39 @@ OpenGymInterface::Get (uint32_t port)
   return *DoGet (port);
 }
 
+std::map<uint32_t, Ptr<OpenGymInterface> > &
+OpenGymInterface::GetInstances (void)
+{
+  static std::map<uint32_t, Ptr<OpenGymInterface> > instances;
+  return instances;
+}
+
 Ptr<OpenGymInterface> *
 OpenGymInterface::DoGet (uint32_t port)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  static Ptr<OpenGymInterface> ptr = 0;
+  // port of the interface created first, for Get () without port
+  static uint32_t defaultPort = 0;
+  std::map<uint32_t, Ptr<OpenGymInterface> > &instances = GetInstances ();
+  if (instances.empty ())
+    {
+      defaultPort = 0;
+    }
+  if (port == 0)
+    {
+      port = defaultPort ? defaultPort : 5555;
+    }
+
+  Ptr<OpenGymInterface> &ptr = instances[port];
   if (ptr == 0)
     {
+      if (instances.size () == 1)
+        {
+          defaultPort = port;
+          Simulator::ScheduleDestroy (&OpenGymInterface::Delete);
+        }
       ptr = CreateObject<OpenGymInterface> (port);
       Config::RegisterRootNamespaceObject (ptr);
-      Simulator::ScheduleDestroy (&OpenGymInterface::Delete);
     }
   return &ptr;
 }
@@ -73,15 +149,28 @@ void
 OpenGymInterface::Delete (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  Config::UnregisterRootNamespaceObject (Get ());
-  (*DoGet ()) = 0;
+  std::map<uint32_t, Ptr<OpenGymInterface> > &instances = GetInstances ();
+  for (std::map<uint32_t, Ptr<OpenGymInterface> >::iterator it = instances.begin (); it != instances.end (); ++it)
+    {
+      Config::UnregisterRootNamespaceObject (it->second);
+      // envs and interface reference each other
+      it->second->Dispose ();
+    }
+  instances.clear ();
 }
 
 OpenGymInterface::OpenGymInterface(uint32_t port):
   m_port(port), m_zmq_context(1), m_zmq_socket(m_zmq_context, ZMQ_REQ),
-  m_simEnd(false), m_stopEnvRequested(false), m_initSimMsgSent(false)
+  m_simEnd(false), m_stopEnvRequested(false), m_initSimMsgSent(false), m_rawTensor(false), m_infoSent(false),
+  m_async(false), m_asyncPollInterval(MilliSeconds(1)), m_asyncMaxPending(1), m_asyncDropped(0),
+  m_transport(ZMQ_TRANSPORT), m_shmSlotSize(1 << 20), m_shmSpin(0)
 {
   NS_LOG_FUNCTION (this);
+  m_stepLog = CreateObject<OpenGymStepLog>();
+  m_recorder = CreateObject<OpenGymTransitionRecorder>();
+  m_arena.reset(new google::protobuf::Arena());
+  m_envStateMsg = google::protobuf::Arena::CreateMessage<ns3opengym::EnvStateMsg>(m_arena.get());
+  m_envStateBatchMsg = google::protobuf::Arena::CreateMessage<ns3opengym::EnvStateBatchMsg>(m_arena.get());
 }
 
 OpenGymInterface::~OpenGymInterface ()
@@ -93,6 +182,62 @@ void
 OpenGymInterface::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  m_rawTensorObs = 0;
+  m_sentObs = 0;
+  m_asyncPollEvent.Cancel();
+  // flushes what is still buffered
+  m_stepLog->Dispose();
+  m_recorder->Dispose();
+  m_shm.reset();
+  m_envs.clear();
+  m_batchKeptObs.clear();
+  m_scratchArena.reset();
+}
+
+void
+OpenGymInterface::KeepBuffer (void *data, void *hint)
+{
+  // nothing to free: the data belongs to the send buffer or the last observation container
+}
+
+google::protobuf::Arena *
+OpenGymInterface::ResetScratchArena()
+{
+  // grow the initial block to what the last step needed; from then on every step fits into it
+  size_t used = m_scratchArena ? m_scratchArena->SpaceAllocated() : 0;
+  if (!m_scratchArena || used > m_scratchBlock.size()) {
+    m_scratchArena.reset();
+    m_scratchBlock.resize(std::max<size_t>(2 * used, 16 * 1024));
+    m_scratchArena.reset(new google::protobuf::Arena(m_scratchBlock.data(), m_scratchBlock.size()));
+  } else {
+    m_scratchArena->Reset();
+  }
+  return m_scratchArena.get();
+}
+
+template <typename M>
+void
+OpenGymInterface::SendMessage(const M &msg, int flags)
+{
+  size_t size = msg.ByteSizeLong();
+  if (m_async) {
+    // empty delimiter frame expected by the REP socket of the agent; the next message may be sent before the agent
+    // replied, so the data is copied into the frame
+    zmq::message_t delimiter;
+    m_zmq_socket.send (delimiter, ZMQ_SNDMORE);
+    zmq::message_t request(size);
+    msg.SerializeWithCachedSizesToArray(static_cast<uint8_t*>(request.data()));
+    m_zmq_socket.send (request, flags);
+    return;
+  }
+
+  // the buffer is reused for the next message, which is built only after the agent replied to this one
+  if (m_sendBuffer.size() < size) {
+    m_sendBuffer.resize(size);
+  }
+  msg.SerializeWithCachedSizesToArray(m_sendBuffer.data());
+  zmq::message_t request(m_sendBuffer.data(), size, &OpenGymInterface::KeepBuffer, nullptr);
+  m_zmq_socket.send (request, flags);
 }
 
 void
@@ -150,6 +295,13 @@ OpenGymInterface::SetExecuteActionsCb(Callback<bool, Ptr<OpenGymDataContainer> >
   m_actionCb = cb;
 }
 
+void
+OpenGymInterface::SetGetChangedFieldsCb(Callback<uint32_t> cb)
+{
+  NS_LOG_FUNCTION (this);
+  m_changedFieldsCb = cb;
+}
+
 void 
 OpenGymInterface::Init()
 {
@@ -160,11 +312,33 @@ OpenGymInterface::Init()
   }
   m_initSimMsgSent = true;
 
+  if (m_async) {
+    NS_ABORT_MSG_IF(m_transport != ZMQ_TRANSPORT || !m_envs.empty(), "Async mode is only supported for a single env with the Zmq transport");
+    // unlike REQ, a DEALER socket may send the next state before the reply to the last one arrived
+    m_zmq_socket.close();
+    m_zmq_socket = zmq::socket_t(m_zmq_context, ZMQ_DEALER);
+    if (m_recorder->IsEnabled()) {
+      // the action answering a state is not known when the state is sent
+      NS_LOG_WARN("Transitions are not recorded in async mode");
+      m_recorder->Close();
+    }
+  }
+
   std::string connectAddr = "tcp://localhost:" + std::to_string(m_port);
   zmq_connect ((void*)m_zmq_socket, connectAddr.c_str());
 
-  Ptr<OpenGymSpace> obsSpace = GetObservationSpace();
-  Ptr<OpenGymSpace> actionSpace = GetActionSpace();
+  Ptr<OpenGymSpace> obsSpace;
+  Ptr<OpenGymSpace> actionSpace;
+  if (m_envs.empty()) {
+    obsSpace = GetObservationSpace();
+    actionSpace = GetActionSpace();
+  } else {
+    NS_ABORT_MSG_IF(m_transport != ZMQ_TRANSPORT, "Batched envs are only supported with the Zmq transport");
+    obsSpace = m_envs[0].env->GetStepObservationSpace();
+    actionSpace = m_envs[0].env->GetActionSpace();
+  }
+
+  m_stepLog->Open("opengym-steps-" + std::to_string(::getpid()) + "-" + std::to_string(m_port) + ".bin");
 
   NS_LOG_UNCOND("Simulation process id: " << ::getpid() << " (parent (waf shell) id: " << ::getppid() << ")");
   NS_LOG_UNCOND("Waiting for Python process to connect on port: "<< connectAddr);
@@ -173,6 +347,15 @@ OpenGymInterface::Init()
   ns3opengym::SimInitMsg simInitMsg;
   simInitMsg.set_simprocessid(::getpid());
   simInitMsg.set_wafshellprocessid(::getppid());
+  simInitMsg.set_rawtensor(m_rawTensor);
+  simInitMsg.set_numenvs(m_envs.size());
+
+  if (m_transport == SHM_TRANSPORT) {
+    m_shm.reset(new OpenGymShmChannel());
+    m_shm->Create(m_port, m_shmSlotSize, m_shmSpin);
+    simInitMsg.set_shmname(m_shm->GetName());
+    simInitMsg.set_shmsize(m_shm->GetSize());
+  }
 
   if (obsSpace) {
     ns3opengym::SpaceDescription spaceDesc;
@@ -187,6 +370,10 @@ OpenGymInterface::Init()
   }
 
   // send init msg to python
+  if (m_async) {
+    zmq::message_t delimiter;
+    m_zmq_socket.send (delimiter, ZMQ_SNDMORE);
+  }
   zmq::message_t request(simInitMsg.ByteSize());;
   simInitMsg.SerializeToArray(request.data(), simInitMsg.ByteSize());
   m_zmq_socket.send (request);
@@ -194,22 +381,35 @@ OpenGymInterface::Init()
   // receive init ack msg form python
   ns3opengym::SimInitAck simInitAck;
   zmq::message_t reply;
-  m_zmq_socket.recv (&reply);
+  ReceiveReply(reply);
   simInitAck.ParseFromArray(reply.data(), reply.size());
 
   bool done = simInitAck.done();
   NS_LOG_DEBUG("Sim Init Ack: " << done);
 
+  // the agent has mapped the shared memory before the ack; nothing is left behind if one side crashes
+  if (m_shm) {
+    m_shm->Unlink();
+    m_shm->SetAgentPid(simInitAck.agentprocessid());
+  }
+
   bool stopSim = simInitAck.stopsimreq();
   if (stopSim) {
     NS_LOG_DEBUG("---Stop requested: " << stopSim);
-    m_stopEnvRequested = true;
-    Simulator::Stop();
-    Simulator::Destroy ();
-    std::exit(0);
+    StopSimulation();
   }
 }
 
+void
+OpenGymInterface::StopSimulation()
+{
+  NS_LOG_FUNCTION (this);
+  m_stopEnvRequested = true;
+  Simulator::Stop();
+  Simulator::Destroy ();
+  std::exit(0);
+}
+
 void
 OpenGymInterface::NotifyCurrentState()
 {
@@ -228,61 +428,258 @@ OpenGymInterface::NotifyCurrentState()
   float reward = GetReward();
   bool isGameOver = IsGameOver();
   std::string extraInfo = GetExtraInfo();
+  uint32_t changedFields = m_changedFieldsCb.IsNull() ? uint32_t(OpenGymEnv::ALL_FIELDS) : m_changedFieldsCb();
+  m_stepLog->BeginStep();
+  m_stepLog->LogState(0, obsDataContainer, reward, isGameOver, extraInfo);
+
+  if (m_async && !m_simEnd) {
+    NotifyAsync(obsDataContainer, reward, isGameOver, extraInfo, changedFields);
+    return;
+  }
+
+  // exchange state and action with the agent
+  bool stopSim = false;
+  Ptr<OpenGymDataContainer> actDataContainer;
+  if (m_async) {
+    // the final state is answered last, after the states still in flight
+    DrainActions();
+  }
+  if (m_shm) {
+    m_shm->SendState(obsDataContainer, reward, isGameOver, m_simEnd, extraInfo);
+    m_shm->ReceiveAction(stopSim, actDataContainer);
+  } else {
+    actDataContainer = ExchangeZmq(obsDataContainer, reward, isGameOver, extraInfo, changedFields, stopSim);
+  }
+
+  if (m_simEnd) {
+    // if sim end only rx ms and quit
+    m_recorder->Record(0, obsDataContainer, nullptr, reward, true);
+    return;
+  }
+
+  if (stopSim) {
+    NS_LOG_DEBUG("---Stop requested: " << stopSim);
+    StopSimulation();
+  }
+
+  // first step after reset is called without actions, just to get current state
+  m_stepLog->LogAction(0, actDataContainer);
+  m_recorder->Record(0, obsDataContainer, actDataContainer, reward, isGameOver);
+  ExecuteActions(actDataContainer);
+
+}
+
+Ptr<OpenGymDataContainer>
+OpenGymInterface::ExchangeZmq(Ptr<OpenGymDataContainer> obsDataContainer, float reward, bool isGameOver, const std::string &extraInfo, uint32_t changedFields, bool &stopSim)
+{
+  NS_LOG_FUNCTION (this);
+  SendStateZmq(obsDataContainer, reward, isGameOver, extraInfo, changedFields);
+  Ptr<OpenGymDataContainer> actDataContainer;
+  ReceiveActionZmq(0, stopSim, actDataContainer);
+  return actDataContainer;
+}
+
+void
+OpenGymInterface::SendStateZmq(Ptr<OpenGymDataContainer> obsDataContainer, float reward, bool isGameOver, const std::string &extraInfo, uint32_t changedFields)
+{
+  NS_LOG_FUNCTION (this);
 
-  ns3opengym::EnvStateMsg envStateMsg;
-  // observation
-  ns3opengym::DataContainer obsDataContainerPbMsg;
-  if (obsDataContainer) {
-    obsDataContainerPbMsg = obsDataContainer->GetDataContainerPbMsg();
-    envStateMsg.mutable_obsdata()->CopyFrom(obsDataContainerPbMsg);
+  google::protobuf::Arena *arena = ResetScratchArena();
+  // reused message: every field is overwritten, Clear() would drop the sub messages and their buffers
+  ns3opengym::EnvStateMsg *envStateMsg = m_envStateMsg;
+  // a cached observation the agent already got is not filled and sent again
+  bool obsUnchanged = obsDataContainer && obsDataContainer == m_sentObs && !(changedFields & OpenGymEnv::OBSERVATION);
+  // observation; a box goes as raw tensor frame after the message in raw tensor mode
+  const uint8_t *rawData = nullptr;
+  size_t rawSize = 0;
+  bool rawTensor = false;
+  if (obsUnchanged) {
+    // the sub messages keep the last observation, they are detached while sending
+  } else if (m_rawTensor && obsDataContainer) {
+    ns3opengym::RawTensor *tensor = envStateMsg->mutable_obstensor();
+    tensor->Clear();
+    rawTensor = obsDataContainer->GetRawTensor(*tensor, rawData, rawSize);
+  }
+  if (rawTensor) {
+    if (envStateMsg->has_obsdata()) {
+      envStateMsg->clear_obsdata();
+    }
+    // the wire format is little-endian
+    const uint16_t one = 1;
+    if (*reinterpret_cast<const uint8_t*>(&one) != 1) {
+      size_t itemSize = envStateMsg->obstensor().itemsize();
+      m_rawTensorBuffer.resize(rawSize);
+      for (size_t i = 0; i < rawSize; i += itemSize) {
+        std::reverse_copy(rawData + i, rawData + i + itemSize, m_rawTensorBuffer.begin() + i);
+      }
+      rawData = m_rawTensorBuffer.data();
+    }
+  } else if (!obsUnchanged) {
+    // the sub messages only change when the kind of observation changes
+    if (envStateMsg->has_obstensor()) {
+      envStateMsg->clear_obstensor();
+    }
+    if (obsDataContainer) {
+      obsDataContainer->FillDataContainerPbMsg(*envStateMsg->mutable_obsdata(), arena);
+    } else if (envStateMsg->has_obsdata()) {
+      envStateMsg->clear_obsdata();
+    }
   }
   // reward
-  envStateMsg.set_reward(reward);
+  envStateMsg->set_reward(reward);
   // game over
-  envStateMsg.set_isgameover(false);
-  if (isGameOver)
-  {
-    envStateMsg.set_isgameover(true);
-    if (m_simEnd) {
-      envStateMsg.set_reason(ns3opengym::EnvStateMsg::SimulationEnd);
-    } else {
-      envStateMsg.set_reason(ns3opengym::EnvStateMsg::GameOver);
-    }
+  envStateMsg->set_isgameover(isGameOver);
+  if (isGameOver && !m_simEnd) {
+    envStateMsg->set_reason(ns3opengym::EnvStateMsg::GameOver);
+  } else {
+    envStateMsg->set_reason(ns3opengym::EnvStateMsg::SimulationEnd);
   }
 
-  // extra info
-  envStateMsg.set_info(extraInfo);
+  // extra info, omitted while it does not change
+  bool infoUnchanged = m_infoSent && extraInfo == m_sentInfo;
+  if (infoUnchanged) {
+    envStateMsg->mutable_info()->clear();
+  } else {
+    envStateMsg->set_info(extraInfo);
+    m_sentInfo = extraInfo;
+    m_infoSent = true;
+  }
+  envStateMsg->set_obsunchanged(obsUnchanged);
+  envStateMsg->set_infounchanged(infoUnchanged);
+  m_sentObs = obsDataContainer;
 
   // send env state msg to python
-  zmq::message_t request(envStateMsg.ByteSize());;
-  envStateMsg.SerializeToArray(request.data(), envStateMsg.ByteSize());
-  m_zmq_socket.send (request);
+  if (obsUnchanged) {
+    // detach the kept observation without copy or allocation (arena message)
+    ns3opengym::DataContainer *obsData = envStateMsg->unsafe_arena_release_obsdata();
+    ns3opengym::RawTensor *obsTensor = envStateMsg->unsafe_arena_release_obstensor();
+    SendMessage(*envStateMsg);
+    envStateMsg->unsafe_arena_set_allocated_obsdata(obsData);
+    envStateMsg->unsafe_arena_set_allocated_obstensor(obsTensor);
+  } else if (rawTensor && m_async) {
+    // the container may change before zmq sent the data, so it is copied
+    zmq::message_t tensor(rawData, rawSize);
+    SendMessage(*envStateMsg, ZMQ_SNDMORE);
+    m_zmq_socket.send (tensor);
+  } else if (rawTensor) {
+    // the data frame points into the container (zmq_msg_init_data), which is kept until the agent replied
+    m_rawTensorObs = obsDataContainer;
+    zmq::message_t tensor(const_cast<uint8_t*>(rawData), rawSize, &OpenGymInterface::KeepBuffer, nullptr);
+    SendMessage(*envStateMsg, ZMQ_SNDMORE);
+    m_zmq_socket.send (tensor);
+  } else {
+    SendMessage(*envStateMsg);
+  }
+}
+
+bool
+OpenGymInterface::ReceiveReply(zmq::message_t &reply, int flags)
+{
+  if (m_async) {
+    // strip the empty delimiter frame; the rest of a multipart message is there as soon as its first frame is
+    zmq::message_t delimiter;
+    if (!m_zmq_socket.recv (&delimiter, flags)) {
+      return false;
+    }
+    flags = 0;
+  }
+  return m_zmq_socket.recv (&reply, flags);
+}
+
+bool
+OpenGymInterface::ReceiveActionZmq(int flags, bool &stopSim, Ptr<OpenGymDataContainer> &action)
+{
+  NS_LOG_FUNCTION (this << flags);
 
   // receive act msg form python
-  ns3opengym::EnvActMsg envActMsg;
   zmq::message_t reply;
-  m_zmq_socket.recv (&reply);
-  envActMsg.ParseFromArray(reply.data(), reply.size());
+  if (!ReceiveReply(reply, flags)) {
+    return false;
+  }
 
-  if (m_simEnd) {
-    // if sim end only rx ms and quit
+  // parsing clears the message, so it lives on the scratch arena
+  google::protobuf::Arena *arena = ResetScratchArena();
+  ns3opengym::EnvActMsg *envActMsg = google::protobuf::Arena::CreateMessage<ns3opengym::EnvActMsg>(arena);
+  envActMsg->ParseFromArray(reply.data(), reply.size());
+
+  stopSim = envActMsg->stopsimreq();
+  action = OpenGymDataContainer::CreateFromDataContainerPbMsg(*envActMsg->mutable_actdata());
+  return true;
+}
+
+void
+OpenGymInterface::NotifyAsync(Ptr<OpenGymDataContainer> obsDataContainer, float reward, bool isGameOver, const std::string &extraInfo, uint32_t changedFields)
+{
+  NS_LOG_FUNCTION (this);
+
+  // actions that arrived meanwhile are applied before the new state is published
+  PollActions();
+  if (m_stopEnvRequested) {
     return;
   }
 
-  bool stopSim = envActMsg.stopsimreq();
-  if (stopSim) {
-    NS_LOG_DEBUG("---Stop requested: " << stopSim);
-    m_stopEnvRequested = true;
-    Simulator::Stop();
-    Simulator::Destroy ();
-    std::exit(0);
+  if (m_asyncSent.size() >= m_asyncMaxPending) {
+    // the agent is still busy; like an overloaded controller it never sees this state
+    ++m_asyncDropped;
+    NS_LOG_DEBUG("Agent busy with " << m_asyncSent.size() << " states, state dropped (" << m_asyncDropped << " so far)");
+    return;
   }
 
-  // first step after reset is called without actions, just to get current state
-  ns3opengym::DataContainer actDataContainerPbMsg = envActMsg.actdata();
-  Ptr<OpenGymDataContainer> actDataContainer = OpenGymDataContainer::CreateFromDataContainerPbMsg(actDataContainerPbMsg);
-  ExecuteActions(actDataContainer);
+  SendStateZmq(obsDataContainer, reward, isGameOver, extraInfo, changedFields);
+  m_asyncSent.push_back(std::make_pair(Simulator::Now(), m_stepLog->GetStep()));
+  if (!m_asyncPollEvent.IsRunning()) {
+    m_asyncPollEvent = Simulator::Schedule(m_asyncPollInterval, &OpenGymInterface::PollActions, this);
+  }
+}
+
+void
+OpenGymInterface::PollActions()
+{
+  NS_LOG_FUNCTION (this);
+
+  while (!m_asyncSent.empty()) {
+    bool stopSim = false;
+    Ptr<OpenGymDataContainer> actDataContainer;
+    if (!ReceiveActionZmq(ZMQ_DONTWAIT, stopSim, actDataContainer)) {
+      break;
+    }
+    Time latency = Simulator::Now() - m_asyncSent.front().first;
+    uint64_t step = m_asyncSent.front().second;
+    m_asyncSent.pop_front();
+    NS_LOG_DEBUG("Action applied " << latency.GetSeconds() << "s after its state was sent");
+    m_actionLatencyTrace(latency);
+
+    if (stopSim) {
+      NS_LOG_DEBUG("---Stop requested: " << stopSim);
+      StopSimulation();
+    }
+    // newer states may have been logged meanwhile; the action belongs to the step of its state
+    m_stepLog->LogAction(0, step, actDataContainer);
+    ExecuteActions(actDataContainer);
+  }
 
+  // poll again only while states are in flight, an idle agent does not keep the simulation alive
+  if (!m_asyncSent.empty() && !m_asyncPollEvent.IsRunning()) {
+    m_asyncPollEvent = Simulator::Schedule(m_asyncPollInterval, &OpenGymInterface::PollActions, this);
+  }
+}
+
+void
+OpenGymInterface::DrainActions()
+{
+  NS_LOG_FUNCTION (this);
+  m_asyncPollEvent.Cancel();
+  // the simulation is over, the actions are not applied anymore
+  while (!m_asyncSent.empty()) {
+    bool stopSim = false;
+    Ptr<OpenGymDataContainer> actDataContainer;
+    ReceiveActionZmq(0, stopSim, actDataContainer);
+    m_actionLatencyTrace(Simulator::Now() - m_asyncSent.front().first);
+    m_asyncSent.pop_front();
+  }
+  if (m_asyncDropped) {
+    NS_LOG_INFO("States dropped while the agent was busy: " << m_asyncDropped);
+  }
 }
 
 void
@@ -290,13 +687,21 @@ OpenGymInterface::WaitForStop()
 {
   NS_LOG_FUNCTION (this);
   NS_LOG_UNCOND("Wait for stop message");
-  NotifyCurrentState();
+  if (m_envs.empty()) {
+    NotifyCurrentState();
+  } else if (!m_stopEnvRequested) {
+    ExchangeBatch();
+  }
 }
 
 void
 OpenGymInterface::NotifySimulationEnd()
 {
   NS_LOG_FUNCTION (this);
+  // every env of a batch reports the end
+  if (m_simEnd) {
+    return;
+  }
   m_simEnd = true;
   if (m_initSimMsgSent) {
     WaitForStop();
@@ -392,14 +797,181 @@ OpenGymInterface::Notify(Ptr<OpenGymEnv> entity)
 {
   NS_LOG_FUNCTION (this);
 
-  SetGetGameOverCb( MakeCallback (&OpenGymEnv::GetGameOver, entity) );
-  SetGetObservationCb( MakeCallback (&OpenGymEnv::GetObservation, entity) );
-  SetGetRewardCb( MakeCallback (&OpenGymEnv::GetReward, entity) );
-  SetGetExtraInfoCb( MakeCallback (&OpenGymEnv::GetExtraInfo, entity) );
-  SetExecuteActionsCb( MakeCallback (&OpenGymEnv::ExecuteActions, entity) );
+  if (!m_envs.empty()) {
+    NotifyBatched(entity);
+    return;
+  }
+
+  SetGetGameOverCb( MakeCallback (&OpenGymEnv::GetStepGameOver, entity) );
+  SetGetObservationCb( MakeCallback (&OpenGymEnv::GetStepObservation, entity) );
+  SetGetRewardCb( MakeCallback (&OpenGymEnv::GetStepReward, entity) );
+  SetGetExtraInfoCb( MakeCallback (&OpenGymEnv::GetStepExtraInfo, entity) );
+  SetExecuteActionsCb( MakeCallback (&OpenGymEnv::ExecuteStepActions, entity) );
+  SetGetChangedFieldsCb( MakeCallback (&OpenGymEnv::GetStepChangedFields, entity) );
 
   NotifyCurrentState();
 }
 
+uint32_t
+OpenGymInterface::AddEnv(Ptr<OpenGymEnv> env)
+{
+  NS_LOG_FUNCTION (this << env);
+  NS_ABORT_MSG_IF(m_initSimMsgSent, "Envs have to be added before the first step");
+  BatchEnv batchEnv;
+  batchEnv.env = env;
+  batchEnv.pending = false;
+  batchEnv.done = false;
+  batchEnv.reward = 0.0;
+  batchEnv.gameOver = false;
+  batchEnv.changedFields = OpenGymEnv::ALL_FIELDS;
+  batchEnv.infoSent = false;
+  m_envs.push_back(batchEnv);
+  return m_envs.size() - 1;
+}
+
+uint32_t
+OpenGymInterface::GetNEnvs() const
+{
+  return m_envs.size();
 }
 
+void
+OpenGymInterface::NotifyBatched(Ptr<OpenGymEnv> entity)
+{
+  NS_LOG_FUNCTION (this << entity);
+
+  if (!m_initSimMsgSent) {
+    Init();
+  }
+
+  if (m_stopEnvRequested) {
+    return;
+  }
+
+  uint32_t id = 0;
+  while (id < m_envs.size() && m_envs[id].env != entity) {
+    ++id;
+  }
+  NS_ABORT_MSG_IF(id == m_envs.size(), "Env " << entity << " notified without being added to the interface");
+
+  BatchEnv &batchEnv = m_envs[id];
+  if (batchEnv.done) {
+    return;
+  }
+  if (batchEnv.pending) {
+    NS_LOG_WARN("Env " << id << " notified twice in one batch; the earlier state is replaced");
+  }
+
+  // the state at the time of the notification; the action follows when the batch is complete
+  batchEnv.pending = true;
+  batchEnv.obs = entity->GetStepObservation();
+  batchEnv.reward = entity->GetStepReward();
+  batchEnv.gameOver = entity->GetStepGameOver();
+  batchEnv.info = entity->GetStepExtraInfo();
+  batchEnv.changedFields = entity->GetStepChangedFields();
+
+  for (uint32_t i = 0; i < m_envs.size(); ++i) {
+    if (!m_envs[i].pending && !m_envs[i].done) {
+      return;
+    }
+  }
+  ExchangeBatch();
+}
+
+void
+OpenGymInterface::ExchangeBatch()
+{
+  NS_LOG_FUNCTION (this);
+
+  google::protobuf::Arena *arena = ResetScratchArena();
+  // reused like the message of a single env: fields are overwritten, not cleared
+  ns3opengym::EnvStateBatchMsg *batchMsg = m_envStateBatchMsg;
+  while (batchMsg->state_size() < int(m_envs.size())) {
+    batchMsg->add_state();
+  }
+  m_batchKeptObs.assign(m_envs.size(), nullptr);
+  m_stepLog->BeginStep();
+  for (uint32_t i = 0; i < m_envs.size(); ++i) {
+    BatchEnv &batchEnv = m_envs[i];
+    m_stepLog->LogState(i, batchEnv.obs, batchEnv.reward, batchEnv.gameOver || m_simEnd, batchEnv.info);
+    ns3opengym::EnvStateMsg *envStateMsg = batchMsg->mutable_state(i);
+    // unchanged observations (cached, or of an env that is done) are detached while sending, like for a single env
+    bool obsUnchanged = batchEnv.obs && batchEnv.obs == batchEnv.sentObs
+                        && (!batchEnv.pending || !(batchEnv.changedFields & OpenGymEnv::OBSERVATION));
+    if (obsUnchanged) {
+      m_batchKeptObs[i] = envStateMsg->unsafe_arena_release_obsdata();
+    } else if (batchEnv.obs) {
+      batchEnv.obs->FillDataContainerPbMsg(*envStateMsg->mutable_obsdata(), arena);
+    } else if (envStateMsg->has_obsdata()) {
+      envStateMsg->clear_obsdata();
+    }
+    batchEnv.sentObs = batchEnv.obs;
+    envStateMsg->set_obsunchanged(obsUnchanged);
+    envStateMsg->set_reward(batchEnv.reward);
+    bool isGameOver = batchEnv.gameOver || m_simEnd;
+    envStateMsg->set_isgameover(isGameOver);
+    if (isGameOver && !m_simEnd) {
+      envStateMsg->set_reason(ns3opengym::EnvStateMsg::GameOver);
+    } else {
+      envStateMsg->set_reason(ns3opengym::EnvStateMsg::SimulationEnd);
+    }
+    bool infoUnchanged = batchEnv.infoSent && batchEnv.info == batchEnv.sentInfo;
+    if (infoUnchanged) {
+      envStateMsg->mutable_info()->clear();
+    } else {
+      envStateMsg->set_info(batchEnv.info);
+      batchEnv.sentInfo = batchEnv.info;
+      batchEnv.infoSent = true;
+    }
+    envStateMsg->set_infounchanged(infoUnchanged);
+  }
+
+  // send the states of all envs to python
+  SendMessage(*batchMsg);
+  for (uint32_t i = 0; i < m_envs.size(); ++i) {
+    if (m_batchKeptObs[i]) {
+      batchMsg->mutable_state(i)->unsafe_arena_set_allocated_obsdata(m_batchKeptObs[i]);
+    }
+  }
+
+  // receive the actions of all envs
+  ns3opengym::EnvActBatchMsg *actBatchMsg = google::protobuf::Arena::CreateMessage<ns3opengym::EnvActBatchMsg>(arena);
+  zmq::message_t reply;
+  m_zmq_socket.recv (&reply);
+  actBatchMsg->ParseFromArray(reply.data(), reply.size());
+
+  if (m_simEnd) {
+    for (uint32_t i = 0; i < m_envs.size(); ++i) {
+      if (m_envs[i].pending) {
+        m_recorder->Record(i, m_envs[i].obs, nullptr, m_envs[i].reward, true);
+      }
+    }
+    return;
+  }
+
+  bool stopSim = actBatchMsg->stopsimreq();
+  if (stopSim) {
+    NS_LOG_DEBUG("---Stop requested: " << stopSim);
+    StopSimulation();
+  }
+
+  for (uint32_t i = 0; i < m_envs.size(); ++i) {
+    BatchEnv &batchEnv = m_envs[i];
+    if (!batchEnv.pending) {
+      continue;
+    }
+    batchEnv.pending = false;
+    if (batchEnv.gameOver) {
+      batchEnv.done = true;
+      m_recorder->Record(i, batchEnv.obs, nullptr, batchEnv.reward, true);
+    } else if (int(i) < actBatchMsg->action_size()) {
+      ns3opengym::DataContainer *actDataContainerPbMsg = actBatchMsg->mutable_action(i)->mutable_actdata();
+      Ptr<OpenGymDataContainer> actDataContainer = OpenGymDataContainer::CreateFromDataContainerPbMsg(*actDataContainerPbMsg);
+      m_stepLog->LogAction(i, actDataContainer);
+      m_recorder->Record(i, batchEnv.obs, actDataContainer, batchEnv.reward, false);
+      batchEnv.env->ExecuteStepActions(actDataContainer);
+    }
+  }
+}
+
+}
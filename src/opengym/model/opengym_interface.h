@@ -23,18 +23,50 @@
 #define OPENGYM_INTERFACE_H
 
 #include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/traced-callback.h"
 #include <zmq.hpp>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <map>
+
+namespace google {
+namespace protobuf {
+class Arena;
+}
+}
+
+namespace ns3opengym {
+class DataContainer;
+class EnvStateMsg;
+class EnvActMsg;
+class EnvStateBatchMsg;
+class EnvActBatchMsg;
+}
 
 namespace ns3 {
 
 class OpenGymSpace;
 class OpenGymDataContainer;
 class OpenGymEnv;
+class OpenGymShmChannel;
+class OpenGymStepLog;
+class OpenGymTransitionRecorder;
 
 class OpenGymInterface : public Object
 {
 public:
-  static Ptr<OpenGymInterface> Get (uint32_t port=5555);
+  // how observations and actions are exchanged after the zmq handshake
+  enum Transport
+  {
+    ZMQ_TRANSPORT,
+    SHM_TRANSPORT
+  };
+
+  // interface of a port, created on first use; without port the interface created first (or the one of port 5555)
+  static Ptr<OpenGymInterface> Get (uint32_t port=0);
 
   OpenGymInterface (uint32_t port=5555);
   virtual ~OpenGymInterface ();
@@ -62,18 +94,54 @@ public:
   void SetGetGameOverCb(Callback< bool > cb);
   void SetGetExtraInfoCb(Callback<std::string> cb);
   void SetExecuteActionsCb(Callback<bool, Ptr<OpenGymDataContainer> > cb);
+  // OpenGymEnv::StateField mask of the fields evaluated for the current step; without callback all fields are new
+  void SetGetChangedFieldsCb(Callback<uint32_t> cb);
 
   void Notify(Ptr<OpenGymEnv> entity);
 
+  // vectorized env: the added envs step together in one batched message (all envs share the spaces of the first);
+  // returns the env id, i.e. the index in the batch
+  uint32_t AddEnv(Ptr<OpenGymEnv> env);
+  uint32_t GetNEnvs() const;
+
 protected:
   // Inherited
   virtual void DoInitialize (void);
   virtual void DoDispose (void);
 
 private:
-  static Ptr<OpenGymInterface> *DoGet (uint32_t port=5555);
+  static Ptr<OpenGymInterface> *DoGet (uint32_t port=0);
+  static std::map<uint32_t, Ptr<OpenGymInterface> > &GetInstances (void);
   static void Delete (void);
 
+  void StopSimulation();
+
+  // collect the state of a batched env; the batch is exchanged once every env that is not done has notified
+  void NotifyBatched(Ptr<OpenGymEnv> entity);
+  void ExchangeBatch();
+
+  // send the env state via zmq and wait for the action message
+  Ptr<OpenGymDataContainer> ExchangeZmq(Ptr<OpenGymDataContainer> obs, float reward, bool isGameOver, const std::string &extraInfo, uint32_t changedFields, bool &stopSim);
+  void SendStateZmq(Ptr<OpenGymDataContainer> obs, float reward, bool isGameOver, const std::string &extraInfo, uint32_t changedFields);
+  // false if flags contain ZMQ_DONTWAIT and no action message is there yet
+  bool ReceiveActionZmq(int flags, bool &stopSim, Ptr<OpenGymDataContainer> &action);
+  bool ReceiveReply(zmq::message_t &reply, int flags=0);
+
+  // async mode: publish the state and keep simulating, actions are applied when they arrive
+  void NotifyAsync(Ptr<OpenGymDataContainer> obs, float reward, bool isGameOver, const std::string &extraInfo, uint32_t changedFields);
+  void PollActions();
+  // wait for the replies to all states in flight, e.g. before the final state
+  void DrainActions();
+
+  // zmq free function of frames sent without copy; the data stays owned by the interface until the agent replied
+  static void KeepBuffer (void *data, void *hint);
+
+  // arena for the temporary messages of a step
+  google::protobuf::Arena *ResetScratchArena();
+  // send a serialized message from the reused send buffer
+  template <typename M>
+  void SendMessage(const M &msg, int flags=0);
+
   uint32_t m_port;
   zmq::context_t m_zmq_context;
   zmq::socket_t m_zmq_socket;
@@ -82,6 +150,67 @@ private:
   bool m_stopEnvRequested;
   bool m_initSimMsgSent;
 
+  // send box observations as raw tensor frame instead of protobuf repeated fields
+  bool m_rawTensor;
+  // observation of the last raw tensor frame, kept until the agent replied (zmq reads the data in the background)
+  Ptr<OpenGymDataContainer> m_rawTensorObs;
+  // byte swapped copy of the last raw tensor on big-endian hosts
+  std::vector<uint8_t> m_rawTensorBuffer;
+
+  // the outgoing step messages live on m_arena and are refilled every step, so their buffers are reused;
+  // temporary and received messages go to the scratch arena, which is reset every step and keeps its initial block
+  std::unique_ptr<google::protobuf::Arena> m_arena;
+  ns3opengym::EnvStateMsg *m_envStateMsg;
+  ns3opengym::EnvStateBatchMsg *m_envStateBatchMsg;
+  std::vector<char> m_scratchBlock;
+  std::unique_ptr<google::protobuf::Arena> m_scratchArena;
+  std::vector<uint8_t> m_sendBuffer;
+
+  // observation and info the agent got last; unchanged ones are omitted from the next state message
+  Ptr<OpenGymDataContainer> m_sentObs;
+  std::string m_sentInfo;
+  bool m_infoSent;
+
+  // async mode with a DEALER socket; the agent keeps its REP socket, which strips the envelope
+  bool m_async;
+  Time m_asyncPollInterval;
+  uint32_t m_asyncMaxPending;
+  // send times and step log steps of the states in flight, the agent answers them in order
+  std::deque<std::pair<Time, uint64_t> > m_asyncSent;
+  EventId m_asyncPollEvent;
+  uint64_t m_asyncDropped;
+  TracedCallback<Time> m_actionLatencyTrace;
+
+  // shared memory channel of the SharedMemory transport
+  Transport m_transport;
+  uint32_t m_shmSlotSize;
+  uint32_t m_shmSpin;
+  std::unique_ptr<OpenGymShmChannel> m_shm;
+
+  // binary step log, see the ns3::OpenGymStepLog attributes; off by default
+  Ptr<OpenGymStepLog> m_stepLog;
+  // transition dataset for offline training, see the ns3::OpenGymTransitionRecorder attributes; off by default
+  Ptr<OpenGymTransitionRecorder> m_recorder;
+
+  // envs of a vectorized env with their state since the last batch
+  struct BatchEnv
+  {
+    Ptr<OpenGymEnv> env;
+    bool pending;       // notified since the last batch
+    bool done;          // game over reported; gets no actions anymore
+    Ptr<OpenGymDataContainer> obs;
+    float reward;
+    bool gameOver;
+    std::string info;
+    uint32_t changedFields;
+    Ptr<OpenGymDataContainer> sentObs;
+    std::string sentInfo;
+    bool infoSent;
+  };
+  std::vector<BatchEnv> m_envs;
+  // observations of the batch message detached while it is sent
+  std::vector<ns3opengym::DataContainer*> m_batchKeptObs;
+
   Callback< Ptr<OpenGymSpace> > m_actionSpaceCb;
   Callback< Ptr<OpenGymSpace> > m_observationSpaceCb;
   Callback< bool > m_gameOverCb;
@@ -89,6 +218,7 @@ private:
   Callback<float> m_rewardCb;
   Callback<std::string> m_extraInfoCb;
   Callback<bool, Ptr<OpenGymDataContainer> > m_actionCb;
+  Callback<uint32_t> m_changedFieldsCb;
 };
 
 } // end of namespace ns3
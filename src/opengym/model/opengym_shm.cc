@@ -0,0 +1,268 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <cstring>
+#include <algorithm>
+#include "ns3/log.h"
+#include "ns3/fatal-error.h"
+#include "ns3/abort.h"
+#include "opengym_shm.h"
+#include "container.h"
+#include "messages.pb.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("OpenGymShmChannel");
+
+namespace {
+// fixed offsets keep the python side simple; sem_t is 32 bytes on x86_64 linux
+const uint32_t HEADER_SIZE = 64;
+const uint32_t SEM_SIZE = 64;
+const uint32_t SLOT_HEADER_SIZE = 128;
+const uint32_t VERSION = 1;
+
+uint32_t
+AlignUp (uint32_t size, uint32_t alignment)
+{
+  return (size + alignment - 1) / alignment * alignment;
+}
+}
+
+const uint32_t OpenGymShmChannel::GAME_OVER;
+const uint32_t OpenGymShmChannel::SIMULATION_END;
+const uint32_t OpenGymShmChannel::STOP_SIM;
+const uint32_t OpenGymShmChannel::MAX_DIMS;
+
+OpenGymShmChannel::OpenGymShmChannel ()
+  : m_base(nullptr), m_size(0), m_slotSize(0), m_spin(0), m_seq(0), m_linked(false), m_agentPid(0)
+{
+  static_assert (sizeof (ShmHeader) <= HEADER_SIZE, "shm header does not fit");
+  static_assert (sizeof (sem_t) <= SEM_SIZE, "sem_t does not fit");
+  static_assert (sizeof (ShmSlotHeader) <= SLOT_HEADER_SIZE, "slot header does not fit");
+}
+
+OpenGymShmChannel::~OpenGymShmChannel ()
+{
+  if (m_base) {
+    sem_destroy(reinterpret_cast<sem_t*>(m_base + HEADER_SIZE));
+    sem_destroy(reinterpret_cast<sem_t*>(m_base + HEADER_SIZE + SEM_SIZE));
+    munmap(m_base, m_size);
+  }
+  Unlink();
+}
+
+void
+OpenGymShmChannel::Create (uint32_t port, uint32_t slotSize, uint32_t spin)
+{
+  NS_LOG_FUNCTION (this << port << slotSize);
+
+  m_slotSize = AlignUp(slotSize, 64);
+  m_spin = spin;
+  uint32_t slotOffset = HEADER_SIZE + 2 * SEM_SIZE;
+  uint32_t slotBytes = SLOT_HEADER_SIZE + m_slotSize;
+  m_size = slotOffset + 2 * slotBytes;
+
+  m_name = "/ns3gym-" + std::to_string(::getpid()) + "-" + std::to_string(port);
+  int fd = shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0 && errno == EEXIST) {
+    // left over by a crashed run of a process with the same pid
+    shm_unlink(m_name.c_str());
+    fd = shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  }
+  if (fd < 0) {
+    NS_FATAL_ERROR("Can not create shared memory " << m_name << ": " << std::strerror(errno));
+  }
+  m_linked = true;
+
+  if (ftruncate(fd, m_size) != 0) {
+    close(fd);
+    NS_FATAL_ERROR("Can not resize shared memory " << m_name << ": " << std::strerror(errno));
+  }
+  void* base = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) {
+    NS_FATAL_ERROR("Can not map shared memory " << m_name << ": " << std::strerror(errno));
+  }
+  m_base = static_cast<uint8_t*>(base);
+
+  ShmHeader* header = reinterpret_cast<ShmHeader*>(m_base);
+  std::memcpy(header->magic, "NS3GYM\0\0", 8);
+  header->version = VERSION;
+  header->stateSemOffset = HEADER_SIZE;
+  header->actSemOffset = HEADER_SIZE + SEM_SIZE;
+  header->stateSlotOffset = slotOffset;
+  header->actSlotOffset = slotOffset + slotBytes;
+  header->slotSize = m_slotSize;
+
+  if (sem_init(reinterpret_cast<sem_t*>(m_base + header->stateSemOffset), 1, 0) != 0
+      || sem_init(reinterpret_cast<sem_t*>(m_base + header->actSemOffset), 1, 0) != 0) {
+    NS_FATAL_ERROR("Can not initialize shared memory semaphores: " << std::strerror(errno));
+  }
+}
+
+void
+OpenGymShmChannel::Unlink (void)
+{
+  if (m_linked) {
+    shm_unlink(m_name.c_str());
+    m_linked = false;
+  }
+}
+
+const std::string&
+OpenGymShmChannel::GetName (void) const
+{
+  return m_name;
+}
+
+uint32_t
+OpenGymShmChannel::GetSize (void) const
+{
+  return m_size;
+}
+
+void
+OpenGymShmChannel::SetAgentPid (pid_t pid)
+{
+  m_agentPid = pid;
+}
+
+uint8_t*
+OpenGymShmChannel::GetSlotData (uint32_t slotOffset)
+{
+  return m_base + slotOffset + SLOT_HEADER_SIZE;
+}
+
+void
+OpenGymShmChannel::Wait (sem_t* sem)
+{
+  // spinning saves the futex wake up latency if the other side answers quickly
+  for (uint32_t i = 0; i < m_spin; ++i) {
+    if (sem_trywait(sem) == 0) {
+      return;
+    }
+  }
+  // a dead agent never posts; wake up once per second to check whether it still exists
+  while (true) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += 1;
+    if (sem_timedwait(sem, &deadline) == 0) {
+      return;
+    }
+    if (errno == ETIMEDOUT) {
+      if (m_agentPid > 0 && kill(m_agentPid, 0) != 0 && errno == ESRCH) {
+        NS_FATAL_ERROR("Agent process " << m_agentPid << " exited while ns3 was waiting for its action");
+      }
+    } else if (errno != EINTR) {
+      NS_FATAL_ERROR("Waiting for the agent failed: " << std::strerror(errno));
+    }
+  }
+}
+
+void
+OpenGymShmChannel::SendState (Ptr<OpenGymDataContainer> obs, float reward, bool gameOver, bool simEnd, const std::string& info)
+{
+  NS_LOG_FUNCTION (this);
+
+  const ShmHeader* header = reinterpret_cast<const ShmHeader*>(m_base);
+  ShmSlotHeader* slot = reinterpret_cast<ShmSlotHeader*>(m_base + header->stateSlotOffset);
+  uint8_t* data = GetSlotData(header->stateSlotOffset);
+
+  slot->seq = ++m_seq;
+  slot->flags = (gameOver ? GAME_OVER : 0) | (simEnd ? SIMULATION_END : 0);
+  slot->reward = reward;
+  slot->kind = NO_DATA;
+  slot->dataSize = 0;
+
+  if (obs) {
+    // boxes are copied as they are, everything else as serialized protobuf container
+    ns3opengym::RawTensor tensor;
+    const uint8_t* tensorData = nullptr;
+    size_t tensorSize = 0;
+    if (obs->GetRawTensor(tensor, tensorData, tensorSize) && tensor.shape_size() <= int(MAX_DIMS)) {
+      NS_ABORT_MSG_IF(tensorSize > m_slotSize, "Observation of " << tensorSize << " bytes exceeds the shared memory slot; increase SharedMemorySlotSize");
+      slot->kind = RAW_TENSOR;
+      slot->dtype = tensor.dtype();
+      slot->itemSize = tensor.itemsize();
+      slot->ndim = tensor.shape_size();
+      for (int i = 0; i < tensor.shape_size(); ++i) {
+        slot->shape[i] = tensor.shape(i);
+      }
+      std::memcpy(data, tensorData, tensorSize);
+      slot->dataSize = tensorSize;
+    } else {
+      ns3opengym::DataContainer container = obs->GetDataContainerPbMsg();
+      size_t size = container.ByteSizeLong();
+      NS_ABORT_MSG_IF(size > m_slotSize, "Observation of " << size << " bytes exceeds the shared memory slot; increase SharedMemorySlotSize");
+      container.SerializeToArray(data, size);
+      slot->kind = PB_CONTAINER;
+      slot->dataSize = size;
+    }
+  }
+
+  // the extra info follows the data
+  slot->infoSize = std::min<size_t>(info.size(), m_slotSize - slot->dataSize);
+  if (slot->infoSize < info.size()) {
+    NS_LOG_WARN("Extra info truncated to " << slot->infoSize << " bytes");
+  }
+  std::memcpy(data + slot->dataSize, info.data(), slot->infoSize);
+
+  sem_post(reinterpret_cast<sem_t*>(m_base + header->stateSemOffset));
+}
+
+void
+OpenGymShmChannel::ReceiveAction (bool& stopSim, Ptr<OpenGymDataContainer>& action)
+{
+  NS_LOG_FUNCTION (this);
+
+  const ShmHeader* header = reinterpret_cast<const ShmHeader*>(m_base);
+  Wait(reinterpret_cast<sem_t*>(m_base + header->actSemOffset));
+
+  const ShmSlotHeader* slot = reinterpret_cast<const ShmSlotHeader*>(m_base + header->actSlotOffset);
+  const uint8_t* data = GetSlotData(header->actSlotOffset);
+  NS_ABORT_MSG_IF(slot->dataSize > m_slotSize, "Corrupt action slot");
+
+  stopSim = slot->flags & STOP_SIM;
+  action = 0;
+  if (slot->kind == RAW_TENSOR) {
+    ns3opengym::RawTensor tensor;
+    tensor.set_dtype(static_cast<ns3opengym::Dtype>(slot->dtype));
+    tensor.set_itemsize(slot->itemSize);
+    for (uint32_t i = 0; i < std::min(slot->ndim, MAX_DIMS); ++i) {
+      tensor.add_shape(slot->shape[i]);
+    }
+    action = OpenGymDataContainer::CreateFromRawTensor(tensor, data, slot->dataSize);
+  } else if (slot->kind == PB_CONTAINER) {
+    ns3opengym::DataContainer container;
+    container.ParseFromArray(data, slot->dataSize);
+    action = OpenGymDataContainer::CreateFromDataContainerPbMsg(container);
+  } else if (slot->kind == DISCRETE) {
+    Ptr<OpenGymDiscreteContainer> discrete = CreateObject<OpenGymDiscreteContainer>();
+    discrete->SetValue(slot->shape[0]);
+    action = discrete;
+  }
+}
+
+} // end of namespace ns3
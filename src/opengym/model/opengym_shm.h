@@ -0,0 +1,125 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef OPENGYM_SHM_H
+#define OPENGYM_SHM_H
+
+#include <string>
+#include <stdint.h>
+#include <semaphore.h>
+#include <sys/types.h>
+#include "ns3/ptr.h"
+
+namespace ns3 {
+
+class OpenGymDataContainer;
+
+/*
+ * Shared memory channel between ns3 and a python agent on the same host.
+ *
+ * The steps are exchanged in lockstep, so one preallocated slot per direction
+ * is enough: ns3 writes the env state into the state slot and posts stateReady,
+ * the agent answers in the action slot and posts actReady. Both semaphores live
+ * in the shared memory (process shared, futex based on Linux). While waiting for
+ * an action, ns3 checks once per second that the agent process still exists.
+ *
+ * Layout (native byte order, offsets in the header; mirrored in ns3gym/shm_channel.py):
+ *   ShmHeader | sem_t stateReady | sem_t actReady | state slot | action slot
+ * A slot is a ShmSlotHeader followed by the data and the extra info string.
+ */
+class OpenGymShmChannel
+{
+public:
+  // kind of data in a slot
+  enum DataKind
+  {
+    NO_DATA = 0,
+    RAW_TENSOR = 1,      // box as contiguous array (dtype, itemSize, shape in the slot header)
+    PB_CONTAINER = 2,    // serialized ns3opengym::DataContainer
+    DISCRETE = 3         // discrete value in the first shape entry
+  };
+
+  // slot flags
+  static const uint32_t GAME_OVER = 1;
+  static const uint32_t SIMULATION_END = 2;
+  static const uint32_t STOP_SIM = 4;
+
+  static const uint32_t MAX_DIMS = 8;
+
+  struct ShmHeader
+  {
+    char magic[8];
+    uint32_t version;
+    uint32_t stateSemOffset;
+    uint32_t actSemOffset;
+    uint32_t stateSlotOffset;
+    uint32_t actSlotOffset;
+    uint32_t slotSize;        // payload bytes per slot
+  };
+
+  struct ShmSlotHeader
+  {
+    uint32_t seq;
+    uint32_t flags;
+    float reward;
+    uint32_t kind;
+    uint32_t dtype;
+    uint32_t itemSize;
+    uint32_t ndim;
+    uint32_t shape[MAX_DIMS];
+    uint32_t dataSize;
+    uint32_t infoSize;
+  };
+
+  OpenGymShmChannel ();
+  ~OpenGymShmChannel ();
+
+  // create and map the shared memory object; its name is unique per process and port
+  void Create (uint32_t port, uint32_t slotSize, uint32_t spin);
+
+  // remove the name once the agent has mapped the memory; the mapping stays valid
+  void Unlink (void);
+
+  const std::string& GetName (void) const;
+  uint32_t GetSize (void) const;
+
+  // process id of the agent as reported in its init ack; 0 (older agents) disables the liveness check
+  void SetAgentPid (pid_t pid);
+
+  // write the env state and wake up the agent
+  void SendState (Ptr<OpenGymDataContainer> obs, float reward, bool gameOver, bool simEnd, const std::string& info);
+
+  // wait for the answer of the agent
+  void ReceiveAction (bool& stopSim, Ptr<OpenGymDataContainer>& action);
+
+private:
+  void Wait (sem_t* sem);
+  uint8_t* GetSlotData (uint32_t slotOffset);
+
+  std::string m_name;
+  uint8_t* m_base;
+  uint32_t m_size;
+  uint32_t m_slotSize;
+  uint32_t m_spin;
+  uint32_t m_seq;
+  bool m_linked;
+  pid_t m_agentPid;
+};
+
+} // end of namespace ns3
+
+#endif /* OPENGYM_SHM_H */
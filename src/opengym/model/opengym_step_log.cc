@@ -0,0 +1,305 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <errno.h>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include "ns3/log.h"
+#include "ns3/fatal-error.h"
+#include "ns3/simulator.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "opengym_step_log.h"
+#include "container.h"
+#include "messages.pb.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("OpenGymStepLog");
+
+NS_OBJECT_ENSURE_REGISTERED (OpenGymStepLog);
+
+namespace {
+const uint32_t VERSION = 1;
+const uint32_t MAX_DIMS = 8;
+}
+
+TypeId
+OpenGymStepLog::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::OpenGymStepLog")
+    .SetParent<Object> ()
+    .SetGroupName ("OpenGym")
+    .AddConstructor<OpenGymStepLog> ()
+    .AddAttribute ("Level",
+                   "What is recorded per logged step: nothing (Off), the scalars (Step), or also observations, "
+                   "actions and extra info (Data).",
+                   EnumValue (OpenGymStepLog::LOG_OFF),
+                   MakeEnumAccessor (&OpenGymStepLog::m_level),
+                   MakeEnumChecker (OpenGymStepLog::LOG_OFF, "Off",
+                                    OpenGymStepLog::LOG_STEP, "Step",
+                                    OpenGymStepLog::LOG_DATA, "Data"))
+    .AddAttribute ("Sampling",
+                   "Log every n-th step.",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&OpenGymStepLog::m_sampling),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("FileName",
+                   "Output file; empty for a name with process id and port.",
+                   StringValue (""),
+                   MakeStringAccessor (&OpenGymStepLog::m_fileName),
+                   MakeStringChecker ())
+    .AddAttribute ("BufferSize",
+                   "Bytes of the ring buffer between the simulation and the writer thread; records that do not fit "
+                   "are dropped.",
+                   UintegerValue (4 << 20),
+                   MakeUintegerAccessor (&OpenGymStepLog::m_bufferSize),
+                   MakeUintegerChecker<uint32_t> (4096))
+    ;
+  return tid;
+}
+
+OpenGymStepLog::OpenGymStepLog ()
+  : m_level(LOG_OFF), m_sampling(1), m_bufferSize(4 << 20), m_step(0), m_sampled(false), m_dropped(0),
+    m_head(0), m_tail(0), m_writePos(0), m_file(nullptr), m_stop(false)
+{
+  NS_LOG_FUNCTION (this);
+  static_assert (sizeof (RecordHeader) == 48, "record header layout changed, update step_log.py");
+}
+
+OpenGymStepLog::~OpenGymStepLog ()
+{
+  NS_LOG_FUNCTION (this);
+  Close();
+}
+
+void
+OpenGymStepLog::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  Close();
+}
+
+void
+OpenGymStepLog::Open (const std::string &defaultName)
+{
+  NS_LOG_FUNCTION (this << defaultName);
+  if (m_level == LOG_OFF || m_file) {
+    return;
+  }
+
+  std::string name = m_fileName.empty() ? defaultName : m_fileName;
+  m_file = fopen(name.c_str(), "wb");
+  if (!m_file) {
+    NS_FATAL_ERROR("Can not open step log " << name << ": " << std::strerror(errno));
+  }
+  FileHeader header;
+  std::memcpy(header.magic, "NS3GYMLG", 8);
+  header.version = VERSION;
+  header.recordHeaderSize = sizeof(RecordHeader);
+  fwrite(&header, sizeof(header), 1, m_file);
+
+  m_ring.resize(m_bufferSize);
+  m_stop = false;
+  m_writer = std::thread(&OpenGymStepLog::Run, this);
+  NS_LOG_INFO("Step log " << name << " at level " << m_level << ", every " << m_sampling << ". step");
+}
+
+bool
+OpenGymStepLog::BeginStep (void)
+{
+  m_sampled = m_file && (m_step % m_sampling == 0);
+  ++m_step;
+  return m_sampled;
+}
+
+uint64_t
+OpenGymStepLog::GetStep (void) const
+{
+  return m_step - 1;
+}
+
+void
+OpenGymStepLog::LogState (uint32_t env, Ptr<OpenGymDataContainer> obs, float reward, bool gameOver, const std::string &info)
+{
+  if (!m_sampled) {
+    return;
+  }
+
+  RecordHeader header;
+  std::memset(&header, 0, sizeof(header));
+  header.type = STATE;
+  header.env = env;
+  header.step = m_step - 1;
+  header.reward = reward;
+  header.gameOver = gameOver;
+
+  if (m_level < LOG_DATA || !obs) {
+    Append(header, nullptr, nullptr, nullptr);
+    return;
+  }
+
+  ns3opengym::RawTensor tensor;
+  const uint8_t *data = nullptr;
+  size_t size = 0;
+  uint32_t shape[MAX_DIMS];
+  if (obs->GetRawTensor(tensor, data, size) && tensor.shape_size() <= int(MAX_DIMS)) {
+    header.kind = RAW_TENSOR;
+    header.dtype = tensor.dtype();
+    header.itemSize = tensor.itemsize();
+    header.ndim = tensor.shape_size();
+    std::copy(tensor.shape().begin(), tensor.shape().end(), shape);
+  } else {
+    // rare in the hot path: boxes are the common observation
+    obs->GetDataContainerPbMsg().SerializeToString(&m_scratch);
+    header.kind = PB_CONTAINER;
+    data = reinterpret_cast<const uint8_t*>(m_scratch.data());
+    size = m_scratch.size();
+  }
+  header.dataSize = size;
+  header.infoSize = info.size();
+  Append(header, shape, data, &info);
+}
+
+void
+OpenGymStepLog::LogAction (uint32_t env, Ptr<OpenGymDataContainer> action)
+{
+  if (m_sampled) {
+    LogAction(env, m_step - 1, action);
+  }
+}
+
+void
+OpenGymStepLog::LogAction (uint32_t env, uint64_t step, Ptr<OpenGymDataContainer> action)
+{
+  // the sampling decision of BeginStep for that step
+  if (!m_file || step % m_sampling != 0) {
+    return;
+  }
+
+  RecordHeader header;
+  std::memset(&header, 0, sizeof(header));
+  header.type = ACTION;
+  header.env = env;
+  header.step = step;
+  if (m_level < LOG_DATA || !action) {
+    Append(header, nullptr, nullptr, nullptr);
+    return;
+  }
+
+  // actions arrive as protobuf containers anyway and are small
+  action->GetDataContainerPbMsg().SerializeToString(&m_scratch);
+  header.kind = PB_CONTAINER;
+  header.dataSize = m_scratch.size();
+  Append(header, nullptr, reinterpret_cast<const uint8_t*>(m_scratch.data()), nullptr);
+}
+
+void
+OpenGymStepLog::Append (RecordHeader &header, const uint32_t *shape, const uint8_t *data, const std::string *info)
+{
+  header.timeNs = Simulator::Now().GetNanoSeconds();
+  header.size = sizeof(RecordHeader) + header.ndim * sizeof(uint32_t) + header.dataSize + header.infoSize;
+
+  uint64_t head = m_head.load(std::memory_order_relaxed);
+  uint64_t used = head - m_tail.load(std::memory_order_acquire);
+  if (header.size > m_ring.size() - used) {
+    // never block the simulation on the disk
+    if (m_dropped++ == 0) {
+      NS_LOG_WARN("Step log buffer full, records are dropped; increase BufferSize or Sampling");
+    }
+    return;
+  }
+
+  m_writePos = head;
+  CopyIn(&header, sizeof(header));
+  CopyIn(shape, header.ndim * sizeof(uint32_t));
+  CopyIn(data, header.dataSize);
+  if (info) {
+    CopyIn(info->data(), header.infoSize);
+  }
+  m_head.store(m_writePos, std::memory_order_release);
+
+  // the writer wakes up on its own every few ms, only a filling buffer is worth the notification
+  if (used + header.size > m_ring.size() / 2) {
+    m_wakeUp.notify_one();
+  }
+}
+
+void
+OpenGymStepLog::CopyIn (const void *data, size_t size)
+{
+  if (size == 0) {
+    return;
+  }
+  size_t pos = m_writePos % m_ring.size();
+  size_t first = std::min(size, m_ring.size() - pos);
+  std::memcpy(m_ring.data() + pos, data, first);
+  std::memcpy(m_ring.data(), static_cast<const uint8_t*>(data) + first, size - first);
+  m_writePos += size;
+}
+
+size_t
+OpenGymStepLog::WriteOut (void)
+{
+  uint64_t tail = m_tail.load(std::memory_order_relaxed);
+  uint64_t head = m_head.load(std::memory_order_acquire);
+  size_t size = head - tail;
+  if (size == 0) {
+    return 0;
+  }
+  size_t pos = tail % m_ring.size();
+  size_t first = std::min(size, m_ring.size() - pos);
+  fwrite(m_ring.data() + pos, 1, first, m_file);
+  fwrite(m_ring.data(), 1, size - first, m_file);
+  m_tail.store(head, std::memory_order_release);
+  return size;
+}
+
+void
+OpenGymStepLog::Run (void)
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (!m_stop) {
+    m_wakeUp.wait_for(lock, std::chrono::milliseconds(20));
+    WriteOut();
+  }
+}
+
+void
+OpenGymStepLog::Close (void)
+{
+  if (!m_file) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_wakeUp.notify_one();
+  m_writer.join();
+  WriteOut();
+  fclose(m_file);
+  m_file = nullptr;
+  m_sampled = false;
+  if (m_dropped) {
+    NS_LOG_WARN("Step log dropped " << m_dropped << " records");
+  }
+}
+
+} // end of namespace ns3
@@ -0,0 +1,155 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef OPENGYM_STEP_LOG_H
+#define OPENGYM_STEP_LOG_H
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdio.h>
+#include <stdint.h>
+#include "ns3/object.h"
+
+namespace ns3 {
+
+class OpenGymDataContainer;
+
+/*
+ * Binary log of the gym steps (states and actions) for offline inspection.
+ *
+ * Records are appended to a ring buffer by the simulation and written to the
+ * file by a background thread, so the step only pays a memcpy. If the writer
+ * falls behind, records are dropped and counted instead of blocking the
+ * simulation. Level Off (default) records nothing and opens no file.
+ *
+ * File layout (native byte order; read by ns3gym/step_log.py):
+ *   FileHeader, then records: RecordHeader | uint32 shape[ndim] | data | info
+ * Data is the raw box (kind RAW_TENSOR) or a serialized ns3opengym::DataContainer
+ * (kind PB_CONTAINER), as in the shared memory slots. An action carries the
+ * step of the state it answers; in async mode it may follow newer states.
+ */
+class OpenGymStepLog : public Object
+{
+public:
+  enum Level
+  {
+    LOG_OFF,
+    LOG_STEP,     // step, time, reward, game over
+    LOG_DATA      // additionally observations, actions and extra info
+  };
+
+  enum RecordType
+  {
+    STATE = 1,
+    ACTION = 2
+  };
+
+  enum DataKind
+  {
+    NO_DATA = 0,
+    RAW_TENSOR = 1,
+    PB_CONTAINER = 2
+  };
+
+  struct FileHeader
+  {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordHeaderSize;
+  };
+
+  struct RecordHeader
+  {
+    uint32_t size;          // bytes of the record including this header
+    uint16_t type;
+    uint16_t env;           // env id of a vectorized env, 0 otherwise
+    uint64_t step;
+    int64_t timeNs;         // simulation time
+    float reward;
+    uint8_t gameOver;
+    uint8_t kind;
+    uint8_t dtype;
+    uint8_t itemSize;
+    uint32_t ndim;
+    uint32_t dataSize;
+    uint32_t infoSize;
+    uint32_t reserved;
+  };
+
+  static TypeId GetTypeId ();
+
+  OpenGymStepLog ();
+  virtual ~OpenGymStepLog ();
+
+  // open the file (FileName, or defaultName if empty) and start the writer; nothing happens at level Off
+  void Open (const std::string &defaultName);
+
+  // start the next step; returns whether it is logged (level and sampling)
+  bool BeginStep (void);
+
+  // number of the step started last
+  uint64_t GetStep (void) const;
+
+  void LogState (uint32_t env, Ptr<OpenGymDataContainer> obs, float reward, bool gameOver, const std::string &info);
+  void LogAction (uint32_t env, Ptr<OpenGymDataContainer> action);
+
+  // action answering an earlier step (async mode); logged if that step was sampled
+  void LogAction (uint32_t env, uint64_t step, Ptr<OpenGymDataContainer> action);
+
+  // write what is buffered and stop the writer
+  void Close (void);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  void Append (RecordHeader &header, const uint32_t *shape, const uint8_t *data, const std::string *info);
+  void CopyIn (const void *data, size_t size);
+  void Run (void);
+  size_t WriteOut (void);
+
+  Level m_level;
+  uint32_t m_sampling;
+  std::string m_fileName;
+  uint32_t m_bufferSize;
+
+  uint64_t m_step;
+  bool m_sampled;
+  uint64_t m_dropped;
+
+  // single producer (simulation) / single consumer (writer thread); positions grow and are taken modulo the size
+  std::vector<uint8_t> m_ring;
+  std::atomic<uint64_t> m_head;
+  std::atomic<uint64_t> m_tail;
+  uint64_t m_writePos;      // producer position while a record is copied in, published as m_head when complete
+
+  FILE *m_file;
+  std::thread m_writer;
+  std::mutex m_mutex;
+  std::condition_variable m_wakeUp;
+  std::atomic<bool> m_stop;
+
+  std::string m_scratch;    // serialized non-box containers
+};
+
+} // end of namespace ns3
+
+#endif /* OPENGYM_STEP_LOG_H */
@@ -0,0 +1,315 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <errno.h>
+#include <cstring>
+#include <algorithm>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#include "ns3/log.h"
+#include "ns3/fatal-error.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "opengym_transition_recorder.h"
+#include "container.h"
+#include "messages.pb.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("OpenGymTransitionRecorder");
+
+NS_OBJECT_ENSURE_REGISTERED (OpenGymTransitionRecorder);
+
+namespace {
+const uint32_t VERSION = 1;
+const uint64_t ALIGNMENT = 64;
+}
+
+TypeId
+OpenGymTransitionRecorder::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::OpenGymTransitionRecorder")
+    .SetParent<Object> ()
+    .SetGroupName ("OpenGym")
+    .AddConstructor<OpenGymTransitionRecorder> ()
+    .AddAttribute ("FileName",
+                   "Transition dataset to write; empty (default) records nothing.",
+                   StringValue (""),
+                   MakeStringAccessor (&OpenGymTransitionRecorder::m_fileName),
+                   MakeStringChecker ())
+    .AddAttribute ("ChunkRows",
+                   "Steps per chunk; a chunk is compressed and written when full.",
+                   UintegerValue (4096),
+                   MakeUintegerAccessor (&OpenGymTransitionRecorder::m_chunkRows),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("CompressionLevel",
+                   "zlib level of the columns, 0 stores them uncompressed (always the case without zlib).",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&OpenGymTransitionRecorder::m_compressionLevel),
+                   MakeUintegerChecker<uint32_t> (0, 9))
+    ;
+  return tid;
+}
+
+OpenGymTransitionRecorder::OpenGymTransitionRecorder ()
+  : m_chunkRows(4096), m_compressionLevel(1), m_file(nullptr), m_pos(0), m_rows(0), m_closed(false),
+    m_obsTypeKnown(false), m_actTypeKnown(false), m_chunkRowCount(0)
+{
+  NS_LOG_FUNCTION (this);
+  static_assert (sizeof (FileHeader) == 112, "file header layout changed, update transitions.py");
+  static_assert (sizeof (ChunkHeader) == 160, "chunk header layout changed, update transitions.py");
+}
+
+OpenGymTransitionRecorder::~OpenGymTransitionRecorder ()
+{
+  NS_LOG_FUNCTION (this);
+  Close();
+}
+
+void
+OpenGymTransitionRecorder::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  Close();
+}
+
+bool
+OpenGymTransitionRecorder::IsEnabled (void) const
+{
+  return !m_fileName.empty() && !m_closed;
+}
+
+bool
+OpenGymTransitionRecorder::GetRow (Ptr<OpenGymDataContainer> data, RowType &type, bool &typeKnown,
+                                   std::vector<uint8_t> &column, const char *what)
+{
+  ns3opengym::RawTensor tensor;
+  const uint8_t *bytes = nullptr;
+  size_t size = 0;
+  uint32_t value = 0;
+  if (!data || !data->GetRawTensor(tensor, bytes, size)) {
+    if (Ptr<OpenGymDiscreteContainer> discrete = DynamicCast<OpenGymDiscreteContainer>(data)) {
+      value = discrete->GetValue();
+      tensor.set_dtype(ns3opengym::UINT);
+      tensor.set_itemsize(sizeof(value));
+      bytes = reinterpret_cast<const uint8_t*>(&value);
+      size = sizeof(value);
+    } else if (data) {
+      NS_LOG_WARN("Transition recorder supports box and discrete " << what << "s only, stop recording");
+      return false;
+    }
+  }
+
+  if (data && !typeKnown) {
+    if (tensor.shape_size() > int(MAX_DIMS)) {
+      NS_LOG_WARN("Transition recorder supports up to " << MAX_DIMS << " dimensions, stop recording");
+      return false;
+    }
+    type.dtype = tensor.dtype();
+    type.itemSize = tensor.itemsize();
+    type.shape.assign(tensor.shape().begin(), tensor.shape().end());
+    type.rowSize = type.itemSize;
+    for (uint32_t dim : type.shape) {
+      type.rowSize *= dim;
+    }
+    typeKnown = true;
+    // earlier rows of the chunk had no data
+    column.assign(m_chunkRowCount * type.rowSize, 0);
+  } else if (data && (uint32_t(tensor.dtype()) != type.dtype || tensor.itemsize() != type.itemSize)) {
+    NS_LOG_WARN("Transition recorder got " << what << "s of different types, stop recording");
+    return false;
+  }
+
+  // rows have a fixed size; a box of another shape would be cut or padded silently
+  if (data && (size != type.rowSize || tensor.shape_size() != int(type.shape.size())
+               || !std::equal(type.shape.begin(), type.shape.end(), tensor.shape().begin()))) {
+    NS_LOG_WARN("Transition recorder got " << what << "s of different shapes, stop recording");
+    return false;
+  }
+
+  // missing data (e.g. no action for the last state) is zero padded
+  size_t rowSize = typeKnown ? type.rowSize : 0;
+  size_t pos = column.size();
+  column.resize(pos + rowSize);
+  if (size) {
+    std::memcpy(column.data() + pos, bytes, size);
+  }
+  std::fill(column.begin() + pos + size, column.end(), 0);
+  return true;
+}
+
+void
+OpenGymTransitionRecorder::Record (uint32_t env, Ptr<OpenGymDataContainer> obs, Ptr<OpenGymDataContainer> action,
+                                   float reward, bool done)
+{
+  if (!IsEnabled()) {
+    return;
+  }
+
+  if (env >= m_envSteps.size()) {
+    m_envSteps.resize(env + 1, 0);
+  }
+  if (!GetRow(obs, m_obsType, m_obsTypeKnown, m_columns[COL_OBS], "observation")
+      || !GetRow(action, m_actType, m_actTypeKnown, m_columns[COL_ACTION], "action")) {
+    // keep the rows recorded so far readable
+    m_columns[COL_OBS].resize(m_chunkRowCount * (m_obsTypeKnown ? m_obsType.rowSize : 0));
+    m_columns[COL_ACTION].resize(m_chunkRowCount * (m_actTypeKnown ? m_actType.rowSize : 0));
+    Close();
+    return;
+  }
+
+  uint64_t step = m_envSteps[env];
+  m_envSteps[env] = done ? 0 : step + 1;
+  uint8_t doneByte = done;
+  std::vector<uint8_t> &envColumn = m_columns[COL_ENV];
+  envColumn.insert(envColumn.end(), reinterpret_cast<const uint8_t*>(&env), reinterpret_cast<const uint8_t*>(&env + 1));
+  std::vector<uint8_t> &stepColumn = m_columns[COL_STEP];
+  stepColumn.insert(stepColumn.end(), reinterpret_cast<const uint8_t*>(&step), reinterpret_cast<const uint8_t*>(&step + 1));
+  std::vector<uint8_t> &rewardColumn = m_columns[COL_REWARD];
+  rewardColumn.insert(rewardColumn.end(), reinterpret_cast<const uint8_t*>(&reward), reinterpret_cast<const uint8_t*>(&reward + 1));
+  m_columns[COL_DONE].push_back(doneByte);
+
+  if (++m_chunkRowCount == m_chunkRows) {
+    WriteChunk();
+  }
+}
+
+void
+OpenGymTransitionRecorder::Pad (uint64_t to)
+{
+  static const uint8_t zeros[ALIGNMENT] = {0};
+  if (to > m_pos) {
+    fwrite(zeros, 1, to - m_pos, m_file);
+    m_pos = to;
+  }
+}
+
+void
+OpenGymTransitionRecorder::WriteColumn (Column column, const std::vector<uint8_t> &data, ChunkHeader &header,
+                                        uint64_t chunkStart)
+{
+  Pad((m_pos + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT);
+  const uint8_t *stored = data.data();
+  size_t size = data.size();
+#ifdef HAVE_ZLIB
+  if (m_compressionLevel > 0 && size > 0) {
+    uLongf compressedSize = compressBound(size);
+    m_compressed.resize(compressedSize);
+    if (compress2(m_compressed.data(), &compressedSize, data.data(), size, m_compressionLevel) != Z_OK) {
+      NS_FATAL_ERROR("Compression of transition column " << column << " failed");
+    }
+    stored = m_compressed.data();
+    size = compressedSize;
+  }
+#endif
+  header.offset[column] = m_pos - chunkStart;
+  header.size[column] = size;
+  header.rawSize[column] = data.size();
+  if (size) {
+    fwrite(stored, 1, size, m_file);
+  }
+  m_pos += size;
+}
+
+void
+OpenGymTransitionRecorder::WriteChunk (void)
+{
+  NS_LOG_FUNCTION (this << m_chunkRowCount);
+  if (m_chunkRowCount == 0) {
+    return;
+  }
+
+  if (!m_file) {
+    // the column types are known with the first rows
+    m_file = fopen(m_fileName.c_str(), "wb");
+    if (!m_file) {
+      NS_FATAL_ERROR("Can not open transition file " << m_fileName << ": " << std::strerror(errno));
+    }
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, "NS3GYMTR", 8);
+    header.version = VERSION;
+#ifdef HAVE_ZLIB
+    header.codec = m_compressionLevel > 0 ? CODEC_ZLIB : CODEC_NONE;
+#else
+    header.codec = CODEC_NONE;
+#endif
+    header.chunkRows = m_chunkRows;
+    // a column without data in the first chunk stays empty
+    m_obsTypeKnown = m_actTypeKnown = true;
+    header.obsDtype = m_obsType.dtype;
+    header.obsItemSize = m_obsType.itemSize;
+    header.obsNdim = m_obsType.shape.size();
+    std::copy(m_obsType.shape.begin(), m_obsType.shape.end(), header.obsShape);
+    header.actDtype = m_actType.dtype;
+    header.actItemSize = m_actType.itemSize;
+    header.actNdim = m_actType.shape.size();
+    std::copy(m_actType.shape.begin(), m_actType.shape.end(), header.actShape);
+    fwrite(&header, sizeof(header), 1, m_file);
+    m_pos = sizeof(header);
+    NS_LOG_INFO("Recording transitions to " << m_fileName);
+  }
+
+  Pad((m_pos + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT);
+  uint64_t chunkStart = m_pos;
+  m_chunkOffsets.push_back(chunkStart);
+
+  // the header is written last, once the column sizes are known
+  ChunkHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, "NS3CHUNK", 8);
+  header.rows = m_chunkRowCount;
+  fseek(m_file, sizeof(header), SEEK_CUR);
+  m_pos += sizeof(header);
+  for (int column = 0; column < N_COLUMNS; ++column) {
+    WriteColumn(Column(column), m_columns[column], header, chunkStart);
+    m_columns[column].clear();
+  }
+  fseek(m_file, chunkStart, SEEK_SET);
+  fwrite(&header, sizeof(header), 1, m_file);
+  fseek(m_file, m_pos, SEEK_SET);
+
+  m_rows += m_chunkRowCount;
+  m_chunkRowCount = 0;
+}
+
+void
+OpenGymTransitionRecorder::Close (void)
+{
+  if (m_closed) {
+    return;
+  }
+  m_closed = true;
+  WriteChunk();
+  if (!m_file) {
+    return;
+  }
+
+  Trailer trailer;
+  trailer.indexOffset = m_pos;
+  trailer.chunks = m_chunkOffsets.size();
+  trailer.rows = m_rows;
+  std::memcpy(trailer.magic, "NS3GYMTE", 8);
+  fwrite(m_chunkOffsets.data(), sizeof(uint64_t), m_chunkOffsets.size(), m_file);
+  fwrite(&trailer, sizeof(trailer), 1, m_file);
+  fclose(m_file);
+  m_file = nullptr;
+  NS_LOG_INFO("Recorded " << m_rows << " transitions in " << m_chunkOffsets.size() << " chunks to " << m_fileName);
+}
+
+} // end of namespace ns3
@@ -0,0 +1,159 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef OPENGYM_TRANSITION_RECORDER_H
+#define OPENGYM_TRANSITION_RECORDER_H
+
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdint.h>
+#include "ns3/object.h"
+
+namespace ns3 {
+
+class OpenGymDataContainer;
+
+/*
+ * Records the steps of the gym envs as dataset for offline training.
+ *
+ * A row is one step as exchanged with the agent: env id, step, observation,
+ * the action the agent answered with, and reward and game over of the state.
+ * The reward of an action is thus the one of the next row of the same env.
+ * Observations and actions are stored as flat arrays of the box shape (a
+ * discrete action as uint32); a missing action is stored as zeros. Recording
+ * stops with a warning if the type or shape changes.
+ *
+ * The file is columnar and chunked (native byte order; read by
+ * ns3gym/transitions.py):
+ *   FileHeader | chunk | chunk | ... | uint64 chunk offsets | Trailer
+ * A chunk is a ChunkHeader followed by one blob per column, each starting at
+ * a 64 byte boundary, so uncompressed columns can be used straight from a
+ * memory mapping. Without trailer (crashed run) the chunks can be scanned.
+ */
+class OpenGymTransitionRecorder : public Object
+{
+public:
+  enum Codec
+  {
+    CODEC_NONE = 0,
+    CODEC_ZLIB = 1
+  };
+
+  enum Column
+  {
+    COL_ENV,        // uint32
+    COL_STEP,       // uint64, step of the env
+    COL_OBS,        // observation row
+    COL_ACTION,     // action row
+    COL_REWARD,     // float32
+    COL_DONE,       // uint8
+    N_COLUMNS
+  };
+
+  static const uint32_t MAX_DIMS = 8;
+
+  struct FileHeader
+  {
+    char magic[8];
+    uint32_t version;
+    uint32_t codec;
+    uint32_t chunkRows;
+    uint32_t obsDtype;
+    uint32_t obsItemSize;
+    uint32_t obsNdim;
+    uint32_t obsShape[MAX_DIMS];
+    uint32_t actDtype;
+    uint32_t actItemSize;
+    uint32_t actNdim;
+    uint32_t actShape[MAX_DIMS];
+    uint32_t reserved;
+  };
+
+  struct ChunkHeader
+  {
+    char magic[8];
+    uint64_t rows;
+    uint64_t offset[N_COLUMNS];    // of the column blob from the chunk start
+    uint64_t size[N_COLUMNS];      // stored bytes
+    uint64_t rawSize[N_COLUMNS];   // bytes after decompression
+  };
+
+  struct Trailer
+  {
+    uint64_t indexOffset;
+    uint64_t chunks;
+    uint64_t rows;
+    char magic[8];
+  };
+
+  static TypeId GetTypeId ();
+
+  OpenGymTransitionRecorder ();
+  virtual ~OpenGymTransitionRecorder ();
+
+  // recording is on if FileName is set
+  bool IsEnabled (void) const;
+
+  void Record (uint32_t env, Ptr<OpenGymDataContainer> obs, Ptr<OpenGymDataContainer> action, float reward, bool done);
+
+  // write the buffered rows and the chunk index
+  void Close (void);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  struct RowType
+  {
+    uint32_t dtype = 0;
+    uint32_t itemSize = 0;
+    std::vector<uint32_t> shape;
+    size_t rowSize = 0;
+  };
+
+  // the type of a column is the one of its first container
+  bool GetRow (Ptr<OpenGymDataContainer> data, RowType &type, bool &typeKnown, std::vector<uint8_t> &column, const char *what);
+  void WriteChunk (void);
+  void WriteColumn (Column column, const std::vector<uint8_t> &data, ChunkHeader &header, uint64_t chunkStart);
+  void Pad (uint64_t to);
+
+  std::string m_fileName;
+  uint32_t m_chunkRows;
+  uint32_t m_compressionLevel;
+
+  FILE *m_file;
+  uint64_t m_pos;
+  uint64_t m_rows;
+  std::vector<uint64_t> m_chunkOffsets;
+  bool m_closed;
+
+  RowType m_obsType;
+  RowType m_actType;
+  bool m_obsTypeKnown;
+  bool m_actTypeKnown;
+  std::vector<uint64_t> m_envSteps;
+
+  // rows of the current chunk, one buffer per column
+  uint64_t m_chunkRowCount;
+  std::vector<uint8_t> m_columns[N_COLUMNS];
+  std::vector<uint8_t> m_compressed;
+};
+
+} // end of namespace ns3
+
+#endif /* OPENGYM_TRANSITION_RECORDER_H */
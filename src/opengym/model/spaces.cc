@@ -212,6 +212,13 @@ OpenGymBoxSpace::GetShape()
   return m_shape;
 }
 
+std::string
+OpenGymBoxSpace::GetDtypeName()
+{
+  NS_LOG_FUNCTION (this);
+  return m_dtypeName;
+}
+
 ns3opengym::SpaceDescription
 OpenGymBoxSpace::GetSpaceDescription()
 {
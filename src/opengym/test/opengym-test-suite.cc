@@ -1,68 +1,1438 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
 
-// Include a header file from your module to test.
-#include "ns3/opengym.h"
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <semaphore.h>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <zmq.hpp>
 
-// An essential include is test.h
+#include "ns3/boolean.h"
+#include "ns3/enum.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/simulator.h"
+#include "ns3/opengym-module.h"
+#include "ns3/opengym_shm.h"
+#include "ns3/opengym_step_log.h"
+#include "ns3/opengym_transition_recorder.h"
 #include "ns3/test.h"
 
-// Do not put your test classes in namespace ns3.  You may find it useful
-// to use the using directive to access the ns3 namespace directly
 using namespace ns3;
 
-// This is an example TestCase.
-class OpengymTestCase1 : public TestCase
+namespace {
+
+/// Box of floats with the given shape and values.
+Ptr<OpenGymBoxContainer<float> >
+MakeFloatBox (std::vector<uint32_t> shape, std::vector<float> values)
+{
+  Ptr<OpenGymBoxContainer<float> > box = CreateObject<OpenGymBoxContainer<float> > (shape);
+  box->SetData (values);
+  return box;
+}
+
+/// Discrete container with the given value.
+Ptr<OpenGymDiscreteContainer>
+MakeDiscrete (uint32_t value)
+{
+  Ptr<OpenGymDiscreteContainer> discrete = CreateObject<OpenGymDiscreteContainer> (16);
+  discrete->SetValue (value);
+  return discrete;
+}
+
+/// Action message of the agent with a discrete action.
+ns3opengym::EnvActMsg
+MakeActMsg (uint32_t value)
+{
+  ns3opengym::EnvActMsg msg;
+  *msg.mutable_actdata () = MakeDiscrete (value)->GetDataContainerPbMsg ();
+  return msg;
+}
+
+/// Value of a discrete action, or -1 for anything else.
+int64_t
+GetDiscreteValue (Ptr<OpenGymDataContainer> action)
+{
+  Ptr<OpenGymDiscreteContainer> discrete = DynamicCast<OpenGymDiscreteContainer> (action);
+  return discrete ? int64_t (discrete->GetValue ()) : -1;
+}
+
+/// Box of a protobuf data container, empty if it is none.
+ns3opengym::BoxDataContainer
+GetBox (const ns3opengym::DataContainer &container)
+{
+  ns3opengym::BoxDataContainer box;
+  if (container.type () == ns3opengym::Box)
+    {
+      container.data ().UnpackTo (&box);
+    }
+  return box;
+}
+
+/// Float values of the observation of a state message.
+std::vector<float>
+GetFloatObs (const ns3opengym::EnvStateMsg &state)
+{
+  ns3opengym::BoxDataContainer box = GetBox (state.obsdata ());
+  return std::vector<float> (box.floatdata ().begin (), box.floatdata ().end ());
+}
+
+/// Content of a file.
+std::string
+ReadFile (const std::string &name)
+{
+  std::ifstream file (name.c_str (), std::ios::binary);
+  return std::string (std::istreambuf_iterator<char> (file), std::istreambuf_iterator<char> ());
+}
+
+/// Value of type T at a byte offset, e.g. of a file or the shared memory.
+template <typename T>
+T
+ReadAt (const void *data, size_t offset)
+{
+  T value;
+  std::memcpy (&value, static_cast<const uint8_t*> (data) + offset, sizeof (T));
+  return value;
+}
+
+/// Value of type T written at a byte offset.
+template <typename T>
+void
+WriteAt (void *data, size_t offset, T value)
+{
+  std::memcpy (static_cast<uint8_t*> (data) + offset, &value, sizeof (T));
+}
+
+} // unnamed namespace
+
+/**
+ * \ingroup opengym-test
+ * \ingroup tests
+ *
+ * \brief Gym env with a state set by the test
+ */
+class GymTestEnv : public OpenGymEnv
+{
+public:
+  GymTestEnv ();
+
+  virtual Ptr<OpenGymSpace> GetActionSpace (void);
+  virtual Ptr<OpenGymSpace> GetObservationSpace (void);
+  virtual bool GetGameOver (void);
+  virtual Ptr<OpenGymDataContainer> GetObservation (void);
+  virtual float GetReward (void);
+  virtual std::string GetExtraInfo (void);
+  virtual bool ExecuteActions (Ptr<OpenGymDataContainer> action);
+
+  /// \copydoc OpenGymEnv::SetCachedFields
+  void SetCached (uint32_t fields);
+  /// \copydoc OpenGymEnv::MarkFieldsChanged
+  void MarkChanged (uint32_t fields);
+
+  Ptr<OpenGymDataContainer> m_obs;                 ///< observation
+  float m_reward;                                  ///< reward
+  bool m_gameOver;                                 ///< game over
+  std::string m_info;                              ///< extra info
+  uint32_t m_obsCalls;                             ///< calls of GetObservation
+  uint32_t m_infoCalls;                            ///< calls of GetExtraInfo
+  std::vector<Ptr<OpenGymDataContainer> > m_actions; ///< executed actions
+};
+
+GymTestEnv::GymTestEnv ()
+  : m_reward (0.0),
+    m_gameOver (false),
+    m_obsCalls (0),
+    m_infoCalls (0)
+{
+}
+
+Ptr<OpenGymSpace>
+GymTestEnv::GetActionSpace (void)
+{
+  return CreateObject<OpenGymDiscreteSpace> (16);
+}
+
+Ptr<OpenGymSpace>
+GymTestEnv::GetObservationSpace (void)
+{
+  return CreateObject<OpenGymBoxSpace> (0.0, 10.0, std::vector<uint32_t> (1, 2), "float");
+}
+
+bool
+GymTestEnv::GetGameOver (void)
+{
+  return m_gameOver;
+}
+
+Ptr<OpenGymDataContainer>
+GymTestEnv::GetObservation (void)
+{
+  ++m_obsCalls;
+  return m_obs;
+}
+
+float
+GymTestEnv::GetReward (void)
+{
+  return m_reward;
+}
+
+std::string
+GymTestEnv::GetExtraInfo (void)
+{
+  ++m_infoCalls;
+  return m_info;
+}
+
+bool
+GymTestEnv::ExecuteActions (Ptr<OpenGymDataContainer> action)
+{
+  m_actions.push_back (action);
+  return true;
+}
+
+void
+GymTestEnv::SetCached (uint32_t fields)
+{
+  SetCachedFields (fields);
+}
+
+void
+GymTestEnv::MarkChanged (uint32_t fields)
+{
+  MarkFieldsChanged (fields);
+}
+
+/**
+ * \ingroup opengym-test
+ * \ingroup tests
+ *
+ * \brief Agent answering the requests of an OpenGymInterface with prepared replies
+ *
+ * The agent binds a REP socket like ns3gym and records the frames of every
+ * request. The first reply answers the SimInitMsg.
+ */
+class GymTestAgent
+{
+public:
+  /**
+   * Bind to a port and prepare the init ack.
+   * \param port port of the OpenGymInterface
+   */
+  GymTestAgent (uint32_t port);
+  ~GymTestAgent ();
+
+  /**
+   * Queue the reply to the next request.
+   * \param reply the reply
+   */
+  void AddReply (const google::protobuf::Message &reply);
+
+  /// Send the replies after the init ack only once released, e.g. to let an async agent be busy.
+  void HoldReplies (void);
+
+  /// Let the next held reply go.
+  void ReleaseReply (void);
+
+  /**
+   * Wait until replies were sent.
+   * \param replies number of replies including the init ack
+   */
+  void WaitForReplies (uint32_t replies);
+
+  /// Answer the requests in a thread.
+  void Start (void);
+
+  /// Wait until all replies are sent, or no more requests came for a while.
+  void Stop (void);
+
+  /// \return the number of requests received so far
+  uint32_t GetNRequests (void);
+
+  /**
+   * \param request index of the request
+   * \return the frames of the request
+   */
+  std::vector<std::string> GetRequest (uint32_t request);
+
+  /**
+   * \param request index of the request
+   * \param frame index of the frame
+   * \return the frame parsed as message M
+   */
+  template <typename M>
+  M GetMessage (uint32_t request, uint32_t frame = 0)
+  {
+    M msg;
+    std::vector<std::string> frames = GetRequest (request);
+    if (frame < frames.size ())
+      {
+        msg.ParseFromString (frames[frame]);
+      }
+    return msg;
+  }
+
+private:
+  /// Receive the requests and send the replies.
+  void Run (void);
+
+  zmq::context_t m_context;                          ///< zmq context
+  zmq::socket_t m_socket;                            ///< REP socket
+  std::vector<std::string> m_replies;                ///< serialized replies
+  std::vector<std::vector<std::string> > m_requests; ///< frames of the requests
+  bool m_hold;                                       ///< replies wait for ReleaseReply
+  uint32_t m_released;                               ///< replies released
+  uint32_t m_sent;                                   ///< replies sent
+  std::mutex m_mutex;                                ///< guards the requests and reply counters
+  std::condition_variable m_cv;                      ///< signals released and sent replies
+  std::thread m_thread;                              ///< thread of Run
+};
+
+GymTestAgent::GymTestAgent (uint32_t port)
+  : m_context (1),
+    m_socket (m_context, ZMQ_REP),
+    m_hold (false),
+    m_released (0),
+    m_sent (0)
+{
+  m_socket.setsockopt (ZMQ_RCVTIMEO, 10000);
+  m_socket.bind ("tcp://*:" + std::to_string (port));
+  ns3opengym::SimInitAck ack;
+  ack.set_done (true);
+  ack.set_agentprocessid (::getpid ());
+  AddReply (ack);
+}
+
+GymTestAgent::~GymTestAgent ()
+{
+  Stop ();
+}
+
+void
+GymTestAgent::AddReply (const google::protobuf::Message &reply)
+{
+  m_replies.push_back (reply.SerializeAsString ());
+}
+
+void
+GymTestAgent::HoldReplies (void)
+{
+  m_hold = true;
+}
+
+void
+GymTestAgent::ReleaseReply (void)
+{
+  std::lock_guard<std::mutex> lock (m_mutex);
+  ++m_released;
+  m_cv.notify_all ();
+}
+
+void
+GymTestAgent::WaitForReplies (uint32_t replies)
+{
+  std::unique_lock<std::mutex> lock (m_mutex);
+  m_cv.wait_for (lock, std::chrono::seconds (10), [this, replies] () { return m_sent >= replies; });
+}
+
+void
+GymTestAgent::Start (void)
+{
+  m_thread = std::thread (&GymTestAgent::Run, this);
+}
+
+void
+GymTestAgent::Stop (void)
+{
+  if (m_thread.joinable ())
+    {
+      m_thread.join ();
+    }
+}
+
+uint32_t
+GymTestAgent::GetNRequests (void)
+{
+  std::lock_guard<std::mutex> lock (m_mutex);
+  return m_requests.size ();
+}
+
+std::vector<std::string>
+GymTestAgent::GetRequest (uint32_t request)
+{
+  std::lock_guard<std::mutex> lock (m_mutex);
+  return request < m_requests.size () ? m_requests[request] : std::vector<std::string> ();
+}
+
+void
+GymTestAgent::Run (void)
+{
+  for (const std::string &reply : m_replies)
+    {
+      std::vector<std::string> frames;
+      zmq::message_t frame;
+      do
+        {
+          if (!m_socket.recv (&frame))
+            {
+              return;
+            }
+          frames.push_back (std::string (static_cast<const char*> (frame.data ()), frame.size ()));
+        }
+      while (frame.more ());
+      {
+        std::unique_lock<std::mutex> lock (m_mutex);
+        m_requests.push_back (frames);
+        if (m_hold && m_sent > 0)
+          {
+            m_cv.wait_for (lock, std::chrono::seconds (10), [this] () { return m_released >= m_sent; });
+          }
+      }
+      zmq::message_t message (reply.data (), reply.size ());
+      m_socket.send (message);
+      std::lock_guard<std::mutex> lock (m_mutex);
+      ++m_sent;
+      m_cv.notify_all ();
+    }
+}
+
+/**
+ * \ingroup opengym-test
+ * \ingroup tests
+ *
+ * \brief Raw tensor representation of data containers
+ */
+class OpenGymRawTensorTestCase : public TestCase
 {
 public:
-  OpengymTestCase1 ();
-  virtual ~OpengymTestCase1 ();
+  OpenGymRawTensorTestCase ();
 
 private:
   virtual void DoRun (void);
+
+  /**
+   * Check that a box survives GetRawTensor and CreateFromRawTensor.
+   * \param shape shape of the box, empty for a flat one
+   * \param values values of the box
+   * \param dtype expected dtype
+   */
+  template <typename T>
+  void CheckRoundTrip (std::vector<uint32_t> shape, std::vector<T> values, ns3opengym::Dtype dtype);
 };
 
-// Add some help text to this case to describe what it is intended to test
-OpengymTestCase1::OpengymTestCase1 ()
-  : TestCase ("Opengym test case (does nothing)")
+OpenGymRawTensorTestCase::OpenGymRawTensorTestCase ()
+  : TestCase ("Check that boxes survive the raw tensor round-trip")
 {
 }
 
-// This destructor does nothing but we include it as a reminder that
-// the test case should clean up after itself
-OpengymTestCase1::~OpengymTestCase1 ()
+template <typename T>
+void
+OpenGymRawTensorTestCase::CheckRoundTrip (std::vector<uint32_t> shape, std::vector<T> values, ns3opengym::Dtype dtype)
 {
+  Ptr<OpenGymBoxContainer<T> > box = CreateObject<OpenGymBoxContainer<T> > (shape);
+  box->SetData (values);
+
+  ns3opengym::RawTensor header;
+  const uint8_t *data = nullptr;
+  size_t size = 0;
+  NS_TEST_ASSERT_MSG_EQ (box->GetRawTensor (header, data, size), true, "box without raw tensor");
+  NS_TEST_EXPECT_MSG_EQ (header.dtype (), dtype, "dtype of the raw tensor");
+  NS_TEST_EXPECT_MSG_EQ (header.itemsize (), sizeof (T), "item size of the raw tensor");
+  NS_TEST_EXPECT_MSG_EQ (size, values.size () * sizeof (T), "bytes of the raw tensor");
+  NS_TEST_EXPECT_MSG_EQ (std::memcmp (data, values.data (), size), 0, "data of the raw tensor");
+  // a box without shape goes as flat vector
+  std::vector<uint32_t> expectedShape = shape.empty () ? std::vector<uint32_t> (1, values.size ()) : shape;
+  NS_TEST_EXPECT_MSG_EQ (std::equal (header.shape ().begin (), header.shape ().end (), expectedShape.begin ())
+                         && header.shape_size () == int (expectedShape.size ()), true, "shape of the raw tensor");
+
+  Ptr<OpenGymBoxContainer<T> > copy = DynamicCast<OpenGymBoxContainer<T> > (OpenGymDataContainer::CreateFromRawTensor (header, data, size));
+  NS_TEST_ASSERT_MSG_NE (copy, 0, "box of another element type");
+  NS_TEST_EXPECT_MSG_EQ ((copy->GetData () == values), true, "data after the round-trip");
+  NS_TEST_EXPECT_MSG_EQ ((copy->GetShape () == expectedShape), true, "shape after the round-trip");
 }
 
-//
-// This method is the pure virtual method from class TestCase that every
-// TestCase must implement
-//
 void
-OpengymTestCase1::DoRun (void)
+OpenGymRawTensorTestCase::DoRun (void)
 {
-  // A wide variety of test macros are available in src/core/test.h
-  NS_TEST_ASSERT_MSG_EQ (true, true, "true doesn't equal true for some reason");
-  // Use this one for floating point comparisons
-  NS_TEST_ASSERT_MSG_EQ_TOL (0.01, 0.01, 0.001, "Numbers are not equal within tolerance");
+  std::vector<uint32_t> shape;
+  shape.push_back (2);
+  shape.push_back (3);
+  CheckRoundTrip<int32_t> (shape, {-3, -2, -1, 0, 1, 2147483647}, ns3opengym::INT);
+  CheckRoundTrip<uint32_t> (shape, {0, 1, 2, 3, 4, 4294967295u}, ns3opengym::UINT);
+  CheckRoundTrip<float> (shape, {0.5f, -1.25f, 3e38f, 0.0f, 1e-30f, 7.0f}, ns3opengym::FLOAT);
+  CheckRoundTrip<double> (shape, {0.5, -1.25, 1e300, 0.0, 1e-300, 7.0}, ns3opengym::DOUBLE);
+  CheckRoundTrip<float> (std::vector<uint32_t> (), {1.0f, 2.0f, 3.0f}, ns3opengym::FLOAT);
+
+  // discrete containers have no raw tensor representation
+  ns3opengym::RawTensor header;
+  const uint8_t *data = nullptr;
+  size_t size = 0;
+  NS_TEST_EXPECT_MSG_EQ (MakeDiscrete (3)->GetRawTensor (header, data, size), false, "raw tensor of a discrete container");
+
+  // element types the protobuf boxes do not have are rejected
+  int64_t wide[] = {1, 2};
+  header.Clear ();
+  header.set_dtype (ns3opengym::INT);
+  header.set_itemsize (sizeof (int64_t));
+  header.add_shape (2);
+  NS_TEST_EXPECT_MSG_EQ (OpenGymDataContainer::CreateFromRawTensor (header, reinterpret_cast<const uint8_t*> (wide), sizeof (wide)),
+                         Ptr<OpenGymDataContainer> (), "box of 64 bit integers");
 }
 
-// The TestSuite class names the TestSuite, identifies what type of TestSuite,
-// and enables the TestCases to be run.  Typically, only the constructor for
-// this class must be defined
-//
-class OpengymTestSuite : public TestSuite
+/**
+ * \ingroup opengym-test
+ * \ingroup tests
+ *
+ * \brief Observations sent as raw tensor frame
+ */
+class OpenGymRawTensorExchangeTestCase : public TestCase
 {
 public:
-  OpengymTestSuite ();
+  OpenGymRawTensorExchangeTestCase ();
+
+private:
+  virtual void DoRun (void);
 };
 
-OpengymTestSuite::OpengymTestSuite ()
-  : TestSuite ("opengym", UNIT)
+OpenGymRawTensorExchangeTestCase::OpenGymRawTensorExchangeTestCase ()
+  : TestCase ("Check the raw tensor header and data frame of a box observation")
+{
+}
+
+void
+OpenGymRawTensorExchangeTestCase::DoRun (void)
+{
+  const uint32_t port = 15561;
+  GymTestAgent agent (port);
+  agent.AddReply (MakeActMsg (1));
+  agent.AddReply (ns3opengym::EnvActMsg ());
+  agent.Start ();
+
+  Ptr<OpenGymInterface> openGym = CreateObject<OpenGymInterface> (port);
+  openGym->SetAttribute ("RawTensor", BooleanValue (true));
+  Ptr<GymTestEnv> env = CreateObject<GymTestEnv> ();
+  env->SetOpenGymInterface (openGym);
+  std::vector<float> values = {1.0f, 2.0f, 3.0f, 4.0f};
+  env->m_obs = MakeFloatBox ({2, 2}, values);
+  env->m_reward = 0.5;
+  env->Notify ();
+  env->NotifySimulationEnd ();
+  agent.Stop ();
+
+  NS_TEST_ASSERT_MSG_EQ (agent.GetNRequests (), 3, "init, state and final state");
+  NS_TEST_EXPECT_MSG_EQ (agent.GetMessage<ns3opengym::SimInitMsg> (0).rawtensor (), true, "raw tensor mode in the init message");
+
+  // the header in the state message, the little-endian data in the next frame
+  std::vector<std::string> frames = agent.GetRequest (1);
+  NS_TEST_ASSERT_MSG_EQ (frames.size (), 2, "frames of a raw tensor state");
+  ns3opengym::EnvStateMsg state = agent.GetMessage<ns3opengym::EnvStateMsg> (1);
+  NS_TEST_EXPECT_MSG_EQ (state.has_obsdata (), false, "protobuf observation in raw tensor mode");
+  NS_TEST_ASSERT_MSG_EQ (state.has_obstensor (), true, "raw tensor header");
+  NS_TEST_EXPECT_MSG_EQ (state.obstensor ().dtype (), ns3opengym::FLOAT, "dtype of the raw tensor");
+  NS_TEST_EXPECT_MSG_EQ (state.obstensor ().itemsize (), 4, "item size of the raw tensor");
+  NS_TEST_ASSERT_MSG_EQ (state.obstensor ().shape_size (), 2, "dimensions of the raw tensor");
+  NS_TEST_EXPECT_MSG_EQ (state.obstensor ().shape (0), 2, "first dimension of the raw tensor");
+  NS_TEST_EXPECT_MSG_EQ (state.reward (), 0.5, "reward");
+  NS_TEST_ASSERT_MSG_EQ (frames[1].size (), 16, "bytes of the data frame");
+  // 1.0f is 00 00 80 3f in little-endian
+  NS_TEST_EXPECT_MSG_EQ (uint32_t (uint8_t (frames[1][3])), 0x3f, "last byte of the first value");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<float> (frames[1].data (), 12), 4.0f, "last value");
+
+  NS_TEST_EXPECT_MSG_EQ (agent.GetMessage<ns3opengym::EnvStateMsg> (2).isgameover (), true, "game over at the simulation end");
+  NS_TEST_ASSERT_MSG_EQ (env->m_actions.size (), 1, "executed actions");
+  NS_TEST_EXPECT_MSG_EQ (GetDiscreteValue (env->m_actions[0]), 1, "action");
+
+  openGym->Dispose ();
+  env->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup opengym-test
+ * \ingroup tests
+ *
+ * \brief Slots of the shared memory channel as ns3gym/shm_channel.py reads them
+ */
+class OpenGymShmLayoutTestCase : public TestCase
+{
+public:
+  OpenGymShmLayoutTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+OpenGymShmLayoutTestCase::OpenGymShmLayoutTestCase ()
+  : TestCase ("Check the shared memory layout against shm_channel.py")
+{
+}
+
+void
+OpenGymShmLayoutTestCase::DoRun (void)
+{
+  typedef OpenGymShmChannel::ShmSlotHeader Slot;
+  // _SLOT = struct.Struct('<IIfIIII8III')
+  NS_TEST_EXPECT_MSG_EQ (offsetof (Slot, reward), 8, "offset of the reward");
+  NS_TEST_EXPECT_MSG_EQ (offsetof (Slot, ndim), 24, "offset of the dimensions");
+  NS_TEST_EXPECT_MSG_EQ (offsetof (Slot, shape), 28, "offset of the shape");
+  NS_TEST_EXPECT_MSG_EQ (offsetof (Slot, dataSize), 60, "offset of the data size");
+  NS_TEST_EXPECT_MSG_EQ (offsetof (Slot, infoSize), 64, "offset of the info size");
+  NS_TEST_EXPECT_MSG_EQ (sizeof (Slot), 68, "size of the slot header");
+
+  OpenGymShmChannel channel;
+  channel.Create (15562, 1000, 0);
+  int fd = shm_open (channel.GetName ().c_str (), O_RDWR, 0);
+  NS_TEST_ASSERT_MSG_NE (fd, -1, "shared memory not found by name");
+  void *mapped = mmap (nullptr, channel.GetSize (), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close (fd);
+  channel.Unlink ();
+  NS_TEST_ASSERT_MSG_NE (mapped, MAP_FAILED, "shared memory not mapped");
+  uint8_t *base = static_cast<uint8_t*> (mapped);
+
+  // _HEADER = struct.Struct('<8sIIIIII'); slots of 128 header bytes and the slot size rounded to 64
+  NS_TEST_EXPECT_MSG_EQ (std::string (reinterpret_cast<const char*> (base), 8), std::string ("NS3GYM\0\0", 8), "magic");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint32_t> (base, 8), 1, "version");
+  uint32_t stateSem = ReadAt<uint32_t> (base, 12);
+  uint32_t actSem = ReadAt<uint32_t> (base, 16);
+  uint32_t stateSlot = ReadAt<uint32_t> (base, 20);
+  uint32_t actSlot = ReadAt<uint32_t> (base, 24);
+  NS_TEST_EXPECT_MSG_EQ (stateSem, 64, "offset of the state semaphore");
+  NS_TEST_EXPECT_MSG_EQ (actSem, 128, "offset of the action semaphore");
+  NS_TEST_EXPECT_MSG_EQ (stateSlot, 192, "offset of the state slot");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint32_t> (base, 28), 1024, "slot size");
+  NS_TEST_EXPECT_MSG_EQ (actSlot, 192 + 128 + 1024, "offset of the action slot");
+  NS_TEST_EXPECT_MSG_EQ (channel.GetSize (), actSlot + 128 + 1024, "size of the shared memory");
+
+  // a box goes as raw tensor, followed by the info
+  channel.SendState (MakeFloatBox ({2}, {1.5f, -2.0f}), 0.25, true, false, "info");
+  NS_TEST_EXPECT_MSG_EQ (sem_trywait (reinterpret_cast<sem_t*> (base + stateSem)), 0, "state semaphore not posted");
+  uint8_t *slot = base + stateSlot;
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint32_t> (slot, 0), 1, "sequence number");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint32_t> (slot, 4), OpenGymShmChannel::GAME_OVER, "flags");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<float> (slot, 8), 0.25, "reward");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint32_t> (slot, 12), OpenGymShmChannel::RAW_TENSOR, "data kind");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint32_t> (slot, 16), ns3opengym::FLOAT, "dtype");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint32_t> (slot, 20), 4, "item size");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint32_t> (slot, 24), 1, "dimensions");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint32_t> (slot, 28), 2, "shape");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint32_t> (slot, 60), 8, "data size");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint32_t> (slot, 64), 4, "info size");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<float> (slot, 128), 1.5, "first value");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<float> (slot, 132), -2.0, "second value");
+  NS_TEST_EXPECT_MSG_EQ (std::string (reinterpret_cast<const char*> (slot + 136), 4), "info", "info after the data");
+
+  // anything else as serialized container
+  channel.SendState (MakeDiscrete (3), 0.0, false, true, "");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint32_t> (slot, 0), 2, "sequence number of the next state");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint32_t> (slot, 4), OpenGymShmChannel::SIMULATION_END, "flags at the simulation end");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint32_t> (slot, 12), OpenGymShmChannel::PB_CONTAINER, "data kind of a discrete observation");
+  ns3opengym::DataContainer container;
+  NS_TEST_EXPECT_MSG_EQ (container.ParseFromArray (slot + 128, ReadAt<uint32_t> (slot, 60)), true, "serialized container");
+  NS_TEST_EXPECT_MSG_EQ (container.type (), ns3opengym::Discrete, "type of the serialized container");
+
+  // actions as Ns3ShmChannel.send_action writes them
+  slot = base + actSlot;
+  std::memset (slot, 0, 128);
+  WriteAt<uint32_t> (slot, 0, 1);
+  WriteAt<uint32_t> (slot, 12, OpenGymShmChannel::DISCRETE);
+  WriteAt<uint32_t> (slot, 24, 1);
+  WriteAt<uint32_t> (slot, 28, 4);
+  sem_post (reinterpret_cast<sem_t*> (base + actSem));
+  bool stopSim = true;
+  Ptr<OpenGymDataContainer> action;
+  channel.ReceiveAction (stopSim, action);
+  NS_TEST_EXPECT_MSG_EQ (stopSim, false, "stop without flag");
+  NS_TEST_EXPECT_MSG_EQ (GetDiscreteValue (action), 4, "discrete action");
+
+  int32_t values[] = {7, -8};
+  WriteAt<uint32_t> (slot, 0, 2);
+  WriteAt<uint32_t> (slot, 4, OpenGymShmChannel::STOP_SIM);
+  WriteAt<uint32_t> (slot, 12, OpenGymShmChannel::RAW_TENSOR);
+  WriteAt<uint32_t> (slot, 16, ns3opengym::INT);
+  WriteAt<uint32_t> (slot, 20, sizeof (int32_t));
+  WriteAt<uint32_t> (slot, 28, 2);
+  WriteAt<uint32_t> (slot, 60, sizeof (values));
+  std::memcpy (slot + 128, values, sizeof (values));
+  sem_post (reinterpret_cast<sem_t*> (base + actSem));
+  channel.ReceiveAction (stopSim, action);
+  NS_TEST_EXPECT_MSG_EQ (stopSim, true, "stop flag");
+  Ptr<OpenGymBoxContainer<int32_t> > box = DynamicCast<OpenGymBoxContainer<int32_t> > (action);
+  NS_TEST_ASSERT_MSG_NE (box, 0, "box action");
+  NS_TEST_EXPECT_MSG_EQ ((box->GetData () == std::vector<int32_t> ({7, -8})), true, "values of the box action");
+
+  munmap (mapped, channel.GetSize ());
+}
+
+/**
+ * \ingroup opengym-test
+ * \ingroup tests
+ *
+ * \brief Several envs stepping in batched messages
+ */
+class OpenGymBatchTestCase : public TestCase
+{
+public:
+  OpenGymBatchTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+OpenGymBatchTestCase::OpenGymBatchTestCase ()
+  : TestCase ("Check that batched envs step together and envs that are done drop out")
+{
+}
+
+void
+OpenGymBatchTestCase::DoRun (void)
+{
+  const uint32_t port = 15563;
+  GymTestAgent agent (port);
+  for (uint32_t step = 1; step <= 3; ++step)
+    {
+      ns3opengym::EnvActBatchMsg actions;
+      *actions.add_action () = MakeActMsg (10 * step);
+      *actions.add_action () = MakeActMsg (10 * step + 1);
+      agent.AddReply (actions);
+    }
+  agent.AddReply (ns3opengym::EnvActBatchMsg ());
+  agent.Start ();
+
+  Ptr<OpenGymInterface> openGym = CreateObject<OpenGymInterface> (port);
+  Ptr<GymTestEnv> env0 = CreateObject<GymTestEnv> ();
+  Ptr<GymTestEnv> env1 = CreateObject<GymTestEnv> ();
+  env0->AddToOpenGymInterface (openGym);
+  env1->AddToOpenGymInterface (openGym);
+  NS_TEST_ASSERT_MSG_EQ (openGym->GetNEnvs (), 2, "envs of the interface");
+  env0->m_obs = MakeFloatBox ({1}, {0.0f});
+  env1->m_obs = MakeFloatBox ({1}, {1.0f});
+  env1->m_reward = 1.0;
+  env1->m_info = "env1";
+
+  // the batch goes out once every env notified
+  env0->Notify ();
+  NS_TEST_EXPECT_MSG_EQ (env0->m_actions.size (), 0, "action before the batch is complete");
+  env1->Notify ();
+  NS_TEST_ASSERT_MSG_EQ (agent.GetNRequests (), 2, "init and the first batch");
+  ns3opengym::SimInitMsg init = agent.GetMessage<ns3opengym::SimInitMsg> (0);
+  NS_TEST_EXPECT_MSG_EQ (init.numenvs (), 2, "envs in the init message");
+  NS_TEST_EXPECT_MSG_EQ (init.has_obsspace (), true, "observation space of the envs");
+  ns3opengym::EnvStateBatchMsg batch = agent.GetMessage<ns3opengym::EnvStateBatchMsg> (1);
+  NS_TEST_ASSERT_MSG_EQ (batch.state_size (), 2, "states in the batch");
+  NS_TEST_EXPECT_MSG_EQ ((GetFloatObs (batch.state (0)) == std::vector<float> (1, 0.0f)), true, "observation of env 0");
+  NS_TEST_EXPECT_MSG_EQ ((GetFloatObs (batch.state (1)) == std::vector<float> (1, 1.0f)), true, "observation of env 1");
+  NS_TEST_EXPECT_MSG_EQ (batch.state (1).reward (), 1.0, "reward of env 1");
+  NS_TEST_EXPECT_MSG_EQ (batch.state (1).info (), "env1", "info of env 1");
+  NS_TEST_ASSERT_MSG_EQ (env0->m_actions.size (), 1, "actions of env 0");
+  NS_TEST_ASSERT_MSG_EQ (env1->m_actions.size (), 1, "actions of env 1");
+  NS_TEST_EXPECT_MSG_EQ (GetDiscreteValue (env0->m_actions[0]), 10, "action of env 0");
+  NS_TEST_EXPECT_MSG_EQ (GetDiscreteValue (env1->m_actions[0]), 11, "action of env 1");
+
+  // env 1 is done: its action is not executed, and the next batches wait for env 0 only
+  env1->m_gameOver = true;
+  env1->Notify ();
+  env0->Notify ();
+  batch = agent.GetMessage<ns3opengym::EnvStateBatchMsg> (2);
+  NS_TEST_ASSERT_MSG_EQ (batch.state_size (), 2, "states in the second batch");
+  NS_TEST_EXPECT_MSG_EQ (batch.state (0).isgameover (), false, "game over of env 0");
+  NS_TEST_EXPECT_MSG_EQ (batch.state (1).isgameover (), true, "game over of env 1");
+  NS_TEST_EXPECT_MSG_EQ (batch.state (1).reason (), ns3opengym::EnvStateMsg::GameOver, "reason of env 1");
+  NS_TEST_EXPECT_MSG_EQ (GetDiscreteValue (env0->m_actions.back ()), 20, "second action of env 0");
+  NS_TEST_EXPECT_MSG_EQ (env1->m_actions.size (), 1, "actions of env 1 after its game over");
+
+  env0->Notify ();
+  NS_TEST_ASSERT_MSG_EQ (agent.GetNRequests (), 4, "batch without the env that is done");
+  batch = agent.GetMessage<ns3opengym::EnvStateBatchMsg> (3);
+  NS_TEST_ASSERT_MSG_EQ (batch.state_size (), 2, "states in the third batch");
+  NS_TEST_EXPECT_MSG_EQ (batch.state (1).obsunchanged (), true, "observation of the env that is done");
+  NS_TEST_EXPECT_MSG_EQ (batch.state (1).has_obsdata (), false, "observation data of the env that is done");
+  NS_TEST_EXPECT_MSG_EQ (GetDiscreteValue (env0->m_actions.back ()), 30, "third action of env 0");
+  NS_TEST_EXPECT_MSG_EQ (env1->m_actions.size (), 1, "actions of env 1 in the third batch");
+
+  env0->NotifySimulationEnd ();
+  agent.Stop ();
+  NS_TEST_ASSERT_MSG_EQ (agent.GetNRequests (), 5, "final batch");
+  batch = agent.GetMessage<ns3opengym::EnvStateBatchMsg> (4);
+  NS_TEST_ASSERT_MSG_EQ (batch.state_size (), 2, "states in the final batch");
+  NS_TEST_EXPECT_MSG_EQ ((batch.state (0).isgameover () && batch.state (1).isgameover ()), true, "game over at the simulation end");
+  NS_TEST_EXPECT_MSG_EQ (batch.state (0).reason (), ns3opengym::EnvStateMsg::SimulationEnd, "reason at the simulation end");
+
+  openGym->Dispose ();
+  env0->Dispose ();
+  env1->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup opengym-test
+ * \ingroup tests
+ *
+ * \brief Async mode: the simulation goes on while the agent is busy
+ *
+ * The agent holds its replies, so the test decides when an action arrives.
+ * The action of the first state arrives at 5 ms and is applied by the poll
+ * at 10 ms; the state at 2 ms is dropped, the one at 12 ms is still in
+ * flight at the simulation end.
+ */
+class OpenGymAsyncTestCase : public TestCase
+{
+public:
+  OpenGymAsyncTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Notify the env with a new observation.
+   * \param value the observation
+   */
+  void Step (float value);
+
+  /// The agent replies to the first state; the action is not applied on arrival.
+  void ArriveAction (void);
+
+  /// Check the action after the first poll.
+  void CheckAction (void);
+
+  /**
+   * ActionLatency trace sink.
+   * \param latency simulated time between the state and its action
+   */
+  void ActionLatency (Time latency);
+
+  GymTestAgent *m_agent;          ///< the agent
+  Ptr<GymTestEnv> m_env;          ///< the env
+  std::vector<Time> m_latencies;  ///< traced latencies
+};
+
+OpenGymAsyncTestCase::OpenGymAsyncTestCase ()
+  : TestCase ("Check that async actions are applied at the next poll and busy agents drop states")
+{
+}
+
+void
+OpenGymAsyncTestCase::Step (float value)
+{
+  m_env->m_obs = MakeFloatBox ({1}, {value});
+  m_env->Notify ();
+  // sending a state applies only actions that arrived before
+  uint32_t actions = Simulator::Now () < MilliSeconds (10) ? 0 : 1;
+  NS_TEST_EXPECT_MSG_EQ (m_env->m_actions.size (), actions, "actions after the state at " << Simulator::Now ().GetMilliSeconds () << " ms");
+}
+
+void
+OpenGymAsyncTestCase::ArriveAction (void)
+{
+  m_agent->ReleaseReply ();
+  m_agent->WaitForReplies (2);
+  // give zmq the time to deliver the reply to the interface
+  std::this_thread::sleep_for (std::chrono::milliseconds (100));
+  NS_TEST_EXPECT_MSG_EQ (m_agent->GetNRequests (), 2, "states sent while the agent was busy");
+  NS_TEST_EXPECT_MSG_EQ (m_env->m_actions.size (), 0, "action applied on arrival");
+  NS_TEST_EXPECT_MSG_EQ (m_latencies.size (), 0, "latency traced on arrival");
+}
+
+void
+OpenGymAsyncTestCase::CheckAction (void)
+{
+  NS_TEST_ASSERT_MSG_EQ (m_env->m_actions.size (), 1, "actions after the first poll");
+  NS_TEST_EXPECT_MSG_EQ (GetDiscreteValue (m_env->m_actions[0]), 1, "action");
+  NS_TEST_ASSERT_MSG_EQ (m_latencies.size (), 1, "latencies after the first poll");
+  NS_TEST_EXPECT_MSG_EQ (m_latencies[0], MilliSeconds (10), "latency of the first action");
+}
+
+void
+OpenGymAsyncTestCase::ActionLatency (Time latency)
+{
+  m_latencies.push_back (latency);
+}
+
+void
+OpenGymAsyncTestCase::DoRun (void)
+{
+  const uint32_t port = 15569;
+  GymTestAgent agent (port);
+  agent.AddReply (MakeActMsg (1));
+  agent.AddReply (MakeActMsg (2));
+  agent.AddReply (ns3opengym::EnvActMsg ());
+  agent.HoldReplies ();
+  agent.Start ();
+  m_agent = &agent;
+
+  Ptr<OpenGymInterface> openGym = CreateObject<OpenGymInterface> (port);
+  openGym->SetAttribute ("Async", BooleanValue (true));
+  openGym->SetAttribute ("AsyncPollInterval", TimeValue (MilliSeconds (10)));
+  openGym->SetAttribute ("AsyncMaxPending", UintegerValue (1));
+  openGym->TraceConnectWithoutContext ("ActionLatency", MakeCallback (&OpenGymAsyncTestCase::ActionLatency, this));
+  m_env = CreateObject<GymTestEnv> ();
+  m_env->SetOpenGymInterface (openGym);
+
+  Simulator::Schedule (MilliSeconds (0), &OpenGymAsyncTestCase::Step, this, 1.0);
+  Simulator::Schedule (MilliSeconds (2), &OpenGymAsyncTestCase::Step, this, 2.0);
+  Simulator::Schedule (MilliSeconds (5), &OpenGymAsyncTestCase::ArriveAction, this);
+  Simulator::Schedule (MilliSeconds (11), &OpenGymAsyncTestCase::CheckAction, this);
+  Simulator::Schedule (MilliSeconds (12), &OpenGymAsyncTestCase::Step, this, 3.0);
+  Simulator::Stop (MilliSeconds (15));
+  Simulator::Run ();
+  if (IsStatusFailure ())
+    {
+      // the replies do not match the states anymore; the final exchange would not return
+      openGym->Dispose ();
+      m_env->Dispose ();
+      Simulator::Destroy ();
+      return;
+    }
+
+  // the action of the state at 12 ms is received, but not applied, before the final state goes out
+  agent.ReleaseReply ();
+  agent.ReleaseReply ();
+  m_env->NotifySimulationEnd ();
+  agent.Stop ();
+
+  NS_TEST_ASSERT_MSG_EQ (agent.GetNRequests (), 4, "init, two states and the final state");
+  ns3opengym::EnvStateMsg state = agent.GetMessage<ns3opengym::EnvStateMsg> (2);
+  NS_TEST_EXPECT_MSG_EQ ((GetFloatObs (state) == std::vector<float> (1, 3.0f)), true, "state sent after the busy one was dropped");
+  state = agent.GetMessage<ns3opengym::EnvStateMsg> (3);
+  NS_TEST_EXPECT_MSG_EQ (state.isgameover (), true, "game over of the final state");
+  NS_TEST_EXPECT_MSG_EQ (state.reason (), ns3opengym::EnvStateMsg::SimulationEnd, "reason of the final state");
+  NS_TEST_EXPECT_MSG_EQ (m_env->m_actions.size (), 1, "actions applied");
+  NS_TEST_ASSERT_MSG_EQ (m_latencies.size (), 2, "latencies including the drained action");
+  NS_TEST_EXPECT_MSG_EQ (m_latencies[1], MilliSeconds (3), "latency of the drained action");
+
+  openGym->Dispose ();
+  m_env->Dispose ();
+  m_env = 0;
+  m_agent = 0;
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup opengym-test
+ * \ingroup tests
+ *
+ * \brief Cached state fields omitted from the state message
+ */
+class OpenGymCachedFieldsTestCase : public TestCase
+{
+public:
+  OpenGymCachedFieldsTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+OpenGymCachedFieldsTestCase::OpenGymCachedFieldsTestCase ()
+  : TestCase ("Check that unchanged observations and infos are neither evaluated nor sent")
+{
+}
+
+void
+OpenGymCachedFieldsTestCase::DoRun (void)
+{
+  const uint32_t port = 15564;
+  GymTestAgent agent (port);
+  for (uint32_t step = 1; step <= 3; ++step)
+    {
+      agent.AddReply (MakeActMsg (step));
+    }
+  agent.AddReply (ns3opengym::EnvActMsg ());
+  agent.Start ();
+
+  Ptr<OpenGymInterface> openGym = CreateObject<OpenGymInterface> (port);
+  Ptr<GymTestEnv> env = CreateObject<GymTestEnv> ();
+  env->SetOpenGymInterface (openGym);
+  env->SetCached (OpenGymEnv::OBSERVATION | OpenGymEnv::EXTRA_INFO);
+  env->m_obs = MakeFloatBox ({2}, {1.0f, 2.0f});
+  env->m_info = "config";
+
+  env->m_reward = 1.0;
+  env->Notify ();
+  ns3opengym::EnvStateMsg state = agent.GetMessage<ns3opengym::EnvStateMsg> (1);
+  NS_TEST_EXPECT_MSG_EQ (state.obsunchanged (), false, "first observation unchanged");
+  NS_TEST_EXPECT_MSG_EQ ((GetFloatObs (state) == std::vector<float> ({1.0f, 2.0f})), true, "first observation");
+  NS_TEST_EXPECT_MSG_EQ (state.infounchanged (), false, "first info unchanged");
+  NS_TEST_EXPECT_MSG_EQ (state.info (), "config", "first info");
+
+  // not marked as changed: the env is not asked, the agent keeps what it got
+  env->m_obs = MakeFloatBox ({2}, {5.0f, 6.0f});
+  env->m_reward = 2.0;
+  env->Notify ();
+  NS_TEST_EXPECT_MSG_EQ (env->m_obsCalls, 1, "evaluations of the cached observation");
+  NS_TEST_EXPECT_MSG_EQ (env->m_infoCalls, 1, "evaluations of the cached info");
+  state = agent.GetMessage<ns3opengym::EnvStateMsg> (2);
+  NS_TEST_EXPECT_MSG_EQ (state.obsunchanged (), true, "cached observation unchanged");
+  NS_TEST_EXPECT_MSG_EQ (state.has_obsdata (), false, "data of an unchanged observation");
+  NS_TEST_EXPECT_MSG_EQ (state.infounchanged (), true, "cached info unchanged");
+  NS_TEST_EXPECT_MSG_EQ (state.info (), "", "unchanged info");
+  NS_TEST_EXPECT_MSG_EQ (state.reward (), 2.0, "reward, which is not cached");
+
+  env->MarkChanged (OpenGymEnv::OBSERVATION);
+  env->Notify ();
+  NS_TEST_EXPECT_MSG_EQ (env->m_obsCalls, 2, "evaluations after the observation changed");
+  state = agent.GetMessage<ns3opengym::EnvStateMsg> (3);
+  NS_TEST_EXPECT_MSG_EQ (state.obsunchanged (), false, "changed observation unchanged");
+  NS_TEST_EXPECT_MSG_EQ ((GetFloatObs (state) == std::vector<float> ({5.0f, 6.0f})), true, "changed observation");
+  NS_TEST_EXPECT_MSG_EQ (state.infounchanged (), true, "info unchanged with a new observation");
+
+  env->NotifySimulationEnd ();
+  agent.Stop ();
+  NS_TEST_ASSERT_MSG_EQ (agent.GetNRequests (), 5, "init, three states and the final state");
+  NS_TEST_EXPECT_MSG_EQ (agent.GetMessage<ns3opengym::EnvStateMsg> (4).obsunchanged (), true, "final observation unchanged");
+  NS_TEST_EXPECT_MSG_EQ (env->m_actions.size (), 3, "executed actions");
+
+  openGym->Dispose ();
+  env->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup opengym-test
+ * \ingroup tests
+ *
+ * \brief Frame skip with the reductions of box observations
+ */
+class OpenGymFrameSkipTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor
+   * \param reduction how the frames are combined
+   * \param name name of the reduction
+   * \param port port of the interface
+   */
+  OpenGymFrameSkipTestCase (OpenGymEnv::FrameReduction reduction, std::string name, uint32_t port);
+
+private:
+  virtual void DoRun (void);
+
+  OpenGymEnv::FrameReduction m_reduction; ///< how the frames are combined
+  uint32_t m_port;                        ///< port of the interface
+};
+
+OpenGymFrameSkipTestCase::OpenGymFrameSkipTestCase (OpenGymEnv::FrameReduction reduction, std::string name, uint32_t port)
+  : TestCase ("Check frame skip with reduction " + name),
+    m_reduction (reduction),
+    m_port (port)
+{
+}
+
+void
+OpenGymFrameSkipTestCase::DoRun (void)
+{
+  GymTestAgent agent (m_port);
+  agent.AddReply (MakeActMsg (7));
+  agent.AddReply (ns3opengym::EnvActMsg ());
+  agent.Start ();
+
+  Ptr<OpenGymInterface> openGym = CreateObject<OpenGymInterface> (m_port);
+  Ptr<GymTestEnv> env = CreateObject<GymTestEnv> ();
+  env->SetAttribute ("FrameSkip", UintegerValue (3));
+  env->SetAttribute ("FrameReduction", EnumValue (m_reduction));
+  env->SetOpenGymInterface (openGym);
+
+  // the agent is asked on the third frame only
+  for (uint32_t frame = 0; frame < 3; ++frame)
+    {
+      NS_TEST_EXPECT_MSG_EQ (agent.GetNRequests (), 0, "requests before frame " << frame);
+      env->m_obs = MakeFloatBox ({2}, {2.0f * frame + 1, 2.0f * frame + 2});
+      env->m_reward = frame + 1;
+      env->Notify ();
+    }
+  NS_TEST_ASSERT_MSG_EQ (agent.GetNRequests (), 2, "init and one state after three frames");
+  NS_TEST_ASSERT_MSG_EQ (env->m_actions.size (), 1, "actions after the first step");
+
+  // the action is repeated on the frames until the next step
+  env->m_obs = MakeFloatBox ({2}, {7.0f, 8.0f});
+  env->Notify ();
+  NS_TEST_ASSERT_MSG_EQ (env->m_actions.size (), 2, "actions after a skipped frame");
+  NS_TEST_EXPECT_MSG_EQ (GetDiscreteValue (env->m_actions[1]), 7, "repeated action");
+  NS_TEST_EXPECT_MSG_EQ (agent.GetNRequests (), 2, "requests after a skipped frame");
+  env->NotifySimulationEnd ();
+  agent.Stop ();
+
+  ns3opengym::BoxSpace space;
+  agent.GetMessage<ns3opengym::SimInitMsg> (0).obsspace ().space ().UnpackTo (&space);
+  ns3opengym::EnvStateMsg state = agent.GetMessage<ns3opengym::EnvStateMsg> (1);
+  ns3opengym::BoxDataContainer box = GetBox (state.obsdata ());
+  std::vector<uint32_t> shape (box.shape ().begin (), box.shape ().end ());
+  std::vector<uint32_t> spaceShape (space.shape ().begin (), space.shape ().end ());
+  std::vector<float> obs = GetFloatObs (state);
+  if (m_reduction == OpenGymEnv::FRAME_MEAN)
+    {
+      NS_TEST_EXPECT_MSG_EQ ((obs == std::vector<float> ({3.0f, 4.0f})), true, "mean of the frames");
+      NS_TEST_EXPECT_MSG_EQ (state.reward (), 2.0, "mean reward");
+      NS_TEST_EXPECT_MSG_EQ ((shape == std::vector<uint32_t> (1, 2)), true, "shape of the mean");
+      NS_TEST_EXPECT_MSG_EQ (space.high (), 10.0, "upper bound of the mean");
+    }
+  else if (m_reduction == OpenGymEnv::FRAME_SUM)
+    {
+      NS_TEST_EXPECT_MSG_EQ ((obs == std::vector<float> ({9.0f, 12.0f})), true, "sum of the frames");
+      NS_TEST_EXPECT_MSG_EQ (state.reward (), 6.0, "summed reward");
+      NS_TEST_EXPECT_MSG_EQ (space.high (), 30.0, "upper bound of the sum");
+    }
+  else
+    {
+      NS_TEST_EXPECT_MSG_EQ ((obs == std::vector<float> ({1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f})), true, "stacked frames");
+      NS_TEST_EXPECT_MSG_EQ (state.reward (), 6.0, "summed reward");
+      NS_TEST_EXPECT_MSG_EQ ((shape == std::vector<uint32_t> ({3, 2})), true, "shape of the stack");
+      NS_TEST_EXPECT_MSG_EQ ((spaceShape == shape), true, "shape of the stacked observation space");
+    }
+
+  openGym->Dispose ();
+  env->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup opengym-test
+ * \ingroup tests
+ *
+ * \brief Frame skip cut short by game over
+ */
+class OpenGymFrameSkipGameOverTestCase : public TestCase
+{
+public:
+  OpenGymFrameSkipGameOverTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+OpenGymFrameSkipGameOverTestCase::OpenGymFrameSkipGameOverTestCase ()
+  : TestCase ("Check that game over ends a frame skip step early")
+{
+}
+
+void
+OpenGymFrameSkipGameOverTestCase::DoRun (void)
+{
+  const uint32_t port = 15568;
+  GymTestAgent agent (port);
+  agent.AddReply (MakeActMsg (1));
+  agent.AddReply (ns3opengym::EnvActMsg ());
+  agent.Start ();
+
+  Ptr<OpenGymInterface> openGym = CreateObject<OpenGymInterface> (port);
+  Ptr<GymTestEnv> env = CreateObject<GymTestEnv> ();
+  env->SetAttribute ("FrameSkip", UintegerValue (3));
+  env->SetAttribute ("FrameReduction", StringValue ("Stack"));
+  env->SetOpenGymInterface (openGym);
+
+  env->m_obs = MakeFloatBox ({2}, {1.0f, 2.0f});
+  env->m_reward = 1.0;
+  env->Notify ();
+  env->m_obs = MakeFloatBox ({2}, {3.0f, 4.0f});
+  env->m_reward = 2.0;
+  env->m_gameOver = true;
+  env->Notify ();
+  NS_TEST_ASSERT_MSG_EQ (agent.GetNRequests (), 2, "state after the game over frame");
+  env->NotifySimulationEnd ();
+  agent.Stop ();
+
+  // the stack keeps the shape of the space, the last frame is repeated
+  ns3opengym::EnvStateMsg state = agent.GetMessage<ns3opengym::EnvStateMsg> (1);
+  NS_TEST_EXPECT_MSG_EQ (state.isgameover (), true, "game over");
+  NS_TEST_EXPECT_MSG_EQ (state.reason (), ns3opengym::EnvStateMsg::GameOver, "reason");
+  NS_TEST_EXPECT_MSG_EQ (state.reward (), 3.0, "reward of the frames");
+  NS_TEST_EXPECT_MSG_EQ ((GetFloatObs (state) == std::vector<float> ({1.0f, 2.0f, 3.0f, 4.0f, 3.0f, 4.0f})), true, "stacked frames");
+  ns3opengym::BoxDataContainer box = GetBox (state.obsdata ());
+  NS_TEST_EXPECT_MSG_EQ ((box.shape_size () == 2 && box.shape (0) == 3 && box.shape (1) == 2), true, "shape of the stack");
+
+  openGym->Dispose ();
+  env->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup opengym-test
+ * \ingroup tests
+ *
+ * \brief Records of the step log as ns3gym/step_log.py reads them
+ */
+class OpenGymStepLogTestCase : public TestCase
+{
+public:
+  OpenGymStepLogTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+OpenGymStepLogTestCase::OpenGymStepLogTestCase ()
+  : TestCase ("Check the file and record layout of the step log")
+{
+}
+
+void
+OpenGymStepLogTestCase::DoRun (void)
 {
-  // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
-  AddTestCase (new OpengymTestCase1, TestCase::QUICK);
+  std::string fileName = CreateTempDirFilename ("opengym-steps.bin");
+  Ptr<OpenGymStepLog> log = CreateObject<OpenGymStepLog> ();
+  log->SetAttribute ("Level", StringValue ("Data"));
+  log->SetAttribute ("Sampling", UintegerValue (2));
+  log->SetAttribute ("FileName", StringValue (fileName));
+  log->Open ("unused");
+
+  NS_TEST_EXPECT_MSG_EQ (log->BeginStep (), true, "step 0 sampled");
+  log->LogState (1, MakeFloatBox ({2}, {1.5f, 2.5f}), 0.5, false, "hi");
+  log->LogAction (1, MakeDiscrete (3));
+  NS_TEST_EXPECT_MSG_EQ (log->BeginStep (), false, "step 1 sampled");
+  log->LogState (0, MakeFloatBox ({2}, {0.0f, 0.0f}), 0.0, false, "");
+  log->LogAction (0, MakeDiscrete (0));
+  NS_TEST_EXPECT_MSG_EQ (log->BeginStep (), true, "step 2 sampled");
+  log->LogState (0, MakeDiscrete (5), 1.0, true, "");
+  // actions of earlier steps (async mode) follow the sampling of their step
+  log->LogAction (0, 1, MakeDiscrete (0));
+  log->LogAction (0, 2, MakeDiscrete (4));
+  log->Close ();
+
+  // _FILE_HEADER = struct.Struct('<8sII'), _RECORD = struct.Struct('<IHHQqfBBBBIIII')
+  std::string file = ReadFile (fileName);
+  const char *data = file.data ();
+  NS_TEST_ASSERT_MSG_GT (file.size (), 16, "file header");
+  NS_TEST_EXPECT_MSG_EQ (file.substr (0, 8), "NS3GYMLG", "magic");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint32_t> (data, 8), 1, "version");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint32_t> (data, 12), 48, "record header size");
+
+  // state of step 0: header, shape, raw box, info
+  size_t pos = 16;
+  uint32_t size = ReadAt<uint32_t> (data, pos);
+  NS_TEST_ASSERT_MSG_EQ (size, 48 + 4 + 8 + 2, "size of the first state");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint16_t> (data, pos + 4), OpenGymStepLog::STATE, "type of the first record");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint16_t> (data, pos + 6), 1, "env of the first state");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint64_t> (data, pos + 8), 0, "step of the first state");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<float> (data, pos + 24), 0.5, "reward");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint8_t> (data, pos + 28), 0, "game over");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint8_t> (data, pos + 29), OpenGymStepLog::RAW_TENSOR, "data kind");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint8_t> (data, pos + 30), ns3opengym::FLOAT, "dtype");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint8_t> (data, pos + 31), 4, "item size");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint32_t> (data, pos + 32), 1, "dimensions");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint32_t> (data, pos + 36), 8, "data size");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint32_t> (data, pos + 40), 2, "info size");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint32_t> (data, pos + 48), 2, "shape");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<float> (data, pos + 52), 1.5, "first value");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<float> (data, pos + 56), 2.5, "second value");
+  NS_TEST_EXPECT_MSG_EQ (file.substr (pos + 60, 2), "hi", "info");
+
+  // action of step 0 as serialized container
+  pos += size;
+  size = ReadAt<uint32_t> (data, pos);
+  uint32_t dataSize = ReadAt<uint32_t> (data, pos + 36);
+  NS_TEST_ASSERT_MSG_EQ (size, 48 + dataSize, "size of the first action");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint16_t> (data, pos + 4), OpenGymStepLog::ACTION, "type of the second record");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint64_t> (data, pos + 8), 0, "step of the first action");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint8_t> (data, pos + 29), OpenGymStepLog::PB_CONTAINER, "data kind of the action");
+  ns3opengym::DataContainer container;
+  container.ParseFromString (file.substr (pos + 48, dataSize));
+  NS_TEST_EXPECT_MSG_EQ (GetDiscreteValue (OpenGymDataContainer::CreateFromDataContainerPbMsg (container)), 3, "logged action");
+
+  // step 1 is not sampled; state of step 2 is a discrete observation, so a serialized container
+  pos += size;
+  size = ReadAt<uint32_t> (data, pos);
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint16_t> (data, pos + 4), OpenGymStepLog::STATE, "type of the third record");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint64_t> (data, pos + 8), 2, "step of the second state");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint8_t> (data, pos + 28), 1, "game over of the second state");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint8_t> (data, pos + 29), OpenGymStepLog::PB_CONTAINER, "data kind of a discrete state");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint32_t> (data, pos + 32), 0, "dimensions of a discrete state");
+
+  pos += size;
+  size = ReadAt<uint32_t> (data, pos);
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint16_t> (data, pos + 4), OpenGymStepLog::ACTION, "type of the fourth record");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint64_t> (data, pos + 8), 2, "step of the second action");
+  pos += size;
+  NS_TEST_EXPECT_MSG_EQ (pos, file.size (), "records after the second action");
+
+  log->Dispose ();
+  Simulator::Destroy ();
 }
 
-// Do not forget to allocate an instance of this TestSuite
-static OpengymTestSuite opengymTestSuite;
+/**
+ * \ingroup opengym-test
+ * \ingroup tests
+ *
+ * \brief Chunks and trailer of the transition recorder as ns3gym/transitions.py reads them
+ */
+class OpenGymTransitionRecorderTestCase : public TestCase
+{
+public:
+  OpenGymTransitionRecorderTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+OpenGymTransitionRecorderTestCase::OpenGymTransitionRecorderTestCase ()
+  : TestCase ("Check the file, chunk and trailer layout of recorded transitions")
+{
+}
+
+void
+OpenGymTransitionRecorderTestCase::DoRun (void)
+{
+  std::string fileName = CreateTempDirFilename ("opengym-transitions.bin");
+  Ptr<OpenGymTransitionRecorder> recorder = CreateObject<OpenGymTransitionRecorder> ();
+  recorder->SetAttribute ("FileName", StringValue (fileName));
+  recorder->SetAttribute ("ChunkRows", UintegerValue (2));
+  recorder->SetAttribute ("CompressionLevel", UintegerValue (0));
+  NS_TEST_ASSERT_MSG_EQ (recorder->IsEnabled (), true, "recording with a file name");
+
+  recorder->Record (0, MakeFloatBox ({2}, {1.0f, 2.0f}), MakeDiscrete (4), 0.5, false);
+  recorder->Record (1, MakeFloatBox ({2}, {3.0f, 4.0f}), MakeDiscrete (5), 1.0, false);
+  // the last state of an episode has no action
+  recorder->Record (0, MakeFloatBox ({2}, {5.0f, 6.0f}), nullptr, 2.0, true);
+  recorder->Close ();
+
+  // _FILE_HEADER = struct.Struct('<8sIIIIII8IIII8II')
+  std::string file = ReadFile (fileName);
+  const char *data = file.data ();
+  NS_TEST_ASSERT_MSG_GT (file.size (), 112 + 32, "file header and trailer");
+  NS_TEST_EXPECT_MSG_EQ (file.substr (0, 8), "NS3GYMTR", "magic");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint32_t> (data, 8), 1, "version");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint32_t> (data, 12), OpenGymTransitionRecorder::CODEC_NONE, "codec");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint32_t> (data, 16), 2, "rows per chunk");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint32_t> (data, 20), ns3opengym::FLOAT, "observation dtype");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint32_t> (data, 24), 4, "observation item size");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint32_t> (data, 28), 1, "observation dimensions");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint32_t> (data, 32), 2, "observation shape");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint32_t> (data, 64), ns3opengym::UINT, "action dtype of a discrete action");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint32_t> (data, 68), 4, "action item size");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint32_t> (data, 72), 0, "action dimensions");
+
+  // _TRAILER = struct.Struct('<QQQ8s') at the end, preceded by the chunk offsets
+  size_t trailer = file.size () - 32;
+  NS_TEST_EXPECT_MSG_EQ (file.substr (trailer + 24, 8), "NS3GYMTE", "trailer magic");
+  uint64_t indexOffset = ReadAt<uint64_t> (data, trailer);
+  NS_TEST_ASSERT_MSG_EQ (ReadAt<uint64_t> (data, trailer + 8), 2, "chunks");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint64_t> (data, trailer + 16), 3, "rows");
+  NS_TEST_ASSERT_MSG_EQ (indexOffset + 2 * 8, trailer, "chunk index before the trailer");
+
+  // _CHUNK_HEADER = struct.Struct('<8sQ6Q6Q6Q'): magic, rows, then offset, size and raw size per column
+  uint64_t chunk = ReadAt<uint64_t> (data, indexOffset);
+  NS_TEST_EXPECT_MSG_EQ (chunk, 128, "first chunk at the first 64 byte boundary after the header");
+  NS_TEST_EXPECT_MSG_EQ (file.substr (chunk, 8), "NS3CHUNK", "chunk magic");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint64_t> (data, chunk + 8), 2, "rows of the first chunk");
+  uint64_t columnSizes[] = {2 * 4, 2 * 8, 2 * 8, 2 * 4, 2 * 4, 2 * 1};
+  for (int column = 0; column < OpenGymTransitionRecorder::N_COLUMNS; ++column)
+    {
+      uint64_t offset = ReadAt<uint64_t> (data, chunk + 16 + 8 * column);
+      NS_TEST_EXPECT_MSG_EQ (offset % 64, 0, "alignment of column " << column);
+      NS_TEST_EXPECT_MSG_EQ (ReadAt<uint64_t> (data, chunk + 64 + 8 * column), columnSizes[column], "size of column " << column);
+      NS_TEST_EXPECT_MSG_EQ (ReadAt<uint64_t> (data, chunk + 112 + 8 * column), columnSizes[column], "raw size of column " << column);
+    }
+  const char *env = data + chunk + ReadAt<uint64_t> (data, chunk + 16 + 8 * OpenGymTransitionRecorder::COL_ENV);
+  const char *obs = data + chunk + ReadAt<uint64_t> (data, chunk + 16 + 8 * OpenGymTransitionRecorder::COL_OBS);
+  const char *action = data + chunk + ReadAt<uint64_t> (data, chunk + 16 + 8 * OpenGymTransitionRecorder::COL_ACTION);
+  const char *reward = data + chunk + ReadAt<uint64_t> (data, chunk + 16 + 8 * OpenGymTransitionRecorder::COL_REWARD);
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint32_t> (env, 4), 1, "env of the second row");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<float> (obs, 8), 3.0, "observation of the second row");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint32_t> (action, 0), 4, "action of the first row");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint32_t> (action, 4), 5, "action of the second row");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<float> (reward, 4), 1.0, "reward of the second row");
+
+  chunk = ReadAt<uint64_t> (data, indexOffset + 8);
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint64_t> (data, chunk + 8), 1, "rows of the second chunk");
+  const char *step = data + chunk + ReadAt<uint64_t> (data, chunk + 16 + 8 * OpenGymTransitionRecorder::COL_STEP);
+  action = data + chunk + ReadAt<uint64_t> (data, chunk + 16 + 8 * OpenGymTransitionRecorder::COL_ACTION);
+  const char *done = data + chunk + ReadAt<uint64_t> (data, chunk + 16 + 8 * OpenGymTransitionRecorder::COL_DONE);
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint64_t> (step, 0), 1, "step of env 0 in its second row");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint32_t> (action, 0), 0, "missing action");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint8_t> (done, 0), 1, "done");
+
+  recorder->Dispose ();
+}
+
+/**
+ * \ingroup opengym-test
+ * \ingroup tests
+ *
+ * \brief Transition recording stopped by an observation of another shape
+ */
+class OpenGymTransitionShapeTestCase : public TestCase
+{
+public:
+  OpenGymTransitionShapeTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+OpenGymTransitionShapeTestCase::OpenGymTransitionShapeTestCase ()
+  : TestCase ("Check that a shape change stops the recording and keeps the rows so far")
+{
+}
+
+void
+OpenGymTransitionShapeTestCase::DoRun (void)
+{
+  std::string fileName = CreateTempDirFilename ("opengym-transitions-shape.bin");
+  Ptr<OpenGymTransitionRecorder> recorder = CreateObject<OpenGymTransitionRecorder> ();
+  recorder->SetAttribute ("FileName", StringValue (fileName));
+  recorder->SetAttribute ("CompressionLevel", UintegerValue (0));
+
+  recorder->Record (0, MakeFloatBox ({2}, {1.0f, 2.0f}), MakeDiscrete (1), 0.0, false);
+  // same size, other shape
+  recorder->Record (0, MakeFloatBox ({1, 2}, {3.0f, 4.0f}), MakeDiscrete (1), 0.0, false);
+  NS_TEST_EXPECT_MSG_EQ (recorder->IsEnabled (), false, "recording after a shape change");
+  recorder->Record (0, MakeFloatBox ({2}, {5.0f, 6.0f}), MakeDiscrete (1), 0.0, false);
+
+  std::string file = ReadFile (fileName);
+  NS_TEST_ASSERT_MSG_GT (file.size (), 32, "file of the rows before the shape change");
+  size_t trailer = file.size () - 32;
+  NS_TEST_EXPECT_MSG_EQ (file.substr (trailer + 24, 8), "NS3GYMTE", "trailer magic");
+  NS_TEST_EXPECT_MSG_EQ (ReadAt<uint64_t> (file.data (), trailer + 16), 1, "rows before the shape change");
+
+  recorder->Dispose ();
+}
+
+/**
+ * \ingroup opengym-test
+ * \ingroup tests
+ *
+ * \brief OpenGym test suite
+ */
+class OpenGymTestSuite : public TestSuite
+{
+public:
+  OpenGymTestSuite ();
+};
+
+OpenGymTestSuite::OpenGymTestSuite ()
+  : TestSuite ("opengym", UNIT)
+{
+  AddTestCase (new OpenGymRawTensorTestCase, TestCase::QUICK);
+  AddTestCase (new OpenGymRawTensorExchangeTestCase, TestCase::QUICK);
+  AddTestCase (new OpenGymShmLayoutTestCase, TestCase::QUICK);
+  AddTestCase (new OpenGymBatchTestCase, TestCase::QUICK);
+  AddTestCase (new OpenGymAsyncTestCase, TestCase::QUICK);
+  AddTestCase (new OpenGymCachedFieldsTestCase, TestCase::QUICK);
+  AddTestCase (new OpenGymFrameSkipTestCase (OpenGymEnv::FRAME_MEAN, "Mean", 15565), TestCase::QUICK);
+  AddTestCase (new OpenGymFrameSkipTestCase (OpenGymEnv::FRAME_SUM, "Sum", 15566), TestCase::QUICK);
+  AddTestCase (new OpenGymFrameSkipTestCase (OpenGymEnv::FRAME_STACK, "Stack", 15567), TestCase::QUICK);
+  AddTestCase (new OpenGymFrameSkipGameOverTestCase, TestCase::QUICK);
+  AddTestCase (new OpenGymStepLogTestCase, TestCase::QUICK);
+  AddTestCase (new OpenGymTransitionRecorderTestCase, TestCase::QUICK);
+  AddTestCase (new OpenGymTransitionShapeTestCase, TestCase::QUICK);
+}
 
+static OpenGymTestSuite g_openGymTestSuite; ///< the test suite
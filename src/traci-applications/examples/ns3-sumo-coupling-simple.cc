@@ -86,7 +86,7 @@ main (int argc, char *argv[])
   sumoClient->SetAttribute ("SumoStepLog", BooleanValue (false));
   sumoClient->SetAttribute ("SumoSeed", IntegerValue (10));
   sumoClient->SetAttribute ("SumoAdditionalCmdOptions", StringValue ("--verbose true"));
-  sumoClient->SetAttribute ("SumoWaitForSocket", TimeValue (Seconds (1.0)));
+  sumoClient->SetAttribute ("SumoWaitForSocket", TimeValue (Seconds (10.0)));
 
   /*** 8. Create and Setup Applications for the RSU node and set position ***/
   RsuSpeedControlHelper rsuSpeedControlHelper (9); // Port #9
@@ -106,47 +106,40 @@ main (int argc, char *argv[])
   VehicleSpeedControlHelper vehicleSpeedControlHelper (9);
   vehicleSpeedControlHelper.SetAttribute ("Client", (PointerValue) sumoClient); // pass TraciClient object for accessing sumo in application
 
-  // callback function for node creation
-  std::function<Ptr<Node> ()> setupNewWifiNode = [&] () -> Ptr<Node>
+  // install the applications of all remaining nodes once; nothing is created at simulation time
+  NodeContainer vehicleNodes;
+  for (uint32_t i = nodeCounter; i < nodePool.GetN (); ++i)
     {
-      if (nodeCounter >= nodePool.GetN())
-        NS_FATAL_ERROR("Node Pool empty!: " << nodeCounter << " nodes created.");
-
-      // don't create and install the protocol stack of the node at simulation time -> take from "node pool"
-      Ptr<Node> includedNode = nodePool.Get(nodeCounter);
-      ++nodeCounter;// increment counter for next node
-
-      // Install Application
-      ApplicationContainer vehicleSpeedControlApps = vehicleSpeedControlHelper.Install (includedNode);
-      vehicleSpeedControlApps.Start (Seconds (0.0));
-      vehicleSpeedControlApps.Stop (simulationTime);
-
-      return includedNode;
-    };
+      vehicleNodes.Add (nodePool.Get (i));
+    }
+  ApplicationContainer vehicleSpeedControlApps = vehicleSpeedControlHelper.Install (vehicleNodes);
+  vehicleSpeedControlApps.Start (Seconds (0.0));
+  vehicleSpeedControlApps.Stop (simulationTime);
 
-  // callback function for node shutdown
-  std::function<void (Ptr<Node>)> shutdownWifiNode = [] (Ptr<Node> exNode)
+  // park unused nodes outside communication range; their applications keep the sockets but pause
+  Ptr<VehicleNodePool> vehicleNodePool = CreateObject<VehicleNodePool> ();
+  vehicleNodePool->SetActivateCallback ([] (Ptr<Node> node)
     {
-      // stop all applications
-      Ptr<VehicleSpeedControl> vehicleSpeedControl = exNode->GetApplication(0)->GetObject<VehicleSpeedControl>();
-      if(vehicleSpeedControl)
-        vehicleSpeedControl->StopApplicationNow();
-
-      // set position outside communication range
-      Ptr<ConstantPositionMobilityModel> mob = exNode->GetObject<ConstantPositionMobilityModel>();
-      mob->SetPosition(Vector(-100.0+(rand()%25),320.0+(rand()%25),250.0));// rand() for visualization purposes
-
-      // NOTE: further actions could be required for a save shut down!
-    };
+      node->GetApplication (0)->GetObject<VehicleSpeedControl> ()->Resume ();
+    });
+  vehicleNodePool->SetParkCallback ([] (Ptr<Node> node)
+    {
+      node->GetApplication (0)->GetObject<VehicleSpeedControl> ()->Suspend ();
+    });
+  vehicleNodePool->Add (vehicleNodes);
 
-  // start traci client with given function pointers
-  sumoClient->SumoSetup (setupNewWifiNode, shutdownWifiNode);
+  // start traci client; the pool links nodes to departing vehicles and parks them at arrival
+  sumoClient->SumoSetup (vehicleNodePool->GetIncludeFunction (), vehicleNodePool->GetExcludeFunction ());
 
   /*** 10. Setup and Start Simulation + Animation ***/
   AnimationInterface anim ("src/traci-applications/examples/ns3-sumo-coupling.xml"); // Mandatory
   Simulator::Stop (simulationTime);
 
   Simulator::Run ();
+
+  std::cout << "Vehicle node pool: " << vehicleNodePool->GetSize () << " nodes, peak active " << vehicleNodePool->GetPeakActive ()
+            << ", activations " << vehicleNodePool->GetActivations () << std::endl;
+
   Simulator::Destroy ();
 
   return 0;
@@ -27,6 +27,8 @@ RsuEnv::RsuEnv ()
   horizon = 128;
   epsilon_threshold = 1e-4;
   max_delta = 6.0;
+  // game over and extra info are constant, they are evaluated and sent once
+  SetCachedFields (GAME_OVER | EXTRA_INFO);
 
   NS_LOG_INFO ("Set Up Interface : " << OpenGymInterface::Get () << "\n");
 }
@@ -70,7 +72,7 @@ RsuEnv::GetObservationSpace ()
 
   // initializing observation space
   Ptr<OpenGymBoxSpace> space = CreateObject<OpenGymBoxSpace> (low, high, shape, dtype);
-  NS_LOG_UNCOND ("GetObservationSpace: " << space);
+  NS_LOG_INFO ("GetObservationSpace: " << space);
   return space;
 }
 
@@ -122,7 +124,7 @@ RsuEnv::GetObservation ()
       box->AddValue (value);
     }
 
-  NS_LOG_UNCOND ("MyGetObservation: " << box);
+  NS_LOG_DEBUG ("MyGetObservation: " << box);
   return box;
 }
 
@@ -156,7 +158,7 @@ RsuEnv::GetReward ()
 
   reward *= m_beta;
 
-  NS_LOG_UNCOND ("MyGetReward: " << reward);
+  NS_LOG_DEBUG ("MyGetReward: " << reward);
   return reward;
 }
 
@@ -166,7 +168,7 @@ RsuEnv::GetGameOver ()
   NS_LOG_FUNCTION (this);
   bool isGameOver = false;
   //	isGameOver = pow(abs(old_reward - current_reward), 2) < epsilon_threshold;
-  NS_LOG_UNCOND ("MyGetGameOver: " << isGameOver);
+  NS_LOG_DEBUG ("MyGetGameOver: " << isGameOver);
   return isGameOver;
 }
 
@@ -175,7 +177,7 @@ RsuEnv::GetExtraInfo ()
 {
   NS_LOG_FUNCTION (this);
   std::string myInfo = "info";
-  NS_LOG_UNCOND ("MyGetExtraInfo: " << myInfo);
+  NS_LOG_DEBUG ("MyGetExtraInfo: " << myInfo);
   return myInfo;
 }
 
@@ -187,8 +189,12 @@ RsuEnv::ExecuteActions (Ptr<OpenGymDataContainer> action)
   // get the latest actions performed by the agent
   Ptr<OpenGymBoxContainer<float>> box = DynamicCast<OpenGymBoxContainer<float>> (action);
 
-  // get new actions data (velocities)
-  new_speeds = box->GetData ();
+  NS_LOG_DEBUG ("MyExecuteActions: " << action);
+
+  // get new actions data (velocities); the action may be repeated on skipped frames (OpenGymEnv::FrameSkip),
+  // so it is copied into the existing buffer instead of taken over
+  const std::vector<float> &speeds = box->GetDataRef ();
+  new_speeds.assign (speeds.begin (), speeds.end ());
 
   // make sure all values are in the range [+]
   //	for (uint32_t i = 0; i < new_speeds.size(); i++) {
@@ -196,7 +202,6 @@ RsuEnv::ExecuteActions (Ptr<OpenGymDataContainer> action)
   //	}
 
   current_step++;
-  NS_LOG_UNCOND ("MyExecuteActions: " << action);
   return true;
 }
 
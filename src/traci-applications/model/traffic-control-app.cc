@@ -29,6 +29,8 @@
 #include "ns3/socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/boolean.h"
 #include <string>
 #include <stdlib.h>
 #include <cmath>
@@ -76,6 +78,20 @@ RsuSpeedControl::GetTypeId (void)
           .AddAttribute ("Client", "TraCI client for SUMO", PointerValue (0),
                          MakePointerAccessor (&RsuSpeedControl::m_client),
                          MakePointerChecker<TraciClient> ())
+          .AddAttribute ("ContextRadius",
+                         "Radius of the SUMO context subscription around the RSU in m; "
+                         "vehicles inside report their state with every SUMO step (0 disables)",
+                         DoubleValue (0.0), MakeDoubleAccessor (&RsuSpeedControl::m_contextRadius),
+                         MakeDoubleChecker<double> (0.0))
+          .AddAttribute ("GymPort",
+                         "Port of the OpenGymInterface of the RSU environment (0: the default interface)",
+                         UintegerValue (0), MakeUintegerAccessor (&RsuSpeedControl::m_gymPort),
+                         MakeUintegerChecker<uint32_t> ())
+          .AddAttribute ("GymBatch",
+                         "Step the RSU environment together with the other batched environments of the "
+                         "interface in one message (vectorized env, one agent per RSU)",
+                         BooleanValue (false), MakeBooleanAccessor (&RsuSpeedControl::m_gymBatch),
+                         MakeBooleanChecker ())
           .AddTraceSource ("Tx", "A new packet is created and is sent",
                            MakeTraceSourceAccessor (&RsuSpeedControl::m_txTrace),
                            "ns3::Packet::TracedCallback");
@@ -90,6 +106,9 @@ RsuSpeedControl::RsuSpeedControl ()
   rx_socket = 0;
   tx_socket = 0;
   m_count = 1e9;
+  m_contextRadius = 0.0;
+  m_gymPort = 0;
+  m_gymBatch = false;
   m_rsu_gym_env = 0;
 }
 
@@ -146,8 +165,24 @@ RsuSpeedControl::StartApplication (void)
   rx_socket->Bind (local);
   rx_socket->SetRecvCallback (MakeCallback (&RsuSpeedControl::HandleRead, this));
 
+  // let sumo report the state of all vehicles around the RSU with every simulation step
+  if (m_contextRadius > 0.0)
+    {
+      std::vector<int> vars = {VAR_SPEED, VAR_LANE_INDEX, VAR_FUELCONSUMPTION, VAR_CO2EMISSION,
+                               VAR_COEMISSION, VAR_NOXEMISSION, VAR_PMXEMISSION, VAR_HCEMISSION};
+      m_client->AddRsuContextSubscription (GetNode (), m_contextRadius, vars);
+    }
+
   // set up RSU environment
   Ptr<RsuEnv> env = CreateObject<RsuEnv> ();
+  if (m_gymBatch)
+    {
+      env->AddToOpenGymInterface (OpenGymInterface::Get (m_gymPort));
+    }
+  else if (m_gymPort != 0)
+    {
+      env->SetOpenGymInterface (OpenGymInterface::Get (m_gymPort));
+    }
   m_rsu_gym_env = env;
 
   NS_LOG_INFO ("New Gym Enviroment" << env << "\n");
@@ -384,6 +419,8 @@ VehicleSpeedControl::VehicleSpeedControl ()
   m_port = 0;
   m_client = nullptr;
   last_velocity = 0;
+  m_suspended = false;
+  m_jitter = CreateObject<UniformRandomVariable> ();
 }
 
 VehicleSpeedControl::~VehicleSpeedControl ()
@@ -424,7 +461,10 @@ VehicleSpeedControl::StartApplication (void)
       tx_socket->SetAllowBroadcast (true);
       tx_socket->Connect (remote);
 
-      ScheduleTransmit (m_interval);
+      if (!m_suspended)
+        {
+          ScheduleTransmit (m_interval);
+        }
     }
 }
 
@@ -455,6 +495,27 @@ VehicleSpeedControl::StopApplicationNow ()
   StopApplication ();
 }
 
+void
+VehicleSpeedControl::Suspend (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_suspended = true;
+  Simulator::Cancel (m_sendEvent);
+}
+
+void
+VehicleSpeedControl::Resume (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_suspended = false;
+
+  // before StartApplication, the first packet is scheduled there
+  if (tx_socket != 0 && !m_sendEvent.IsRunning ())
+    {
+      ScheduleTransmit (Seconds (m_jitter->GetValue (0.0, m_interval.GetSeconds ())));
+    }
+}
+
 void
 VehicleSpeedControl::HandleRead (Ptr<Socket> socket)
 {
@@ -464,6 +525,12 @@ VehicleSpeedControl::HandleRead (Ptr<Socket> socket)
   Ptr<Packet> packet;
   packet = socket->Recv ();
 
+  // the node is parked; no vehicle to control
+  if (m_suspended)
+    {
+      return;
+    }
+
   // copy packet data into a buffer then to a string to process
   uint8_t *buffer = new uint8_t[packet->GetSize ()];
   packet->CopyData (buffer, packet->GetSize ());
@@ -476,7 +543,9 @@ VehicleSpeedControl::HandleRead (Ptr<Socket> socket)
       return;
     }
 
-  // parse data received to find current vehicle id
+  // parse data received to find current vehicle id; vehicle handles are local to the traci client and not sent
+  VehicleHandle veh = m_client->GetVehicleHandle (this->GetNode ());
+  std::string id = m_client->GetVehicleId (this->GetNode ());
   double velocity = -999;
   std::vector<std::string> map_data = split (data[1], "|");
   for (uint8_t i = 0; i < map_data.size (); i++)
@@ -484,7 +553,7 @@ VehicleSpeedControl::HandleRead (Ptr<Socket> socket)
       std::vector<std::string> parameters = split (map_data[i], ":");
 
       // when id of current vehicle is found, get respective speed and save value
-      if (parameters[0] == m_client->GetVehicleId (this->GetNode ()))
+      if (parameters.size () == 2 && parameters[0] == id)
         {
           velocity = std::stod (parameters[1]);
         }
@@ -504,13 +573,13 @@ VehicleSpeedControl::HandleRead (Ptr<Socket> socket)
   NS_LOG_INFO ("1 RX ***** RSU->vehicle at time "
                << Simulator::Now ().GetSeconds () << "s - "
                << "[vehicle ip:" << ipAddr << "]"
-               << "[vehicle id:" << m_client->GetVehicleId (this->GetNode ()) << "]"
-               << "[vel:"
-               << m_client->TraCIAPI::vehicle.getSpeed (m_client->GetVehicleId (this->GetNode ()))
+               << "[vehicle id:" << id << "]"
+               << "[vel:" << m_client->GetVehicleDouble (veh, VAR_SPEED)
                << "m/s]"
                << "[rx vel:" << velocity << "m/s]\n");
 
-  m_client->TraCIAPI::vehicle.setSpeed (m_client->GetVehicleId (this->GetNode ()), velocity);
+  // queued by the traci client and sent with all other speed changes before the next sumo step
+  m_client->SetVehicleSpeed (veh, velocity);
   last_velocity = velocity;
 }
 
@@ -522,10 +591,11 @@ VehicleSpeedControl::Send ()
   // Get Headway Just before sending
   // Headway in seconds  = Headway in meters / velocity
 
-  last_velocity = m_client->TraCIAPI::vehicle.getSpeed (m_client->GetVehicleId (this->GetNode ()));
-  last_headway =
-      m_client->TraCIAPI::vehicle.getLeader (m_client->GetVehicleId (this->GetNode ()), 0).second /
-      last_velocity;
+  VehicleHandle veh = m_client->GetVehicleHandle (this->GetNode ());
+
+  // vehicle state is served by the step cache of the traci client whenever possible
+  last_velocity = m_client->GetVehicleDouble (veh, VAR_SPEED);
+  last_headway = m_client->GetVehicleLeader (veh, 0).second / last_velocity;
 
   if (last_velocity <= 0.0 || last_velocity == 1 / 0.0)
     {
@@ -546,30 +616,16 @@ VehicleSpeedControl::Send ()
   // new message string
   std::ostringstream msg;
 
-  // append 1 which is the identifier of a vehicle, append the current velocity and headway and other parameters
-  msg << "1*" << m_client->GetVehicleId (this->GetNode ()) << "*" << std::to_string (last_velocity)
-      << "*" << std::to_string (last_headway) << "*"
-      << std::to_string (
-             m_client->TraCIAPI::vehicle.getLaneIndex (m_client->GetVehicleId (this->GetNode ())))
-      << "*"
-      << std::to_string (m_client->TraCIAPI::vehicle.getFuelConsumption (
-             m_client->GetVehicleId (this->GetNode ())))
-      << "*"
-      << std::to_string (
-             m_client->TraCIAPI::vehicle.getCO2Emission (m_client->GetVehicleId (this->GetNode ())))
-      << "*"
-      << std::to_string (
-             m_client->TraCIAPI::vehicle.getCOEmission (m_client->GetVehicleId (this->GetNode ())))
-      << "*"
-      << std::to_string (
-             m_client->TraCIAPI::vehicle.getNOxEmission (m_client->GetVehicleId (this->GetNode ())))
-      << "*"
-      << std::to_string (
-             m_client->TraCIAPI::vehicle.getPMxEmission (m_client->GetVehicleId (this->GetNode ())))
-      << "*"
-      << std::to_string (
-             m_client->TraCIAPI::vehicle.getHCEmission (m_client->GetVehicleId (this->GetNode ())))
-      << '\0';
+  // append 1 which is the identifier of a vehicle, append the vehicle id, the current velocity and headway and other parameters
+  msg << "1*" << m_client->GetVehicleName (veh) << "*" << std::to_string (last_velocity) << "*"
+      << std::to_string (last_headway) << "*"
+      << std::to_string (m_client->GetVehicleInt (veh, VAR_LANE_INDEX)) << "*"
+      << std::to_string (m_client->GetVehicleDouble (veh, VAR_FUELCONSUMPTION)) << "*"
+      << std::to_string (m_client->GetVehicleDouble (veh, VAR_CO2EMISSION)) << "*"
+      << std::to_string (m_client->GetVehicleDouble (veh, VAR_COEMISSION)) << "*"
+      << std::to_string (m_client->GetVehicleDouble (veh, VAR_NOXEMISSION)) << "*"
+      << std::to_string (m_client->GetVehicleDouble (veh, VAR_PMXEMISSION)) << "*"
+      << std::to_string (m_client->GetVehicleDouble (veh, VAR_HCEMISSION)) << '\0';
   Ptr<Packet> packet = Create<Packet> ((uint8_t *) msg.str ().c_str (), msg.str ().length ());
 
   // send packet
@@ -577,7 +633,7 @@ VehicleSpeedControl::Send ()
   NS_LOG_INFO ("2 TX ***** Vehicle->RSU at time "
                << Simulator::Now ().GetSeconds () << "s - "
                << "[vehicle ip:" << ipAddr << "]"
-               << "[vehicle id:" << m_client->GetVehicleId (this->GetNode ()) << "]"
+               << "[vehicle id:" << m_client->GetVehicleName (veh) << "]"
                << "[tx vel:" << last_velocity << "m/s]"
                << "[tx headway:" << last_headway << "s]\n");
 
@@ -9,6 +9,7 @@
 #include "ns3/address.h"
 #include "ns3/ipv4-address.h"
 #include "ns3/traced-callback.h"
+#include "ns3/random-variable-stream.h"
 #include "ns3/rsu-environment.h"
 
 namespace ns3 {
@@ -107,6 +108,9 @@ private:
   Ptr<Socket> rx_socket; //!< IPv4 Socket
   EventId m_sendEvent; //!< Event to send the next packet
   Ptr<TraciClient> m_client;
+  double m_contextRadius; //!< Radius of the SUMO context subscription around the RSU
+  uint32_t m_gymPort; //!< Port of the OpenGymInterface, 0 for the default one
+  bool m_gymBatch; //!< Step as part of the vectorized env of the interface
   std::map<std::string, vehicle_data> m_vehicles_data;
 
   /// Callbacks for tracing the packet Tx events
@@ -131,6 +135,16 @@ public:
 
   void StopApplicationNow ();
 
+  /**
+   * \brief Pause the application while its node is parked in a VehicleNodePool.
+   *
+   * Sockets are kept; no packets are sent and received packets are dropped
+   * until Resume is called. The first packet after Resume is sent within one
+   * Interval, so vehicles departing together do not transmit in lockstep.
+   */
+  void Suspend (void);
+  void Resume (void);
+
 protected:
   virtual void DoDispose (void);
 
@@ -157,6 +171,8 @@ private:
   Ptr<TraciClient> m_client;
   double last_velocity;
   double last_headway;
+  bool m_suspended; //!< Parked in a node pool
+  Ptr<UniformRandomVariable> m_jitter; //!< Offset of the first packet after Resume
 };
 
 } // namespace ns3
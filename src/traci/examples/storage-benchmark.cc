@@ -0,0 +1,163 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+/*
+ * Microbenchmark for encoding and decoding TraCI messages with tcpip::Storage.
+ *
+ * Encodes and decodes a vehicle subscription response (id, position, speed,
+ * angle, lane per vehicle) with the scalar Storage interface, and an array of
+ * doubles element by element and with the bulk interface. No sumo instance is
+ * needed.
+ *
+ * ./waf --run "storage-benchmark --vehicles=1000 --rounds=1000"
+ */
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iostream>
+
+#include "ns3/core-module.h"
+#include "ns3/traci-module.h"
+
+using namespace ns3;
+
+// one vehicle subscription response as sent by sumo for position, speed, angle and lane index
+static void
+EncodeResponse (tcpip::Storage& msg, uint32_t vehicles)
+{
+  msg.writeInt (vehicles);
+  for (uint32_t i = 0; i < vehicles; ++i)
+    {
+      msg.writeString ("veh" + std::to_string (i));
+      msg.writeUnsignedByte (4);
+      msg.writeUnsignedByte (VAR_POSITION);
+      msg.writeUnsignedByte (RTYPE_OK);
+      msg.writeUnsignedByte (POSITION_2D);
+      msg.writeDouble (i * 1.5);
+      msg.writeDouble (i * 2.5);
+      msg.writeUnsignedByte (VAR_SPEED);
+      msg.writeUnsignedByte (RTYPE_OK);
+      msg.writeUnsignedByte (TYPE_DOUBLE);
+      msg.writeDouble (13.9);
+      msg.writeUnsignedByte (VAR_ANGLE);
+      msg.writeUnsignedByte (RTYPE_OK);
+      msg.writeUnsignedByte (TYPE_DOUBLE);
+      msg.writeDouble (90.0);
+      msg.writeUnsignedByte (VAR_LANE_INDEX);
+      msg.writeUnsignedByte (RTYPE_OK);
+      msg.writeUnsignedByte (TYPE_INTEGER);
+      msg.writeInt (i % 3);
+    }
+}
+
+static double
+DecodeResponse (tcpip::Storage& msg)
+{
+  double sum = 0;
+  int vehicles = msg.readInt ();
+  for (int i = 0; i < vehicles; ++i)
+    {
+      sum += msg.readString ().size ();
+      int vars = msg.readUnsignedByte ();
+      for (int v = 0; v < vars; ++v)
+        {
+          msg.readUnsignedByte ();
+          msg.readUnsignedByte ();
+          switch (msg.readUnsignedByte ())
+            {
+            case POSITION_2D:
+              sum += msg.readDouble ();
+              sum += msg.readDouble ();
+              break;
+            case TYPE_DOUBLE:
+              sum += msg.readDouble ();
+              break;
+            default:
+              sum += msg.readInt ();
+              break;
+            }
+        }
+    }
+  return sum;
+}
+
+static double
+Seconds (std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+}
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t vehicles = 1000;
+  uint32_t rounds = 1000;
+
+  CommandLine cmd;
+  cmd.AddValue ("vehicles", "Number of vehicles per subscription response", vehicles);
+  cmd.AddValue ("rounds", "Number of messages encoded and decoded per variant", rounds);
+  cmd.Parse (argc, argv);
+
+  // sum of decoded values keeps the compiler from dropping the work
+  double check = 0;
+
+  // subscription response, scalar interface
+  tcpip::Storage msg;
+  std::size_t bytes = 0;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  for (uint32_t r = 0; r < rounds; ++r)
+    {
+      msg.reset ();
+      EncodeResponse (msg, vehicles);
+      bytes += msg.size ();
+    }
+  double encodeSec = Seconds (start);
+
+  tcpip::Storage in;
+  start = std::chrono::steady_clock::now ();
+  for (uint32_t r = 0; r < rounds; ++r)
+    {
+      in.reset ();
+      in.writeStorage (msg);
+      check += DecodeResponse (in);
+    }
+  double decodeSec = Seconds (start);
+
+  // array of doubles, element by element and in bulk
+  std::vector<double> values (vehicles * 8, 1.25);
+  std::vector<double> out (values.size ());
+  start = std::chrono::steady_clock::now ();
+  for (uint32_t r = 0; r < rounds; ++r)
+    {
+      tcpip::Storage arr;
+      for (std::size_t i = 0; i < values.size (); ++i)
+        {
+          arr.writeDouble (values[i]);
+        }
+      for (std::size_t i = 0; i < out.size (); ++i)
+        {
+          out[i] = arr.readDouble ();
+        }
+      check += out.back ();
+    }
+  double scalarSec = Seconds (start);
+
+  start = std::chrono::steady_clock::now ();
+  for (uint32_t r = 0; r < rounds; ++r)
+    {
+      tcpip::Storage arr;
+      arr.writeDoubles (values.data (), values.size ());
+      arr.readDoubles (out.data (), out.size ());
+      check += out.back ();
+    }
+  double bulkSec = Seconds (start);
+
+  double arrayMb = rounds * values.size () * sizeof (double) / 1e6;
+  std::cout << "vehicles: " << vehicles << ", rounds: " << rounds << ", message: " << msg.size () << " bytes (check " << check << ")" << std::endl;
+  std::cout << "subscription encode: " << bytes / 1e6 / encodeSec << " MB/s" << std::endl;
+  std::cout << "subscription decode: " << bytes / 1e6 / decodeSec << " MB/s" << std::endl;
+  std::cout << "double array, scalar write+read: " << arrayMb / scalarSec << " MB/s" << std::endl;
+  std::cout << "double array, bulk write+read:   " << arrayMb / bulkSec << " MB/s" << std::endl;
+
+  return 0;
+}
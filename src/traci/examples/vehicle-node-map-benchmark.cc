@@ -0,0 +1,135 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+/*
+ * Microbenchmark for the node -> vehicle lookup of the traci client.
+ *
+ * Compares the former linear scan over a std::map<std::string, Ptr<Node>>
+ * with the reverse index of VehicleNodeMap (node -> handle -> sumo id), and
+ * the position update with an aggregate lookup per vehicle with the batch
+ * update over the cached mobility models. No sumo instance is needed.
+ *
+ * ./waf --run "vehicle-node-map-benchmark --vehicles=10000 --lookups=100000"
+ */
+
+#include <map>
+#include <string>
+#include <chrono>
+#include <iostream>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/traci-module.h"
+
+using namespace ns3;
+
+// lookup as done by TraciClient::GetVehicleId before the reverse index
+static std::string
+LinearLookup (const std::map<std::string, Ptr<Node> >& vehicleNodeMap, Ptr<Node> node)
+{
+  for (std::map<std::string, Ptr<Node> >::const_iterator it = vehicleNodeMap.begin (); it != vehicleNodeMap.end (); ++it)
+    {
+      if (it->second == node)
+        {
+          return it->first;
+        }
+    }
+  return "";
+}
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t vehicles = 10000;
+  uint32_t lookups = 100000;
+  uint32_t steps = 100;
+
+  CommandLine cmd;
+  cmd.AddValue ("vehicles", "Number of linked vehicles", vehicles);
+  cmd.AddValue ("lookups", "Number of node -> vehicle lookups per variant", lookups);
+  cmd.AddValue ("steps", "Number of position synchronisation steps per variant", steps);
+  cmd.Parse (argc, argv);
+
+  NodeContainer nodes;
+  nodes.Create (vehicles);
+  MobilityHelper mobility;
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (nodes);
+
+  std::map<std::string, Ptr<Node> > linearMap;
+  VehicleIdTable vehicleIds;
+  VehicleNodeMap indexMap;
+  for (uint32_t i = 0; i < vehicles; ++i)
+    {
+      std::string veh = "veh" + std::to_string (i);
+      linearMap[veh] = nodes.Get (i);
+      indexMap.Insert (vehicleIds.Intern (veh), nodes.Get (i));
+    }
+
+  // same pseudo random node sequence for both variants
+  Ptr<UniformRandomVariable> randVar = CreateObject<UniformRandomVariable> ();
+  std::vector<Ptr<Node> > queries;
+  queries.reserve (lookups);
+  for (uint32_t i = 0; i < lookups; ++i)
+    {
+      queries.push_back (nodes.Get (randVar->GetInteger (0, vehicles - 1)));
+    }
+
+  // sum of id lengths keeps the compiler from dropping the lookups
+  std::size_t check = 0;
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  for (uint32_t i = 0; i < lookups; ++i)
+    {
+      check += LinearLookup (linearMap, queries[i]).size ();
+    }
+  double linearNs = std::chrono::duration<double, std::nano> (std::chrono::steady_clock::now () - start).count ();
+
+  start = std::chrono::steady_clock::now ();
+  for (uint32_t i = 0; i < lookups; ++i)
+    {
+      check -= vehicleIds.GetName (indexMap.GetVehicle (queries[i])).size ();
+    }
+  double indexNs = std::chrono::duration<double, std::nano> (std::chrono::steady_clock::now () - start).count ();
+
+  if (check != 0)
+    {
+      NS_FATAL_ERROR ("Lookup variants disagree");
+    }
+
+  // positions of one synchronisation step, every vehicle moved
+  std::vector<VehicleHandle> handles (indexMap.GetVehicles ().begin (), indexMap.GetVehicles ().end ());
+  std::vector<Vector> positions (vehicles);
+
+  // position update as done by TraciClient::UpdatePositions before the batch update
+  start = std::chrono::steady_clock::now ();
+  for (uint32_t s = 0; s < steps; ++s)
+    {
+      for (uint32_t i = 0; i < handles.size (); ++i)
+        {
+          positions[i] = Vector (s, i, 1.5);
+          indexMap.GetNode (handles[i])->GetObject<MobilityModel> ()->SetPosition (positions[i]);
+        }
+    }
+  double lookupNs = std::chrono::duration<double, std::nano> (std::chrono::steady_clock::now () - start).count ();
+
+  start = std::chrono::steady_clock::now ();
+  for (uint32_t s = 0; s < steps; ++s)
+    {
+      for (uint32_t i = 0; i < handles.size (); ++i)
+        {
+          positions[i] = Vector (s + 0.5, i, 1.5);
+        }
+      indexMap.SetPositions (handles, positions);
+    }
+  double batchNs = std::chrono::duration<double, std::nano> (std::chrono::steady_clock::now () - start).count ();
+
+  std::cout << "vehicles: " << vehicles << ", lookups: " << lookups << ", steps: " << steps << std::endl;
+  std::cout << "linear scan:   " << linearNs / lookups << " ns/lookup" << std::endl;
+  std::cout << "reverse index: " << indexNs / lookups << " ns/lookup" << std::endl;
+  std::cout << "position update, GetObject per vehicle: " << lookupNs / (double (steps) * vehicles) << " ns/vehicle" << std::endl;
+  std::cout << "position update, batch:                 " << batchNs / (double (steps) * vehicles) << " ns/vehicle" << std::endl;
+
+  Simulator::Destroy ();
+  return 0;
+}
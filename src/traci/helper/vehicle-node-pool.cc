@@ -0,0 +1,283 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "vehicle-node-pool.h"
+
+#include "ns3/log.h"
+#include "ns3/boolean.h"
+#include "ns3/mobility-model.h"
+#include "ns3/ipv4.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+  NS_LOG_COMPONENT_DEFINE ("VehicleNodePool");
+
+  NS_OBJECT_ENSURE_REGISTERED (VehicleNodePool);
+
+  TypeId
+  VehicleNodePool::GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("ns3::VehicleNodePool")
+      .SetParent<Object> ()
+      .SetGroupName ("TraciClient")
+      .AddConstructor<VehicleNodePool> ()
+      .AddAttribute ("ParkingPosition",
+                     "Position of parked nodes; far outside the communication range of the scenario.",
+                     VectorValue (Vector (0.0, 0.0, -100000.0)),
+                     MakeVectorAccessor (&VehicleNodePool::m_parkingPosition),
+                     MakeVectorChecker ())
+      .AddAttribute ("DisableInterfaces",
+                     "Set the ipv4 interfaces of parked nodes down, so that they neither send nor receive.",
+                     BooleanValue (true),
+                     MakeBooleanAccessor (&VehicleNodePool::m_disableInterfaces),
+                     MakeBooleanChecker ())
+    ;
+    return tid;
+  }
+
+  VehicleNodePool::VehicleNodePool (void)
+  {
+    NS_LOG_FUNCTION (this);
+
+    m_parkingPosition = Vector (0.0, 0.0, -100000.0);
+    m_disableInterfaces = true;
+    m_peakActive = 0;
+    m_activations = 0;
+    m_exhaustions = 0;
+  }
+
+  void
+  VehicleNodePool::DoDispose (void)
+  {
+    NS_LOG_FUNCTION (this);
+
+    NS_LOG_INFO ("Node pool: " << GetSize () << " nodes, peak active " << m_peakActive
+                 << ", activations " << m_activations << ", exhausted " << m_exhaustions << " times");
+
+    m_parked.clear ();
+    m_activate = nullptr;
+    m_park = nullptr;
+    m_create = nullptr;
+    Object::DoDispose ();
+  }
+
+  void
+  VehicleNodePool::Add (Ptr<Node> node)
+  {
+    NS_LOG_FUNCTION (this << node->GetId ());
+
+    m_nodes.Add (node);
+    if (node->GetId () >= m_active.size ())
+      {
+        m_active.resize (node->GetId () + 1, false);
+      }
+    DoPark (node);
+  }
+
+  void
+  VehicleNodePool::Add (NodeContainer nodes)
+  {
+    NS_LOG_FUNCTION (this << nodes.GetN ());
+
+    m_parked.reserve (m_parked.size () + nodes.GetN ());
+    for (NodeContainer::Iterator it = nodes.Begin (); it != nodes.End (); ++it)
+      {
+        Add (*it);
+      }
+  }
+
+  void
+  VehicleNodePool::SetActivateCallback (std::function<void (Ptr<Node>)> activate)
+  {
+    m_activate = activate;
+  }
+
+  void
+  VehicleNodePool::SetParkCallback (std::function<void (Ptr<Node>)> park)
+  {
+    m_park = park;
+  }
+
+  void
+  VehicleNodePool::SetCreateCallback (std::function<Ptr<Node> ()> create)
+  {
+    m_create = create;
+  }
+
+  Ptr<Node>
+  VehicleNodePool::Activate (void)
+  {
+    NS_LOG_FUNCTION (this);
+
+    Ptr<Node> node;
+    if (m_parked.empty ())
+      {
+        ++m_exhaustions;
+        if (!m_create)
+          {
+            NS_FATAL_ERROR ("Vehicle node pool exhausted: all " << GetSize () << " nodes are active");
+          }
+
+        // grow the pool by one node
+        node = m_create ();
+        m_nodes.Add (node);
+        if (node->GetId () >= m_active.size ())
+          {
+            m_active.resize (node->GetId () + 1, false);
+          }
+        NS_LOG_INFO ("Vehicle node pool exhausted; added node " << node->GetId ());
+      }
+    else
+      {
+        node = m_parked.back ();
+        m_parked.pop_back ();
+      }
+
+    m_active[node->GetId ()] = true;
+    ++m_activations;
+    m_peakActive = std::max (m_peakActive, GetActive ());
+
+    if (m_disableInterfaces)
+      {
+        SetInterfacesUp (node, true);
+      }
+    if (m_activate)
+      {
+        m_activate (node);
+      }
+
+    return node;
+  }
+
+  void
+  VehicleNodePool::Park (Ptr<Node> node)
+  {
+    NS_LOG_FUNCTION (this << node->GetId ());
+
+    if (node->GetId () >= m_active.size () || !m_active[node->GetId ()])
+      {
+        NS_LOG_WARN ("Node " << node->GetId () << " is not an active node of the pool; ignored");
+        return;
+      }
+
+    DoPark (node);
+  }
+
+  void
+  VehicleNodePool::DoPark (Ptr<Node> node)
+  {
+    m_active[node->GetId ()] = false;
+    m_parked.push_back (node);
+
+    if (m_park)
+      {
+        m_park (node);
+      }
+
+    Ptr<MobilityModel> mob = node->GetObject<MobilityModel> ();
+    if (mob)
+      {
+        mob->SetPosition (m_parkingPosition);
+      }
+    if (m_disableInterfaces)
+      {
+        SetInterfacesUp (node, false);
+      }
+  }
+
+  void
+  VehicleNodePool::SetInterfacesUp (Ptr<Node> node, bool up)
+  {
+    Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+    if (!ipv4)
+      {
+        return;
+      }
+
+    // interface 0 is the loopback
+    for (uint32_t i = 1; i < ipv4->GetNInterfaces (); ++i)
+      {
+        if (up)
+          {
+            ipv4->SetUp (i);
+          }
+        else
+          {
+            ipv4->SetDown (i);
+          }
+      }
+  }
+
+  std::function<Ptr<Node> ()>
+  VehicleNodePool::GetIncludeFunction (void)
+  {
+    Ptr<VehicleNodePool> pool = this;
+    return [pool] () { return pool->Activate (); };
+  }
+
+  std::function<void (Ptr<Node>)>
+  VehicleNodePool::GetExcludeFunction (void)
+  {
+    Ptr<VehicleNodePool> pool = this;
+    return [pool] (Ptr<Node> node) { pool->Park (node); };
+  }
+
+  NodeContainer
+  VehicleNodePool::GetNodes (void) const
+  {
+    return m_nodes;
+  }
+
+  uint32_t
+  VehicleNodePool::GetSize (void) const
+  {
+    return m_nodes.GetN ();
+  }
+
+  uint32_t
+  VehicleNodePool::GetActive (void) const
+  {
+    return m_nodes.GetN () - m_parked.size ();
+  }
+
+  uint32_t
+  VehicleNodePool::GetParked (void) const
+  {
+    return m_parked.size ();
+  }
+
+  uint32_t
+  VehicleNodePool::GetPeakActive (void) const
+  {
+    return m_peakActive;
+  }
+
+  uint64_t
+  VehicleNodePool::GetActivations (void) const
+  {
+    return m_activations;
+  }
+
+  uint64_t
+  VehicleNodePool::GetExhaustions (void) const
+  {
+    return m_exhaustions;
+  }
+
+} // namespace ns3
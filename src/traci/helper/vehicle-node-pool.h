@@ -0,0 +1,111 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef VEHICLE_NODE_POOL_H
+#define VEHICLE_NODE_POOL_H
+
+#include <vector>
+#include <functional>
+
+#include "ns3/object.h"
+#include "ns3/node.h"
+#include "ns3/node-container.h"
+#include "ns3/vector.h"
+
+namespace ns3 {
+
+/**
+ * Pool of pre-built nodes for the sumo vehicles of a TraciClient.
+ *
+ * Nodes are added with their devices, internet stack, mobility model and
+ * applications already installed. A node is parked while no vehicle is linked
+ * to it: it is moved to ParkingPosition, its ipv4 interfaces are set down and
+ * the park callback is called (e.g. to suspend applications). Activating a
+ * node reverts this. Nothing is created or destroyed at departures and
+ * arrivals, so the pool serves as include and exclude function of
+ * TraciClient::SumoSetup:
+ *
+ *   pool->Add (nodes);
+ *   client->SumoSetup (pool->GetIncludeFunction (), pool->GetExcludeFunction ());
+ */
+class VehicleNodePool : public Object
+{
+public:
+  static TypeId GetTypeId (void);
+
+  VehicleNodePool (void);
+
+  // add pre-built nodes; they are parked until activated
+  void Add (Ptr<Node> node);
+  void Add (NodeContainer nodes);
+
+  // called after a node is activated and after it is parked
+  void SetActivateCallback (std::function<void (Ptr<Node>)> activate);
+  void SetParkCallback (std::function<void (Ptr<Node>)> park);
+
+  // builds an additional node if the pool is exhausted; without it, exhaustion is fatal
+  void SetCreateCallback (std::function<Ptr<Node> ()> create);
+
+  // take a parked node; the most recently parked node is reused first
+  Ptr<Node> Activate (void);
+
+  // return an active node to the pool
+  void Park (Ptr<Node> node);
+
+  // include and exclude functions for TraciClient::SumoSetup
+  std::function<Ptr<Node> ()> GetIncludeFunction (void);
+  std::function<void (Ptr<Node>)> GetExcludeFunction (void);
+
+  // all nodes of the pool
+  NodeContainer GetNodes (void) const;
+
+  // pool statistics
+  uint32_t GetSize (void) const;
+  uint32_t GetActive (void) const;
+  uint32_t GetParked (void) const;
+  uint32_t GetPeakActive (void) const;
+  uint64_t GetActivations (void) const;
+  uint64_t GetExhaustions (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  void DoPark (Ptr<Node> node);
+  void SetInterfacesUp (Ptr<Node> node, bool up);
+
+  NodeContainer m_nodes;
+
+  // parked nodes (LIFO) and activity by node id
+  std::vector<Ptr<Node> > m_parked;
+  std::vector<bool> m_active;
+
+  std::function<void (Ptr<Node>)> m_activate;
+  std::function<void (Ptr<Node>)> m_park;
+  std::function<Ptr<Node> ()> m_create;
+
+  Vector m_parkingPosition;
+  bool m_disableInterfaces;
+
+  uint32_t m_peakActive;
+  uint64_t m_activations;
+  uint64_t m_exhaustions;
+};
+
+} // namespace ns3
+
+#endif /* VEHICLE_NODE_POOL_H */
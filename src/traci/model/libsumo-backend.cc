@@ -0,0 +1,268 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <map>
+
+#include "ns3/log.h"
+#include "ns3/fatal-error.h"
+
+#include "libsumo-backend.h"
+
+#ifdef NS3_LIBSUMO
+// the vendored sumo-TraCIDefs.h and sumo-TraCIConstants.h share include guards with their libsumo counterparts
+#include <libsumo/Simulation.h>
+#include <libsumo/Vehicle.h>
+#include <libsumo/POI.h>
+#endif
+
+namespace ns3
+{
+  NS_LOG_COMPONENT_DEFINE ("LibsumoBackend");
+
+#ifdef NS3_LIBSUMO
+  namespace
+  {
+    // libsumo returns subscription results by value; copied once per simulation step
+    libsumo::SubscriptionResults g_vehicleResults;
+    std::map<std::string, libsumo::SubscriptionResults> g_poiContextResults;
+
+    // libsumo::Simulation::close must not be called twice
+    bool g_loaded = false;
+  }
+
+  bool
+  LibsumoBackend::IsAvailable (void)
+  {
+    return true;
+  }
+
+  void
+  LibsumoBackend::Load (const std::vector<std::string>& args)
+  {
+    NS_LOG_FUNCTION (args.size ());
+    libsumo::Simulation::load (args);
+    g_loaded = true;
+  }
+
+  void
+  LibsumoBackend::Close (void)
+  {
+    NS_LOG_FUNCTION_NOARGS ();
+    if (!g_loaded)
+      {
+        return;
+      }
+    g_loaded = false;
+    g_vehicleResults.clear ();
+    g_poiContextResults.clear ();
+    libsumo::Simulation::close ();
+  }
+
+  bool
+  LibsumoBackend::IsLoaded (void)
+  {
+    return g_loaded;
+  }
+
+  void
+  LibsumoBackend::SimulationStep (double time)
+  {
+    NS_LOG_FUNCTION (time);
+    libsumo::Simulation::step (time);
+
+    g_vehicleResults = libsumo::Vehicle::getAllSubscriptionResults ();
+    for (std::map<std::string, libsumo::SubscriptionResults>::iterator it = g_poiContextResults.begin (); it != g_poiContextResults.end (); ++it)
+      {
+        it->second = libsumo::POI::getContextSubscriptionResults (it->first);
+      }
+  }
+
+  std::vector<std::string>
+  LibsumoBackend::GetDepartedIDList (void)
+  {
+    return libsumo::Simulation::getDepartedIDList ();
+  }
+
+  std::vector<std::string>
+  LibsumoBackend::GetArrivedIDList (void)
+  {
+    return libsumo::Simulation::getArrivedIDList ();
+  }
+
+  std::vector<std::string>
+  LibsumoBackend::GetVehicleIDList (void)
+  {
+    return libsumo::Vehicle::getIDList ();
+  }
+
+  void
+  LibsumoBackend::SubscribeVehicle (const std::string& veh, const std::vector<int>& vars, double begin, double end)
+  {
+    libsumo::Vehicle::subscribe (veh, vars, begin, end);
+    // like the subscribe response over the socket: a vehicle subscribed after the step has its results in the same step
+    g_vehicleResults[veh] = libsumo::Vehicle::getSubscriptionResults (veh);
+  }
+
+  const libsumo::SubscriptionResults&
+  LibsumoBackend::GetVehicleSubscriptionResults (void)
+  {
+    return g_vehicleResults;
+  }
+
+  void
+  LibsumoBackend::AddPoi (const std::string& poi, double x, double y, const libsumo::TraCIColor& color, const std::string& type, int layer)
+  {
+    libsumo::POI::add (poi, x, y, color, type, layer);
+  }
+
+  void
+  LibsumoBackend::SubscribePoiContext (const std::string& poi, int domain, double range, const std::vector<int>& vars, double begin, double end)
+  {
+    libsumo::POI::subscribeContext (poi, domain, range, vars, begin, end);
+    g_poiContextResults[poi] = libsumo::POI::getContextSubscriptionResults (poi);
+  }
+
+  const libsumo::SubscriptionResults&
+  LibsumoBackend::GetPoiContextSubscriptionResults (const std::string& poi)
+  {
+    return g_poiContextResults[poi];
+  }
+
+  libsumo::TraCIPosition
+  LibsumoBackend::GetVehiclePosition (const std::string& veh)
+  {
+    return libsumo::Vehicle::getPosition (veh);
+  }
+
+  double
+  LibsumoBackend::GetVehicleDouble (const std::string& veh, int variable)
+  {
+    switch (variable)
+      {
+      case VAR_SPEED:
+        return libsumo::Vehicle::getSpeed (veh);
+      case VAR_SPEED_WITHOUT_TRACI:
+        return libsumo::Vehicle::getSpeedWithoutTraCI (veh);
+      case VAR_ACCELERATION:
+        return libsumo::Vehicle::getAcceleration (veh);
+      case VAR_ANGLE:
+        return libsumo::Vehicle::getAngle (veh);
+      case VAR_SLOPE:
+        return libsumo::Vehicle::getSlope (veh);
+      case VAR_LANEPOSITION:
+        return libsumo::Vehicle::getLanePosition (veh);
+      case VAR_LANEPOSITION_LAT:
+        return libsumo::Vehicle::getLateralLanePosition (veh);
+      case VAR_ALLOWED_SPEED:
+        return libsumo::Vehicle::getAllowedSpeed (veh);
+      case VAR_WAITING_TIME:
+        return libsumo::Vehicle::getWaitingTime (veh);
+      case VAR_DISTANCE:
+        return libsumo::Vehicle::getDistance (veh);
+      case VAR_FUELCONSUMPTION:
+        return libsumo::Vehicle::getFuelConsumption (veh);
+      case VAR_ELECTRICITYCONSUMPTION:
+        return libsumo::Vehicle::getElectricityConsumption (veh);
+      case VAR_NOISEEMISSION:
+        return libsumo::Vehicle::getNoiseEmission (veh);
+      case VAR_CO2EMISSION:
+        return libsumo::Vehicle::getCO2Emission (veh);
+      case VAR_COEMISSION:
+        return libsumo::Vehicle::getCOEmission (veh);
+      case VAR_NOXEMISSION:
+        return libsumo::Vehicle::getNOxEmission (veh);
+      case VAR_PMXEMISSION:
+        return libsumo::Vehicle::getPMxEmission (veh);
+      case VAR_HCEMISSION:
+        return libsumo::Vehicle::getHCEmission (veh);
+      default:
+        NS_FATAL_ERROR ("Vehicle variable " << variable << " is not supported by the libsumo backend");
+      }
+    return 0.0;
+  }
+
+  int
+  LibsumoBackend::GetVehicleInt (const std::string& veh, int variable)
+  {
+    switch (variable)
+      {
+      case VAR_LANE_INDEX:
+        return libsumo::Vehicle::getLaneIndex (veh);
+      case VAR_SIGNALS:
+        return libsumo::Vehicle::getSignals (veh);
+      case VAR_ROUTE_INDEX:
+        return libsumo::Vehicle::getRouteIndex (veh);
+      case VAR_STOPSTATE:
+        return libsumo::Vehicle::getStopState (veh);
+      default:
+        NS_FATAL_ERROR ("Vehicle variable " << variable << " is not supported by the libsumo backend");
+      }
+    return 0;
+  }
+
+  std::pair<std::string, double>
+  LibsumoBackend::GetVehicleLeader (const std::string& veh, double dist)
+  {
+    return libsumo::Vehicle::getLeader (veh, dist);
+  }
+
+  void
+  LibsumoBackend::SetVehicleSpeed (const std::string& veh, double speed)
+  {
+    libsumo::Vehicle::setSpeed (veh, speed);
+  }
+
+#else /* NS3_LIBSUMO */
+
+  namespace
+  {
+    void
+    NotAvailable (void)
+    {
+      NS_FATAL_ERROR ("ns3 was built without libsumo; configure with --with-libsumo=<SUMO_HOME> to use the libsumo backend");
+    }
+
+    const libsumo::SubscriptionResults g_noResults;
+  }
+
+  bool
+  LibsumoBackend::IsAvailable (void)
+  {
+    return false;
+  }
+
+  void LibsumoBackend::Load (const std::vector<std::string>&) { NotAvailable (); }
+  void LibsumoBackend::Close (void) { }
+  bool LibsumoBackend::IsLoaded (void) { return false; }
+  void LibsumoBackend::SimulationStep (double) { NotAvailable (); }
+  std::vector<std::string> LibsumoBackend::GetDepartedIDList (void) { NotAvailable (); return std::vector<std::string> (); }
+  std::vector<std::string> LibsumoBackend::GetArrivedIDList (void) { NotAvailable (); return std::vector<std::string> (); }
+  std::vector<std::string> LibsumoBackend::GetVehicleIDList (void) { NotAvailable (); return std::vector<std::string> (); }
+  void LibsumoBackend::SubscribeVehicle (const std::string&, const std::vector<int>&, double, double) { NotAvailable (); }
+  const libsumo::SubscriptionResults& LibsumoBackend::GetVehicleSubscriptionResults (void) { NotAvailable (); return g_noResults; }
+  void LibsumoBackend::AddPoi (const std::string&, double, double, const libsumo::TraCIColor&, const std::string&, int) { NotAvailable (); }
+  void LibsumoBackend::SubscribePoiContext (const std::string&, int, double, const std::vector<int>&, double, double) { NotAvailable (); }
+  const libsumo::SubscriptionResults& LibsumoBackend::GetPoiContextSubscriptionResults (const std::string&) { NotAvailable (); return g_noResults; }
+  libsumo::TraCIPosition LibsumoBackend::GetVehiclePosition (const std::string&) { NotAvailable (); return libsumo::TraCIPosition (); }
+  double LibsumoBackend::GetVehicleDouble (const std::string&, int) { NotAvailable (); return 0.0; }
+  int LibsumoBackend::GetVehicleInt (const std::string&, int) { NotAvailable (); return 0; }
+  std::pair<std::string, double> LibsumoBackend::GetVehicleLeader (const std::string&, double) { NotAvailable (); return std::make_pair ("", 0.0); }
+  void LibsumoBackend::SetVehicleSpeed (const std::string&, double) { NotAvailable (); }
+
+#endif /* NS3_LIBSUMO */
+
+} // namespace ns3
@@ -0,0 +1,77 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LIBSUMO_BACKEND_H
+#define LIBSUMO_BACKEND_H
+
+#include <string>
+#include <vector>
+#include <utility>
+
+// sumo-TraCIConstants.h has to precede sumo-TraCIDefs.h (INVALID_DOUBLE_VALUE)
+#include "sumo-TraCIConstants.h"
+#include "sumo-TraCIDefs.h"
+
+namespace ns3 {
+
+/**
+ * Embedded sumo simulation (libsumo) as used by TraciClient.
+ *
+ * All calls are plain function calls into sumo running in the ns3 process;
+ * there is no socket and no serialisation. libsumo hosts a single simulation
+ * per process, hence all members are static. The backend is only available if
+ * ns3 was configured with --with-libsumo; otherwise every call aborts.
+ */
+class LibsumoBackend
+{
+public:
+  // true if ns3 was built with libsumo
+  static bool IsAvailable (void);
+
+  // load a simulation with sumo command line options (without program name)
+  static void Load (const std::vector<std::string>& args);
+
+  // close the loaded simulation; does nothing if none is loaded, e.g. on SumoStop after a failed reset
+  static void Close (void);
+  static bool IsLoaded (void);
+
+  // simulate until the given time; refreshes the subscription results
+  static void SimulationStep (double time);
+
+  static std::vector<std::string> GetDepartedIDList (void);
+  static std::vector<std::string> GetArrivedIDList (void);
+  static std::vector<std::string> GetVehicleIDList (void);
+
+  // vehicle subscriptions and rsu context subscriptions around pois; results as of the last simulation step or
+  // of the subscription, if it came later
+  static void SubscribeVehicle (const std::string& veh, const std::vector<int>& vars, double begin, double end);
+  static const libsumo::SubscriptionResults& GetVehicleSubscriptionResults (void);
+  static void AddPoi (const std::string& poi, double x, double y, const libsumo::TraCIColor& color, const std::string& type, int layer);
+  static void SubscribePoiContext (const std::string& poi, int domain, double range, const std::vector<int>& vars, double begin, double end);
+  static const libsumo::SubscriptionResults& GetPoiContextSubscriptionResults (const std::string& poi);
+
+  // vehicle variables; GetVehicleDouble and GetVehicleInt support the scalar variables of CMD_GET_VEHICLE_VARIABLE
+  static libsumo::TraCIPosition GetVehiclePosition (const std::string& veh);
+  static double GetVehicleDouble (const std::string& veh, int variable);
+  static int GetVehicleInt (const std::string& veh, int variable);
+  static std::pair<std::string, double> GetVehicleLeader (const std::string& veh, double dist);
+  static void SetVehicleSpeed (const std::string& veh, double speed);
+};
+
+} // namespace ns3
+
+#endif /* LIBSUMO_BACKEND_H */
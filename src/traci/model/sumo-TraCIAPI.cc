@@ -44,7 +44,7 @@ TraCIAPI::TraCIAPI()
       person(*this), poi(*this), polygon(*this), route(*this),
       simulation(*this), trafficlights(*this),
       vehicle(*this), vehicletype(*this),
-      mySocket(nullptr) {
+      mySocket(nullptr), myStepPending(false) {
     myDomains[RESPONSE_SUBSCRIBE_EDGE_VARIABLE] = &edge;
     myDomains[RESPONSE_SUBSCRIBE_GUI_VARIABLE] = &gui;
     myDomains[RESPONSE_SUBSCRIBE_JUNCTION_VARIABLE] = &junction;
@@ -92,6 +92,7 @@ TraCIAPI::setOrder(int order) {
     outMsg.writeUnsignedByte(CMD_SETORDER);
     outMsg.writeInt(order);
     // send request message
+    joinPendingStep();
     mySocket->sendExact(outMsg);
     tcpip::Storage inMsg;
     check_resultState(inMsg, CMD_SETORDER);
@@ -116,11 +117,13 @@ TraCIAPI::closeSocket() {
     mySocket->close();
     delete mySocket;
     mySocket = nullptr;
+    myStepPending = false;
 }
 
 
 void
-TraCIAPI::send_commandSimulationStep(double time) const {
+TraCIAPI::send_commandSimulationStep(double time) {
+    joinPendingStep();
     tcpip::Storage outMsg;
     // command length
     outMsg.writeUnsignedByte(1 + 1 + 8);
@@ -133,7 +136,8 @@ TraCIAPI::send_commandSimulationStep(double time) const {
 
 
 void
-TraCIAPI::send_commandClose() const {
+TraCIAPI::send_commandClose() {
+    joinPendingStep();
     tcpip::Storage outMsg;
     // command length
     outMsg.writeUnsignedByte(1 + 1);
@@ -144,7 +148,8 @@ TraCIAPI::send_commandClose() const {
 
 
 void
-TraCIAPI::send_commandSetOrder(int order) const {
+TraCIAPI::send_commandSetOrder(int order) {
+    joinPendingStep();
     tcpip::Storage outMsg;
     // command length
     outMsg.writeUnsignedByte(1 + 1 + 4);
@@ -157,11 +162,20 @@ TraCIAPI::send_commandSetOrder(int order) const {
 
 
 void
-TraCIAPI::send_commandGetVariable(int domID, int varID, const std::string& objID, tcpip::Storage* add) const {
+TraCIAPI::send_commandGetVariable(int domID, int varID, const std::string& objID, tcpip::Storage* add) {
     if (mySocket == nullptr) {
         throw tcpip::SocketException("Socket is not initialised");
     }
+    joinPendingStep();
     tcpip::Storage outMsg;
+    write_commandGetVariable(outMsg, domID, varID, objID, add);
+    // send request message
+    mySocket->sendExact(outMsg);
+}
+
+
+void
+TraCIAPI::write_commandGetVariable(tcpip::Storage& outMsg, int domID, int varID, const std::string& objID, tcpip::Storage* add) const {
     // command length
     int length = 1 + 1 + 1 + 4 + (int) objID.length();
     if (add != nullptr) {
@@ -178,17 +192,24 @@ TraCIAPI::send_commandGetVariable(int domID, int varID, const std::string& objID
     if (add != nullptr) {
         outMsg.writeStorage(*add);
     }
-    // send request message
-    mySocket->sendExact(outMsg);
 }
 
 
 void
-TraCIAPI::send_commandSetValue(int domID, int varID, const std::string& objID, tcpip::Storage& content) const {
+TraCIAPI::send_commandSetValue(int domID, int varID, const std::string& objID, tcpip::Storage& content) {
     if (mySocket == nullptr) {
         throw tcpip::SocketException("Socket is not initialised");
     }
+    joinPendingStep();
     tcpip::Storage outMsg;
+    write_commandSetValue(outMsg, domID, varID, objID, content);
+    // send message
+    mySocket->sendExact(outMsg);
+}
+
+
+void
+TraCIAPI::write_commandSetValue(tcpip::Storage& outMsg, int domID, int varID, const std::string& objID, tcpip::Storage& content) const {
     // command length (domID, varID, objID, dataType, data)
     outMsg.writeUnsignedByte(1 + 1 + 1 + 4 + (int) objID.length() + (int)content.size());
     // command id
@@ -199,17 +220,16 @@ TraCIAPI::send_commandSetValue(int domID, int varID, const std::string& objID, t
     outMsg.writeString(objID);
     // data type
     outMsg.writeStorage(content);
-    // send message
-    mySocket->sendExact(outMsg);
 }
 
 
 void
 TraCIAPI::send_commandSubscribeObjectVariable(int domID, const std::string& objID, double beginTime, double endTime,
-        const std::vector<int>& vars) const {
+        const std::vector<int>& vars) {
     if (mySocket == nullptr) {
         throw tcpip::SocketException("Socket is not initialised");
     }
+    joinPendingStep();
     tcpip::Storage outMsg;
     // command length (domID, objID, beginTime, endTime, length, vars)
     int varNo = (int) vars.size();
@@ -234,10 +254,11 @@ TraCIAPI::send_commandSubscribeObjectVariable(int domID, const std::string& objI
 
 void
 TraCIAPI::send_commandSubscribeObjectContext(int domID, const std::string& objID, double beginTime, double endTime,
-        int domain, double range, const std::vector<int>& vars) const {
+        int domain, double range, const std::vector<int>& vars) {
     if (mySocket == nullptr) {
         throw tcpip::SocketException("Socket is not initialised");
     }
+    joinPendingStep();
     tcpip::Storage outMsg;
     // command length (domID, objID, beginTime, endTime, length, vars)
     int varNo = (int) vars.size();
@@ -263,7 +284,7 @@ TraCIAPI::send_commandSubscribeObjectContext(int domID, const std::string& objID
 }
 
 void
-TraCIAPI::send_commandMoveToXY(const std::string& vehicleID, const std::string& edgeID, const int lane, const double x, const double y, const double angle, const int keepRoute) const {
+TraCIAPI::send_commandMoveToXY(const std::string& vehicleID, const std::string& edgeID, const int lane, const double x, const double y, const double angle, const int keepRoute) {
     tcpip::Storage content;
     content.writeUnsignedByte(TYPE_COMPOUND);
     content.writeInt(6);
@@ -481,56 +502,7 @@ TraCIAPI::readVariables(tcpip::Storage& inMsg, const std::string& objectID, int
         const int type = inMsg.readUnsignedByte();
 
         if (status == RTYPE_OK) {
-            switch (type) {
-                case TYPE_DOUBLE:
-                    into[objectID][variableID] = std::make_shared<libsumo::TraCIDouble>(inMsg.readDouble());
-                    break;
-                case TYPE_STRING:
-                    into[objectID][variableID] = std::make_shared<libsumo::TraCIString>(inMsg.readString());
-                    break;
-                case POSITION_2D: {
-                    auto p = std::make_shared<libsumo::TraCIPosition>();
-                    p->x = inMsg.readDouble();
-                    p->y = inMsg.readDouble();
-                    p->z = 0.;
-                    into[objectID][variableID] = p;
-                    break;
-                }
-                case POSITION_3D: {
-                    auto p = std::make_shared<libsumo::TraCIPosition>();
-                    p->x = inMsg.readDouble();
-                    p->y = inMsg.readDouble();
-                    p->z = inMsg.readDouble();
-                    into[objectID][variableID] = p;
-                    break;
-                }
-                case TYPE_COLOR: {
-                    auto c = std::make_shared<libsumo::TraCIColor>();
-                    c->r = (unsigned char)inMsg.readUnsignedByte();
-                    c->g = (unsigned char)inMsg.readUnsignedByte();
-                    c->b = (unsigned char)inMsg.readUnsignedByte();
-                    c->a = (unsigned char)inMsg.readUnsignedByte();
-                    into[objectID][variableID] = c;
-                    break;
-                }
-                case TYPE_INTEGER:
-                    into[objectID][variableID] = std::make_shared<libsumo::TraCIInt>(inMsg.readInt());
-                    break;
-                case TYPE_STRINGLIST: {
-                    auto sl = std::make_shared<libsumo::TraCIStringList>();
-                    int n = inMsg.readInt();
-                    for (int i = 0; i < n; ++i) {
-                        sl->value.push_back(inMsg.readString());
-                    }
-                    into[objectID][variableID] = sl;
-                }
-                break;
-
-                // TODO Other data types
-
-                default:
-                    throw libsumo::TraCIException("Unimplemented subscription type: " + toString(type));
-            }
+            into[objectID][variableID] = readTypedValue(type, inMsg);
         } else {
             throw libsumo::TraCIException("Subscription response error: variableID=" + toString(variableID) + " status=" + toString(status));
         }
@@ -540,6 +512,47 @@ TraCIAPI::readVariables(tcpip::Storage& inMsg, const std::string& objectID, int
 }
 
 
+std::shared_ptr<libsumo::TraCIResult>
+TraCIAPI::readTypedValue(int type, tcpip::Storage& inMsg) {
+    switch (type) {
+        case TYPE_DOUBLE:
+            return std::make_shared<libsumo::TraCIDouble>(inMsg.readDouble());
+        case TYPE_STRING:
+            return std::make_shared<libsumo::TraCIString>(inMsg.readString());
+        case POSITION_2D:
+        case POSITION_3D: {
+            double xyz[3] = {0., 0., 0.};
+            inMsg.readDoubles(xyz, type == POSITION_3D ? 3 : 2);
+            auto p = std::make_shared<libsumo::TraCIPosition>();
+            p->x = xyz[0];
+            p->y = xyz[1];
+            p->z = xyz[2];
+            return p;
+        }
+        case TYPE_COLOR: {
+            auto c = std::make_shared<libsumo::TraCIColor>();
+            c->r = (unsigned char)inMsg.readUnsignedByte();
+            c->g = (unsigned char)inMsg.readUnsignedByte();
+            c->b = (unsigned char)inMsg.readUnsignedByte();
+            c->a = (unsigned char)inMsg.readUnsignedByte();
+            return c;
+        }
+        case TYPE_INTEGER:
+            return std::make_shared<libsumo::TraCIInt>(inMsg.readInt());
+        case TYPE_STRINGLIST: {
+            auto sl = std::make_shared<libsumo::TraCIStringList>();
+            int n = inMsg.readInt();
+            for (int i = 0; i < n; ++i) {
+                sl->value.push_back(inMsg.readString());
+            }
+            return sl;
+        }
+        default:
+            throw libsumo::TraCIException("Unimplemented value type: " + toString(type));
+    }
+}
+
+
 void
 TraCIAPI::readVariableSubscription(int cmdId, tcpip::Storage& inMsg) {
     const std::string objectID = inMsg.readString();
@@ -565,8 +578,39 @@ TraCIAPI::readContextSubscription(int cmdId, tcpip::Storage& inMsg) {
 
 void
 TraCIAPI::simulationStep(double time) {
+    simulationStepAsync(time);
+    joinSimulationStep();
+}
+
+
+void
+TraCIAPI::simulationStepAsync(double time) {
     send_commandSimulationStep(time);
-    tcpip::Storage inMsg;
+    myStepPending = true;
+}
+
+
+bool
+TraCIAPI::isSimulationStepPending() const {
+    return myStepPending;
+}
+
+
+void
+TraCIAPI::joinPendingStep() {
+    if (myStepPending) {
+        joinSimulationStep();
+    }
+}
+
+
+void
+TraCIAPI::joinSimulationStep() {
+    if (!myStepPending) {
+        return;
+    }
+    myStepPending = false;
+    tcpip::Storage& inMsg = myInput;
     check_resultState(inMsg, CMD_SIMSTEP);
 
     for (auto it : myDomains) {
@@ -597,12 +641,115 @@ TraCIAPI::load(const std::vector<std::string>& args) {
     content.writeUnsignedByte(CMD_LOAD);
     content.writeUnsignedByte(TYPE_STRINGLIST);
     content.writeStringList(args);
+    joinPendingStep();
     mySocket->sendExact(content);
     tcpip::Storage inMsg;
     check_resultState(inMsg, CMD_LOAD);
 }
 
 
+int
+TraCIAPI::queueGetVariable(int domID, int varID, const std::string& objID, tcpip::Storage* add) {
+    write_commandGetVariable(myBatch, domID, varID, objID, add);
+    myBatchCommands.push_back(std::make_pair(domID, true));
+    return (int)myBatchCommands.size() - 1;
+}
+
+
+int
+TraCIAPI::queueSetValue(int domID, int varID, const std::string& objID, tcpip::Storage& content) {
+    write_commandSetValue(myBatch, domID, varID, objID, content);
+    myBatchCommands.push_back(std::make_pair(domID, false));
+    return (int)myBatchCommands.size() - 1;
+}
+
+
+void
+TraCIAPI::flushBatch() {
+    myBatchResults.clear();
+    if (myBatchCommands.empty()) {
+        return;
+    }
+    if (mySocket == nullptr) {
+        throw tcpip::SocketException("Socket is not initialised");
+    }
+    joinPendingStep();
+    // sumo processes all commands of a message in order and answers them within a single message
+    mySocket->sendExact(myBatch);
+    myBatch.reset();
+    std::vector<std::pair<int, bool> > commands;
+    commands.swap(myBatchCommands);
+
+    tcpip::Storage& inMsg = myInput;
+    mySocket->receiveExact(inMsg);
+    std::string error;
+    for (std::vector<std::pair<int, bool> >::const_iterator i = commands.begin(); i != commands.end(); ++i) {
+        // status response (length, command id, result type, description)
+        const int cmdStart = inMsg.position();
+        const int cmdLength = inMsg.readUnsignedByte();
+        const int cmdId = inMsg.readUnsignedByte();
+        const int resultType = inMsg.readUnsignedByte();
+        const std::string msg = inMsg.readString();
+        if (cmdId != i->first || (cmdStart + cmdLength) != (int) inMsg.position()) {
+            // the responses can not be assigned to the commands anymore
+            throw tcpip::SocketException("#Error: received status response to command: " + toString(cmdId) + " but expected: " + toString(i->first));
+        }
+        if (resultType != RTYPE_OK) {
+            // sumo skips the get response of failed commands; keep the first error and read on
+            if (error.empty()) {
+                error = ".. Answered with error to batched command (" + toString(cmdId) + "), [description: " + msg + "]";
+            }
+            myBatchResults.push_back(nullptr);
+            continue;
+        }
+        if (!i->second) {
+            myBatchResults.push_back(nullptr);
+            continue;
+        }
+        // get response (length, command id, variable id, object id, type, value)
+        const int respStart = inMsg.position();
+        int respLength = inMsg.readUnsignedByte();
+        if (respLength == 0) {
+            respLength = inMsg.readInt();
+        }
+        const int respId = inMsg.readUnsignedByte();
+        if (respId != i->first + 0x10) {
+            throw tcpip::SocketException("#Error: received response with command id: " + toString(respId) + " but expected: " + toString(i->first + 0x10));
+        }
+        inMsg.readUnsignedByte(); // variableID
+        inMsg.readString(); // objectID
+        const int type = inMsg.readUnsignedByte();
+        try {
+            myBatchResults.push_back(readTypedValue(type, inMsg));
+        } catch (libsumo::TraCIException&) {
+            // value type without TraCIResult (e.g. a compound); skip the value, the result stays empty
+            while ((int) inMsg.position() < respStart + respLength) {
+                inMsg.readUnsignedByte();
+            }
+            myBatchResults.push_back(nullptr);
+        }
+    }
+    if (!error.empty()) {
+        throw libsumo::TraCIException(error);
+    }
+}
+
+
+std::shared_ptr<libsumo::TraCIResult>
+TraCIAPI::getBatchResult(int index) const {
+    if (index < 0 || index >= (int)myBatchResults.size()) {
+        throw libsumo::TraCIException("#Error: no batch result with index " + toString(index));
+    }
+    return myBatchResults[index];
+}
+
+
+int
+TraCIAPI::getBatchSize() const {
+    return (int)myBatchCommands.size();
+}
+
+
 // ---------------------------------------------------------------------------
 // TraCIAPI::EdgeScope-methods
 // ---------------------------------------------------------------------------
@@ -1639,6 +1786,28 @@ TraCIAPI::SimulationScope::getDistanceRoad(const std::string& edgeID1, double po
 }
 
 
+void
+TraCIAPI::SimulationScope::saveState(const std::string& destination) const {
+    tcpip::Storage content;
+    content.writeUnsignedByte(TYPE_STRING);
+    content.writeString(destination);
+    myParent.send_commandSetValue(CMD_SET_SIM_VARIABLE, CMD_SAVE_SIMSTATE, "", content);
+    tcpip::Storage inMsg;
+    myParent.check_resultState(inMsg, CMD_SET_SIM_VARIABLE);
+}
+
+
+void
+TraCIAPI::SimulationScope::loadState(const std::string& path) const {
+    tcpip::Storage content;
+    content.writeUnsignedByte(TYPE_STRING);
+    content.writeString(path);
+    myParent.send_commandSetValue(CMD_SET_SIM_VARIABLE, CMD_LOAD_SIMSTATE, "", content);
+    tcpip::Storage inMsg;
+    myParent.check_resultState(inMsg, CMD_SET_SIM_VARIABLE);
+}
+
+
 // ---------------------------------------------------------------------------
 // TraCIAPI::TrafficLightScope-methods
 // ---------------------------------------------------------------------------
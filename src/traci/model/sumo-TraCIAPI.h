@@ -80,6 +80,19 @@ public:
     /// @brief Advances by one step (or up to the given time)
     void simulationStep(double time = 0);
 
+    /** @brief Requests a simulation step without waiting for the answer
+     *
+     * Sumo computes the step while the caller continues. The answer is read by joinSimulationStep();
+     * any other command joins the pending step first, since sumo answers in request order.
+     */
+    void simulationStepAsync(double time = 0);
+
+    /// @brief Waits for the answer to a step requested by simulationStepAsync and reads the subscription results; no-op if no step is pending
+    void joinSimulationStep();
+
+    /// @brief Whether a step requested by simulationStepAsync was not joined yet
+    bool isSimulationStepPending() const;
+
     /// @brief Let sumo load a simulation using the given command line like options.
     void load(const std::vector<std::string>& args);
 
@@ -98,6 +111,43 @@ public:
     /// @}
 
 
+    /// @name Command batching
+    /// @{
+
+    /** @brief Queues a GetVariable request; nothing is sent before flushBatch()
+     * @param[in] domID The domain of the variable
+     * @param[in] varID The variable to retrieve
+     * @param[in] objID The object to retrieve the variable from
+     * @param[in] add Optional additional parameter
+     * @return The index of the result within the batch (see getBatchResult)
+     */
+    int queueGetVariable(int domID, int varID, const std::string& objID, tcpip::Storage* add = 0);
+
+    /** @brief Queues a SetVariable request; nothing is sent before flushBatch()
+     * @param[in] domID The domain of the variable
+     * @param[in] varID The variable to set
+     * @param[in] objID The object to change
+     * @param[in] content The value of the variable
+     * @return The index of the command within the batch
+     */
+    int queueSetValue(int domID, int varID, const std::string& objID, tcpip::Storage& content);
+
+    /** @brief Sends all queued commands as a single message and reads all responses with a single receive
+     *
+     * The results of queued GetVariable requests stay available via getBatchResult until the next flush.
+     * @exception libsumo::TraCIException if sumo answered any of the commands with an error; all responses are read before
+     * @exception tcpip::SocketException if the responses do not match the queued commands
+     */
+    void flushBatch();
+
+    /// @brief Returns the result of a queued GetVariable request of the last flushed batch (nullptr for set commands, errors and unsupported value types)
+    std::shared_ptr<libsumo::TraCIResult> getBatchResult(int index) const;
+
+    /// @brief Returns the number of commands queued since the last flush
+    int getBatchSize() const;
+    /// @}
+
+
     /** @class TraCIScopeWrapper
      * @brief An abstract interface for accessing type-dependent values
      *
@@ -517,6 +567,10 @@ public:
         double getDistance2D(double x1, double y1, double x2, double y2, bool isGeo = false, bool isDriving = false);
         double getDistanceRoad(const std::string& edgeID1, double pos1, const std::string& edgeID2, double pos2, bool isDriving = false);
 
+        void saveState(const std::string& destination) const;
+        /// @brief requires sumo 1.2.0 or later
+        void loadState(const std::string& path) const;
+
 
     private:
         /// @brief invalidated copy constructor
@@ -887,17 +941,17 @@ protected:
 
     /** @brief Sends a SimulationStep command
      */
-    void send_commandSimulationStep(double time) const;
+    void send_commandSimulationStep(double time);
 
 
     /** @brief Sends a Close command
      */
-    void send_commandClose() const;
+    void send_commandClose();
 
 
     /** @brief Sends a SetOrder command
      */
-    void send_commandSetOrder(int order) const;
+    void send_commandSetOrder(int order);
 
     /** @brief Sends a GetVariable request
      * @param[in] domID The domain of the variable
@@ -905,7 +959,12 @@ protected:
      * @param[in] objID The object to retrieve the variable from
      * @param[in] add Optional additional parameter
      */
-    void send_commandGetVariable(int domID, int varID, const std::string& objID, tcpip::Storage* add = 0) const;
+    void send_commandGetVariable(int domID, int varID, const std::string& objID, tcpip::Storage* add = 0);
+
+
+    /** @brief Appends a GetVariable request to the given message (see send_commandGetVariable)
+     */
+    void write_commandGetVariable(tcpip::Storage& outMsg, int domID, int varID, const std::string& objID, tcpip::Storage* add = 0) const;
 
 
     /** @brief Sends a SetVariable request
@@ -914,7 +973,12 @@ protected:
      * @param[in] objID The object to change
      * @param[in] content The value of the variable
      */
-    void send_commandSetValue(int domID, int varID, const std::string& objID, tcpip::Storage& content) const;
+    void send_commandSetValue(int domID, int varID, const std::string& objID, tcpip::Storage& content);
+
+
+    /** @brief Appends a SetVariable request to the given message (see send_commandSetValue)
+     */
+    void write_commandSetValue(tcpip::Storage& outMsg, int domID, int varID, const std::string& objID, tcpip::Storage& content) const;
 
 
     /** @brief Sends a SubscribeVariable request
@@ -924,7 +988,7 @@ protected:
      * @param[in] endTime The end time step of subscriptions
      * @param[in] vars The variables to subscribe
      */
-    void send_commandSubscribeObjectVariable(int domID, const std::string& objID, double beginTime, double endTime, const std::vector<int>& vars) const;
+    void send_commandSubscribeObjectVariable(int domID, const std::string& objID, double beginTime, double endTime, const std::vector<int>& vars);
 
 
     /** @brief Sends a SubscribeContext request
@@ -937,12 +1001,12 @@ protected:
      * @param[in] vars The variables to subscribe
      */
     void send_commandSubscribeObjectContext(int domID, const std::string& objID, double beginTime, double endTime,
-                                            int domain, double range, const std::vector<int>& vars) const;
+                                            int domain, double range, const std::vector<int>& vars);
     /// @}
 
 
     void send_commandMoveToXY(const std::string& vehicleID, const std::string& edgeID, const int lane,
-                              const double x, const double y, const double angle, const int keepRoute) const;
+                              const double x, const double y, const double angle, const int keepRoute);
 
 
     /// @name Command sending methods
@@ -968,6 +1032,9 @@ protected:
     void readContextSubscription(int cmdId, tcpip::Storage& inMsg);
     void readVariables(tcpip::Storage& inMsg, const std::string& objectID, int variableCount, libsumo::SubscriptionResults& into);
 
+    /// @brief Reads a single value of the given type (as used by subscription and batch responses)
+    static std::shared_ptr<libsumo::TraCIResult> readTypedValue(int type, tcpip::Storage& inMsg);
+
     template <class T>
     static inline std::string toString(const T& t, std::streamsize accuracy = PRECISION) {
         std::ostringstream oss;
@@ -980,10 +1047,26 @@ protected:
     /// @brief Closes the connection
     void closeSocket();
 
+    /// @brief Reads the answer to a pending asynchronous step before another command is sent
+    void joinPendingStep();
+
 protected:
     std::map<int, TraCIScopeWrapper*> myDomains;
     /// @brief The socket
     tcpip::Socket* mySocket;
+
+    /// @brief Commands queued for the next batch
+    tcpip::Storage myBatch;
+    /// @brief Command ids of the queued commands and whether a get response follows their status
+    std::vector<std::pair<int, bool> > myBatchCommands;
+    /// @brief Results of the last flushed batch, one per command
+    std::vector<std::shared_ptr<libsumo::TraCIResult> > myBatchResults;
+
+    /// @brief Receive buffer of the per step messages (simulation step, batch); keeps its memory between messages
+    tcpip::Storage myInput;
+
+    /// @brief Whether the answer to an asynchronous step was not read yet
+    bool myStepPending;
 };
 
 
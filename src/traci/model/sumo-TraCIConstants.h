@@ -891,6 +891,9 @@ const int CMD_CLEAR_PENDING_VEHICLES = 0x94;
 // triggers saving simulation state (set: simulation)
 const int CMD_SAVE_SIMSTATE = 0x95;
 
+// triggers loading simulation state (set: simulation; requires sumo 1.2.0 or later)
+const int CMD_LOAD_SIMSTATE = 0x96;
+
 // sets/retrieves abstract parameter
 const int VAR_PARAMETER = 0x7e;
 
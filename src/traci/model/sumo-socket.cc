@@ -436,10 +436,11 @@ namespace tcpip
 		// Sending length_storage and b independently would probably be possible and
 		// avoid some copying here, but both parts would have to go through the
 		// TCP/IP stack on their own which probably would cost more performance.
-		std::vector<unsigned char> msg;
-		msg.insert(msg.end(), length_storage.begin(), length_storage.end());
-		msg.insert(msg.end(), b.begin(), b.end());
-		send(msg);
+		// The buffer keeps its capacity between messages.
+		sendBuffer_.clear();
+		sendBuffer_.insert(sendBuffer_.end(), length_storage.begin(), length_storage.end());
+		sendBuffer_.insert(sendBuffer_.end(), b.begin(), b.end());
+		send(sendBuffer_);
 	}
 
 
@@ -481,7 +482,7 @@ namespace tcpip
 	// ----------------------------------------------------------------------
 	void
 		Socket::
-		printBufferOnVerbose(const std::vector<unsigned char> buffer, const std::string &label)
+		printBufferOnVerbose(const std::vector<unsigned char> &buffer, const std::string &label)
 		const
 	{
 		if (verbose_)
@@ -526,28 +527,23 @@ namespace tcpip
 		Socket::
 		receiveExact( Storage &msg )
 	{
-		// buffer for received bytes
-		// According to the C++ standard elements of a std::vector are stored
-		// contiguously. Explicitly &buffer[n] == &buffer[0] + n for 0 <= n < buffer.size().
-		std::vector<unsigned char> buffer(lengthLen);
-
 		// receive length of TraCI message
-		receiveComplete(&buffer[0], lengthLen);
-		Storage length_storage(&buffer[0], lengthLen);
+		unsigned char lengthBuffer[4];
+		receiveComplete(lengthBuffer, lengthLen);
+		Storage length_storage(lengthBuffer, lengthLen);
 		const int totalLen = length_storage.readInt();
 		assert(totalLen > lengthLen);
 
-		// extent buffer
-		buffer.resize(totalLen);
-
-		// receive remaining TraCI message
-		receiveComplete(&buffer[lengthLen], totalLen - lengthLen);
+		// receive remaining TraCI message directly into the passed Storage; no intermediate copy
+		unsigned char * const content = msg.resetForReceive(totalLen - lengthLen);
+		receiveComplete(content, totalLen - lengthLen);
 
-		// copy message content into passed Storage
-		msg.reset();
-		msg.writePacket(&buffer[lengthLen], totalLen - lengthLen);
-		
-		printBufferOnVerbose(buffer, "Rcvd Storage with");
+		if (verbose_)
+		{
+			std::vector<unsigned char> buffer(lengthBuffer, lengthBuffer + lengthLen);
+			buffer.insert(buffer.end(), msg.begin(), msg.end());
+			printBufferOnVerbose(buffer, "Rcvd Storage with");
+		}
 
 		return true;
 	}
@@ -105,7 +105,7 @@ namespace tcpip
 		/// Receive up to \p len available bytes from Socket::socket_
 		size_t recvAndCheck(unsigned char * const buffer, std::size_t len) const;
 		/// Print \p label and \p buffer to stderr if Socket::verbose_ is set
-		void printBufferOnVerbose(const std::vector<unsigned char> buffer, const std::string &label) const;
+		void printBufferOnVerbose(const std::vector<unsigned char> &buffer, const std::string &label) const;
 
 	private:
 		void init();
@@ -123,6 +123,9 @@ namespace tcpip
 		bool blocking_;
 
 		bool verbose_;
+
+		/// Length prefix and message of sendExact; reused to avoid an allocation per message
+		std::vector<unsigned char> sendBuffer_;
 #ifdef WIN32
 		static bool init_windows_sockets_;
 		static bool windows_sockets_initialized_;
@@ -19,6 +19,7 @@
 #include <iterator>
 #include <sstream>
 #include <cassert>
+#include <cstring>
 #include <algorithm>
 #include <iomanip>
 
@@ -40,9 +41,8 @@ namespace tcpip
 	{
 		assert(length >= 0); // fixed MB, 2015-04-21
 
-		store.reserve(length);
 		// Get the content
-		for(int i = 0; i < length; ++i) store.push_back(packet[i]);
+		store.assign(packet, packet + length);
 
 		init();
 	}
@@ -89,6 +89,17 @@ namespace tcpip
 	}
 
 
+	// ----------------------------------------------------------------------
+	unsigned char* Storage::resetForReceive(std::size_t length)
+	{
+		// clear() keeps the capacity, so a reused storage does not allocate
+		store.clear();
+		store.resize(length);
+		iter_ = store.begin();
+		return store.data();
+	}
+
+
 	// ----------------------------------------------------------------------
 	/**
 	* Reads a char form the array
@@ -330,6 +341,34 @@ namespace tcpip
 	}
 
 
+	// ----------------------------------------------------------------------
+	void Storage::readInts(int* values, std::size_t count)
+	{
+		readArrayByEndianess(reinterpret_cast<unsigned char*>(values), 4, count);
+	}
+
+
+	// ----------------------------------------------------------------------
+	void Storage::writeInts(const int* values, std::size_t count)
+	{
+		writeArrayByEndianess(reinterpret_cast<const unsigned char*>(values), 4, count);
+	}
+
+
+	// ----------------------------------------------------------------------
+	void Storage::readDoubles(double* values, std::size_t count)
+	{
+		readArrayByEndianess(reinterpret_cast<unsigned char*>(values), 8, count);
+	}
+
+
+	// ----------------------------------------------------------------------
+	void Storage::writeDoubles(const double* values, std::size_t count)
+	{
+		writeArrayByEndianess(reinterpret_cast<const unsigned char*>(values), 8, count);
+	}
+
+
 	// ----------------------------------------------------------------------
 	void Storage::writePacket(unsigned char* packet, int length)
 	{
@@ -394,15 +433,44 @@ namespace tcpip
 	{
 		checkReadSafe(size);
 		if (bigEndian_)
+			std::copy(iter_, iter_ + size, array);
+		else
+			std::reverse_copy(iter_, iter_ + size, array);
+		iter_ += size;
+	}
+
+
+	// ----------------------------------------------------------------------
+	void Storage::writeArrayByEndianess(const unsigned char * begin, unsigned int size, std::size_t count)
+	{
+		if (count == 0)
+			return;
+		const StorageType::size_type pos = store.size();
+		store.resize(pos + size * count);
+		unsigned char * dest = &store[pos];
+		std::memcpy(dest, begin, size * count);
+		if (!bigEndian_)
 		{
-			for (int i = 0; i < size; ++i)
-				array[i] = readCharUnsafe();
+			for (std::size_t i = 0; i < count; ++i)
+				std::reverse(dest + i * size, dest + (i + 1) * size);
 		}
-		else
+		iter_ = store.begin();
+	}
+
+
+	// ----------------------------------------------------------------------
+	void Storage::readArrayByEndianess(unsigned char * array, unsigned int size, std::size_t count)
+	{
+		if (count == 0)
+			return;
+		checkReadSafe(static_cast<unsigned int>(size * count));
+		std::memcpy(array, &(*iter_), size * count);
+		if (!bigEndian_)
 		{
-			for (int i = size - 1; i >= 0; --i)
-				array[i] = readCharUnsafe();
+			for (std::size_t i = 0; i < count; ++i)
+				std::reverse(array + i * size, array + (i + 1) * size);
 		}
+		iter_ += size * count;
 	}
 
 
@@ -30,6 +30,7 @@
 #include <string>
 #include <stdexcept>
 #include <iostream>
+#include <cstddef>
 
 namespace tcpip
 {
@@ -58,6 +59,10 @@ private:
 	void writeByEndianess(const unsigned char * begin, unsigned int size);
 	/// Read \p size elements into \p array according to endianess
 	void readByEndianess(unsigned char * array, int size);
+	/// Write \p count values of \p size bytes each at once according to endianess
+	void writeArrayByEndianess(const unsigned char * begin, unsigned int size, std::size_t count);
+	/// Read \p count values of \p size bytes each at once according to endianess
+	void readArrayByEndianess(unsigned char * array, unsigned int size, std::size_t count);
 
 
 public:
@@ -75,6 +80,8 @@ public:
 	virtual unsigned int position() const;
 
 	void reset();
+	/// Replace the content by \p length bytes to be filled through the returned pointer, e.g. by a socket; keeps the allocated memory
+	unsigned char* resetForReceive(std::size_t length);
 	/// Dump storage content as series of hex values
 	std::string hexDump() const;
 
@@ -106,6 +113,12 @@ public:
 	virtual double readDouble();
 	virtual void writeDouble( double );
 
+	/// Bulk variants; equivalent to \p count single reads/writes, but copied with a single bounds check
+	void readInts(int* values, std::size_t count);
+	void writeInts(const int* values, std::size_t count);
+	void readDoubles(double* values, std::size_t count);
+	void writeDoubles(const double* values, std::size_t count);
+
 	virtual void writePacket(unsigned char* packet, int length);
     virtual void writePacket(const std::vector<unsigned char> &packet);
 
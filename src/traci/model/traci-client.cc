@@ -25,9 +25,18 @@
 #include <unistd.h>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <regex>
 #include <string>
+#include <limits>
+#include <unordered_set>
+#include <cmath>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <cctype>
 #include <sys/socket.h>
+#include <sys/wait.h>
 #include <netinet/in.h>
 
 #include "traci-client.h"
@@ -58,17 +67,23 @@ namespace ns3
                   MakeUintegerAccessor (&TraciClient::m_sumoPort),
                   MakeUintegerChecker<uint32_t> ())
     .AddAttribute ("SumoWaitForSocket",
-                  "Wait XX sec (=1e6 microsec) until sumo opens socket for traci connection.",
-                  TimeValue (ns3::Seconds(1.0)),
+                  "Maximum time to wait until sumo opens its socket for the traci connection; the client connects as soon as the socket is ready. "
+                  "Formerly a fixed sleep with 1 s default, now a timeout with 10 s default.",
+                  TimeValue (ns3::Seconds(10.0)),
                   MakeTimeAccessor (&TraciClient::m_sumoWaitForSocket),
                   MakeTimeChecker ())
+    .AddAttribute ("SumoConnectBackoff",
+                  "Delay after the first failed connection attempt during sumo start up; doubled after every further attempt (at most 0.1 s).",
+                  TimeValue (ns3::MilliSeconds(10)),
+                  MakeTimeAccessor (&TraciClient::m_sumoConnectBackoff),
+                  MakeTimeChecker ())
     .AddAttribute ("SumoGUI",
                   "Turn SUMO GUI on/off.",
                   BooleanValue (false),
                   MakeBooleanAccessor (&TraciClient::m_sumoGUI),
                   MakeBooleanChecker ())
     .AddAttribute ("SumoAdditionalCmdOptions",
-                  "Additional commandline options for SUMO start-up.",
+                  "Additional commandline options for SUMO start-up, separated by whitespace; quote values that contain whitespace, e.g. --output-prefix \"run 1/\".",
                   StringValue (""),
                   MakeStringAccessor (&TraciClient::m_sumoAddCmdOpt),
                   MakeStringChecker ())
@@ -105,6 +120,61 @@ namespace ns3
                   DoubleValue (1.5),
                   MakeDoubleAccessor (&TraciClient::m_altitude),
                   MakeDoubleChecker<double> ())
+    .AddAttribute ("ExtrapolatePositions",
+                  "Also read speed and angle of every vehicle and let the nodes move on with that velocity between two synchronisation steps. "
+                  "Nodes need a ConstantVelocityMobilityModel.",
+                  BooleanValue (false),
+                  MakeBooleanAccessor (&TraciClient::m_extrapolate),
+                  MakeBooleanChecker ())
+    .AddAttribute ("MinPositionChange",
+                  "Minimum displacement in meter before a node position is updated; smaller movements accumulate and fire no course change. "
+                  "With ExtrapolatePositions, the minimum deviation from the extrapolated position. 0 updates every node at every synchronisation step.",
+                  DoubleValue (0.0),
+                  MakeDoubleAccessor (&TraciClient::m_minPositionChange),
+                  MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("SubscriptionMode",
+                  "Subscribe departed vehicles to position, speed, angle and lane instead of polling each vehicle per synchronisation step.",
+                  BooleanValue (false),
+                  MakeBooleanAccessor (&TraciClient::m_subscriptionMode),
+                  MakeBooleanChecker ())
+    .AddAttribute ("LookAhead",
+                  "Request the next SUMO step asynchronously at every synchronisation point and join on it at the following one, "
+                  "so SUMO computes while ns3 processes the events in between. Commands issued by ns3 take effect one step later.",
+                  BooleanValue (false),
+                  MakeBooleanAccessor (&TraciClient::m_lookAhead),
+                  MakeBooleanChecker ())
+    .AddAttribute ("SumoBackend",
+                  "Run SUMO as child process connected via a TraCI socket, or embedded in the ns3 process via libsumo "
+                  "(requires ns3 configured with --with-libsumo; no GUI and no look-ahead).",
+                  EnumValue (TraciClient::SOCKET_BACKEND),
+                  MakeEnumAccessor (&TraciClient::m_backend),
+                  MakeEnumChecker (TraciClient::SOCKET_BACKEND, "Socket",
+                                   TraciClient::LIBSUMO_BACKEND, "Libsumo"))
+    .AddAttribute ("ResetMode",
+                  "How SumoReset starts a new episode: reload the sumo configuration (Load), or restore the state saved at the end of SumoSetup "
+                  "without parsing the network again (LoadState; requires sumo 1.2.0 or later and the socket backend).",
+                  EnumValue (TraciClient::LOAD_RESET),
+                  MakeEnumAccessor (&TraciClient::m_resetMode),
+                  MakeEnumChecker (TraciClient::LOAD_RESET, "Load",
+                                   TraciClient::LOAD_STATE_RESET, "LoadState"))
+    .AddAttribute ("SumoStateFile",
+                  "State file for ResetMode LoadState; defaults to SumoState-<port>.xml next to the sumo configuration. Removed by SumoStop.",
+                  StringValue (""),
+                  MakeStringAccessor (&TraciClient::m_sumoStateFile),
+                  MakeStringChecker ())
+    .AddAttribute ("VehicleRegistry",
+                  "Registry shared with the clients of other sumo instances (shards); vehicles moving between shards keep their node.",
+                  PointerValue (),
+                  MakePointerAccessor (&TraciClient::m_registry),
+                  MakePointerChecker<VehicleRegistry> ())
+    .AddTraceSource ("SumoStartup",
+                     "Sumo was started and the traci connection is established.",
+                     MakeTraceSourceAccessor (&TraciClient::m_sumoStartupTrace),
+                     "ns3::TraciClient::SumoStartupTracedCallback")
+    .AddTraceSource ("PositionsUpdated",
+                     "Node positions were synchronised with sumo; fired once per synchronisation step.",
+                     MakeTraceSourceAccessor (&TraciClient::m_positionsUpdatedTrace),
+                     "ns3::TraciClient::PositionsUpdatedTracedCallback")
   ;
     return tid;
   }
@@ -115,12 +185,23 @@ namespace ns3
 
     m_sumoSeed = 0;
     m_altitude = 1.5;
+    m_minPositionChange = 0.0;
+    m_extrapolate = false;
     m_sumoPort = 1338;
     m_sumoGUI = false;
+    m_subscriptionMode = false;
+    m_lookAhead = false;
+    m_backend = SOCKET_BACKEND;
+    m_resetMode = LOAD_RESET;
+    m_cacheHits = 0;
+    m_cacheMisses = 0;
     m_penetrationRate = 1.0;
     m_sumoLogFile = false;
     m_sumoStepLog = false;
-    m_sumoWaitForSocket = ns3::Seconds(1.0);
+    m_sumoWaitForSocket = ns3::Seconds(10.0);
+    m_sumoConnectBackoff = ns3::MilliSeconds(10);
+    m_sumoPid = -1;
+    m_shard = 0;
   }
 
   TraciClient::~TraciClient(void)
@@ -134,92 +215,270 @@ namespace ns3
   {
     NS_LOG_FUNCTION(this);
 
+    NS_LOG_INFO("Vehicle queries served locally: " << m_cacheHits << ", by traci round trip: " << m_cacheMisses);
+
     try
       {
-        this->TraCIAPI::close();
+        if (m_backend == LIBSUMO_BACKEND)
+          {
+            // the destructor calls SumoStop again
+            LibsumoBackend::Close();
+          }
+        else
+          {
+            this->TraCIAPI::close();
+          }
       }
     catch (std::exception& e)
       {
         NS_FATAL_ERROR("Problem while closing traci socket: " << e.what());
       }
+
+    // sumo quits on its own once the connection is closed
+    ReapSumoProcess(ns3::Seconds(1.0));
+
+    if (m_resetMode == LOAD_STATE_RESET && !m_sumoStateFile.empty())
+      {
+        std::remove(m_sumoStateFile.c_str());
+      }
   }
 
-  std::string
-  TraciClient::GetVehicleId(Ptr<Node> node)
+  void
+  TraciClient::SumoReset()
   {
     NS_LOG_FUNCTION(this);
 
-    std::string foundVeh("");
+    if (!m_includeNode)
+      {
+        NS_FATAL_ERROR("Call SumoSetup before SumoReset");
+      }
+
+    m_stepEvent.Cancel();
 
-    // search map for corresponding node
-    for (std::map<std::string, Ptr<Node> >::iterator it = m_vehicleNodeMap.begin(); it != m_vehicleNodeMap.end(); ++it)
+    try
       {
-        if (it->second == node)
+        if (m_backend == SOCKET_BACKEND)
           {
-            foundVeh = it->first;
-            break;
+            // the step requested in look-ahead mode and queued commands belong to the finished episode
+            if (this->TraCIAPI::isSimulationStepPending())
+              {
+                this->TraCIAPI::joinSimulationStep();
+              }
+            FlushCommands();
+          }
+
+        // exclude all nodes; the vehicles of the finished episode are gone after the reset
+        while (m_vehicleNodeMap.GetSize() > 0)
+          {
+            VehicleHandle veh = m_vehicleNodeMap.GetVehicles().back();
+            m_vehicleNodeMap.StopNode(veh);
+            if (m_registry)
+              {
+                m_registry->Unregister(m_vehicleIds.GetName(veh), m_shard);
+              }
+            m_excludeNode(m_vehicleNodeMap.Erase(veh));
+            m_releasedVehicles.push_back(veh);
+          }
+        m_vehicleNodeMap.Clear();
+        m_untrackedVehicles.clear();
+        m_positionVehicles.clear();
+
+        // release all handles together with the caches that refer to them; the table itself is kept
+        ClearStepCache();
+        NS_ASSERT(m_vehicleIds.GetSize() == 0);
+
+        if (m_resetMode == LOAD_STATE_RESET)
+          {
+            // pois added via traci are not part of the saved state
+            for (std::map<uint32_t, RsuContext>::iterator it = m_rsuContexts.begin(); it != m_rsuContexts.end(); ++it)
+              {
+                this->TraCIAPI::poi.remove(it->second.poi);
+              }
+
+            // restore the state at StartTime saved by SumoSetup; the network is not parsed again
+            this->TraCIAPI::simulation.loadState(m_sumoStateFile);
+          }
+        else
+          {
+            // reload the configuration within the running sumo instance and simulate until the specified time
+            if (m_backend == LIBSUMO_BACKEND)
+              {
+                LibsumoBackend::Close();
+                LibsumoBackend::Load(GetSumoArgs(false));
+              }
+            else
+              {
+                this->TraCIAPI::load(GetSumoArgs(false));
+              }
+            DoSimulationStep(m_startTime.GetSeconds());
+          }
+
+        // pois and context subscriptions do not survive the reset
+        for (std::map<uint32_t, RsuContext>::iterator it = m_rsuContexts.begin(); it != m_rsuContexts.end(); ++it)
+          {
+            SubscribeRsuContext(it->second);
           }
       }
+    catch (std::exception& e)
+      {
+        NS_FATAL_ERROR("Can not reset sumo: " << e.what());
+      }
 
-    return foundVeh;
+    StartEpisode();
   }
 
   std::string
-  TraciClient::GetSumoCmdString(void)
+  TraciClient::GetVehicleId(Ptr<Node> node)
   {
     NS_LOG_FUNCTION(this);
 
-    if (m_sumoConfigPath == "")
+    // reverse index by node id
+    VehicleHandle veh = m_vehicleNodeMap.GetVehicle(node);
+    if (veh == VehicleIdTable::INVALID)
       {
-        NS_FATAL_ERROR("Error: No path specified for sumo configuration! Use .SetAttribute('m_sumoConfigPath', ...) before calling .SetupSUMO");
+        return "";
       }
+    return m_vehicleIds.GetName(veh);
+  }
 
-    // sumo gui
-    if (m_sumoGUI)
-      {
-        m_sumoCommand = m_sumoBinaryPath + "sumo-gui -c";
-      }
-    else
+  VehicleHandle
+  TraciClient::GetVehicleHandle(Ptr<Node> node) const
+  {
+    return m_vehicleNodeMap.GetVehicle(node);
+  }
+
+  VehicleHandle
+  TraciClient::GetVehicleHandle(const std::string& veh) const
+  {
+    return m_vehicleIds.Lookup(veh);
+  }
+
+  const std::string&
+  TraciClient::GetVehicleName(VehicleHandle veh) const
+  {
+    return m_vehicleIds.GetName(veh);
+  }
+
+  std::vector<std::string>
+  TraciClient::GetSumoArgs(bool remotePort)
+  {
+    NS_LOG_FUNCTION(this << remotePort);
+
+    if (m_sumoConfigPath == "")
       {
-        m_sumoCommand = m_sumoBinaryPath + "sumo -c";
+        NS_FATAL_ERROR("Error: No path specified for sumo configuration! Use .SetAttribute('m_sumoConfigPath', ...) before calling .SetupSUMO");
       }
 
+    std::vector<std::string> args;
+
     // sumo path
-    m_sumoCommand += " " + m_sumoConfigPath;
+    args.push_back("-c");
+    args.push_back(m_sumoConfigPath);
 
     // remote port
-    m_sumoCommand += " --remote-port " + std::to_string(m_sumoPort);
+    if (remotePort)
+      {
+        args.push_back("--remote-port");
+        args.push_back(std::to_string(m_sumoPort));
+      }
 
     // synchronisation interval
-    m_sumoCommand += " --step-length " + std::to_string(m_synchInterval.GetSeconds());
+    args.push_back("--step-length");
+    args.push_back(std::to_string(m_synchInterval.GetSeconds()));
 
     // sumo log file
     if (m_sumoLogFile)
       {
         int pos = m_sumoConfigPath.find_last_of("/\\");
         std::string sumoDir = m_sumoConfigPath.substr(0, pos);
-        m_sumoCommand += " --error-log " + sumoDir + "/SumoError.log";
+        args.push_back("--error-log");
+        args.push_back(sumoDir + "/SumoError.log");
       }
 
     // sumo step log
-    if (m_sumoStepLog)
+    args.push_back("--no-step-log");
+    args.push_back(m_sumoStepLog ? "false" : "true");
+
+    // sumo random seed
+    if (m_sumoSeed)
       {
-        m_sumoCommand += " --no-step-log false";
+        args.push_back("--seed");
+        args.push_back(std::to_string(m_sumoSeed));
       }
-    else
+
+    // sumo additional command line options; separated by whitespace outside of single or double quotes, the quotes are
+    // removed as by a shell (sumo is started via execvp, not via a shell)
+    std::string opt;
+    bool inOpt = false;
+    char quote = 0;
+    for (std::string::const_iterator c = m_sumoAddCmdOpt.begin(); c != m_sumoAddCmdOpt.end(); ++c)
+      {
+        if (quote)
+          {
+            if (*c == quote)
+              {
+                quote = 0;
+              }
+            else
+              {
+                opt += *c;
+              }
+          }
+        else if (*c == '"' || *c == '\'')
+          {
+            quote = *c;
+            inOpt = true;
+          }
+        else if (std::isspace(static_cast<unsigned char>(*c)))
+          {
+            if (inOpt)
+              {
+                args.push_back(opt);
+                opt.clear();
+                inOpt = false;
+              }
+          }
+        else
+          {
+            opt += *c;
+            inOpt = true;
+          }
+      }
+    if (quote)
       {
-        m_sumoCommand += " --no-step-log true";
+        NS_FATAL_ERROR("Unbalanced quote in SumoAdditionalCmdOptions: " << m_sumoAddCmdOpt);
+      }
+    if (inOpt)
+      {
+        args.push_back(opt);
       }
 
-    // sumo random seed
-    if (m_sumoSeed)
+    args.push_back("--start");
+    args.push_back("--quit-on-end");
+
+    return args;
+  }
+
+  std::string
+  TraciClient::GetSumoCmdString(void)
+  {
+    NS_LOG_FUNCTION(this);
+
+    // sumo gui
+    if (m_sumoGUI)
+      {
+        m_sumoCommand = m_sumoBinaryPath + "sumo-gui";
+      }
+    else
       {
-        m_sumoCommand += " --seed " + std::to_string(m_sumoSeed);
+        m_sumoCommand = m_sumoBinaryPath + "sumo";
       }
 
-    // sumo additional command line options
-    m_sumoCommand += " " + m_sumoAddCmdOpt;
-    m_sumoCommand += " --start --quit-on-end &";
+    std::vector<std::string> args = GetSumoArgs(true);
+    for (std::vector<std::string>::iterator it = args.begin(); it != args.end(); ++it)
+      {
+        m_sumoCommand += " " + *it;
+      }
 
     return m_sumoCommand;
   }
@@ -233,40 +492,230 @@ namespace ns3
 
     m_includeNode = includeNode;
     m_excludeNode = excludeNode;
-    m_sumoCommand = GetSumoCmdString();
 
-    // start up sumo
-    int startCmd = std::system(m_sumoCommand.c_str());
-    if (startCmd)
+    if (m_registry)
       {
-        NS_LOG_INFO("Used the following command to start up sumo: " << m_sumoCommand);
+        m_shard = m_registry->AddShard(this);
       }
 
-    // wait 1 sec (=1e6 microsec) until sumo opens socket for traci connection
-    std::cout << "Sumo: wait for socket: " << m_sumoWaitForSocket.GetSeconds() << "s" << std::endl;
-    usleep(m_sumoWaitForSocket.GetMicroSeconds());
-
-    // connect to sumo via traci
-    try
+    if (m_backend == LIBSUMO_BACKEND)
       {
-        this->TraCIAPI::connect("localhost", m_sumoPort);
+        if (!LibsumoBackend::IsAvailable())
+          {
+            NS_FATAL_ERROR("SumoBackend Libsumo requires ns3 to be configured with --with-libsumo=<SUMO_HOME>");
+          }
+        if (m_sumoGUI || m_lookAhead)
+          {
+            NS_LOG_WARN("SumoGUI and LookAhead are not supported by the libsumo backend and are ignored");
+            m_sumoGUI = false;
+            m_lookAhead = false;
+          }
+
+        // load the simulation into this process; no socket, no start up delay
+        try
+          {
+            LibsumoBackend::Load(GetSumoArgs(false));
+          }
+        catch (std::exception& e)
+          {
+            NS_FATAL_ERROR("Can not load sumo simulation via libsumo: " << e.what());
+          }
       }
-    catch (std::exception& e)
+    else
       {
-        NS_FATAL_ERROR("Can not connect to sumo via traci: " << e.what());
+        StartSumoProcess();
       }
 
     // start sumo and simulate until the specified time
-    this->TraCIAPI::simulationStep(m_startTime.GetSeconds());
+    DoSimulationStep(m_startTime.GetSeconds());
+
+    // snapshot of the start for SumoReset
+    if (m_resetMode == LOAD_STATE_RESET)
+      {
+        if (m_backend == LIBSUMO_BACKEND)
+          {
+            NS_LOG_WARN("ResetMode LoadState is not supported by the libsumo backend; SumoReset reloads the configuration");
+            m_resetMode = LOAD_RESET;
+          }
+        else
+          {
+            if (m_sumoStateFile.empty())
+              {
+                int pos = m_sumoConfigPath.find_last_of("/\\");
+                m_sumoStateFile = m_sumoConfigPath.substr(0, pos) + "/SumoState-" + std::to_string(m_sumoPort) + ".xml";
+              }
+            try
+              {
+                this->TraCIAPI::simulation.saveState(m_sumoStateFile);
+              }
+            catch (std::exception& e)
+              {
+                NS_FATAL_ERROR("Can not save sumo state to " << m_sumoStateFile << ": " << e.what());
+              }
+          }
+      }
+
+    StartEpisode();
+  }
+
+  void
+  TraciClient::StartEpisode()
+  {
+    NS_LOG_FUNCTION(this);
+
+    // sumo is at StartTime now
+    m_sumoTimeOffset = m_startTime - Simulator::Now();
 
     // synchronise sumo vehicles with ns3 nodes
-    SynchroniseVehicleNodeMap();
+    SynchroniseVehicleNodeMap(true);
 
     // get current positions from sumo and uptdate positions
     UpdatePositions();
 
+    // let sumo compute the step of the first synchronisation point in the background
+    if (m_lookAhead)
+      {
+        this->TraCIAPI::simulationStepAsync(Simulator::Now().GetSeconds() + 2 * m_synchInterval.GetSeconds() + m_sumoTimeOffset.GetSeconds());
+      }
+
     // schedule event to command sumo the next simulation step
-    Simulator::Schedule(m_synchInterval, &TraciClient::SumoSimulationStep, this);
+    m_stepEvent = Simulator::Schedule(m_synchInterval, &TraciClient::SumoSimulationStep, this);
+  }
+
+  void
+  TraciClient::StartSumoProcess()
+  {
+    NS_LOG_FUNCTION(this);
+
+    // same binary and options as the command string, but without a shell in between
+    m_sumoCommand = GetSumoCmdString();
+    std::string binary = m_sumoBinaryPath + (m_sumoGUI ? "sumo-gui" : "sumo");
+    std::vector<std::string> args = GetSumoArgs(true);
+
+    std::vector<char*> argv;
+    argv.push_back(const_cast<char*>(binary.c_str()));
+    for (std::vector<std::string>::iterator it = args.begin(); it != args.end(); ++it)
+      {
+        argv.push_back(const_cast<char*>(it->c_str()));
+      }
+    argv.push_back(nullptr);
+
+    NS_LOG_INFO("Start up sumo: " << m_sumoCommand);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    m_sumoPid = fork();
+    if (m_sumoPid < 0)
+      {
+        NS_FATAL_ERROR("Can not start sumo: " << std::strerror(errno));
+      }
+    if (m_sumoPid == 0)
+      {
+        // child; execvp only returns on failure
+        execvp(argv[0], argv.data());
+        std::cerr << "Can not execute " << binary << ": " << std::strerror(errno) << std::endl;
+        _exit(127);
+      }
+
+    // connect to sumo via traci as soon as it accepts connections; back off exponentially in between
+    uint64_t timeout = m_sumoWaitForSocket.GetMicroSeconds();
+    uint64_t backoff = std::max<int64_t>(m_sumoConnectBackoff.GetMicroSeconds(), 1);
+    uint32_t attempts = 0;
+    while (true)
+      {
+        ++attempts;
+        try
+          {
+            this->TraCIAPI::connect("localhost", m_sumoPort);
+            break;
+          }
+        catch (tcpip::SocketException&)
+          {
+            // not listening yet
+          }
+
+        // give up early if sumo has already quit, e.g. because of an invalid configuration
+        int status;
+        if (waitpid(m_sumoPid, &status, WNOHANG) == m_sumoPid)
+          {
+            m_sumoPid = -1;
+            NS_FATAL_ERROR("Sumo exited during start up with status " << (WIFEXITED(status) ? WEXITSTATUS(status) : -1)
+                           << "; command: " << m_sumoCommand);
+          }
+
+        uint64_t elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        if (elapsed >= timeout)
+          {
+            ReapSumoProcess(ns3::Seconds(0.0));
+            NS_FATAL_ERROR("Can not connect to sumo via traci within " << m_sumoWaitForSocket.GetSeconds() << "s (" << attempts << " attempts)");
+          }
+
+        usleep(std::min(backoff, timeout - elapsed));
+        backoff = std::min<uint64_t>(2 * backoff, 100000);
+      }
+
+    Time startupTime = MicroSeconds(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+    NS_LOG_INFO("Sumo ready after " << startupTime.GetSeconds() << "s (" << attempts << " attempts)");
+    m_sumoStartupTrace(startupTime, attempts);
+  }
+
+  void
+  TraciClient::ReapSumoProcess(Time grace)
+  {
+    NS_LOG_FUNCTION(this << grace);
+
+    if (m_sumoPid <= 0)
+      {
+        return;
+      }
+
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(grace.GetMicroSeconds());
+    while (waitpid(m_sumoPid, nullptr, WNOHANG) == 0)
+      {
+        if (std::chrono::steady_clock::now() >= deadline)
+          {
+            NS_LOG_INFO("Terminate sumo process " << m_sumoPid);
+            kill(m_sumoPid, SIGTERM);
+            waitpid(m_sumoPid, nullptr, 0);
+            break;
+          }
+        usleep(10000);
+      }
+
+    m_sumoPid = -1;
+  }
+
+  void
+  TraciClient::DoSimulationStep(double time)
+  {
+    if (m_backend == LIBSUMO_BACKEND)
+      {
+        LibsumoBackend::SimulationStep(time);
+      }
+    else
+      {
+        this->TraCIAPI::simulationStep(time);
+      }
+  }
+
+  const libsumo::SubscriptionResults&
+  TraciClient::GetVehicleSubscriptionResults()
+  {
+    if (m_backend == LIBSUMO_BACKEND)
+      {
+        return LibsumoBackend::GetVehicleSubscriptionResults();
+      }
+    return this->TraCIAPI::vehicle.getModifiableSubscriptionResults();
+  }
+
+  const libsumo::SubscriptionResults&
+  TraciClient::GetContextSubscriptionResults(const std::string& poi)
+  {
+    if (m_backend == LIBSUMO_BACKEND)
+      {
+        return LibsumoBackend::GetPoiContextSubscriptionResults(poi);
+      }
+    return this->TraCIAPI::poi.getModifiableContextSubscriptionResults(poi);
   }
 
   void
@@ -274,13 +723,32 @@ namespace ns3
   {
     NS_LOG_FUNCTION(this);
 
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
     try
       {
         // get current simulation time
-        auto nextTime = Simulator::Now().GetSeconds() + m_synchInterval.GetSeconds() + m_startTime.GetSeconds();
+        auto nextTime = Simulator::Now().GetSeconds() + m_synchInterval.GetSeconds() + m_sumoTimeOffset.GetSeconds();
+
+        if (m_lookAhead)
+          {
+            // wait for the step requested at the last synchronisation point; sumo is at nextTime afterwards, as without look-ahead
+            this->TraCIAPI::joinSimulationStep();
+
+            // commands queued since the last synchronisation point take effect with the step requested below
+            FlushCommands();
+          }
+        else
+          {
+            // commands queued since the last step have to take effect in this step
+            FlushCommands();
 
-        // command sumo to simulate next time step
-        this->TraCIAPI::simulationStep(nextTime);
+            // command sumo to simulate next time step
+            DoSimulationStep(nextTime);
+          }
+
+        // vehicle state queried during the last step is outdated now
+        ClearStepCache();
 
         // include a ns3 node for every new sumo vehicle and exclude arrived vehicles
         SynchroniseVehicleNodeMap();
@@ -288,8 +756,19 @@ namespace ns3
         // ask sumo for new vehicle positions and update node positions
         UpdatePositions();
 
+        // sumo computes the step of the next synchronisation point while ns3 processes the events until then
+        if (m_lookAhead)
+          {
+            this->TraCIAPI::simulationStepAsync(nextTime + m_synchInterval.GetSeconds());
+          }
+
         // schedule next event to simulate next time step in sumo
-        Simulator::Schedule(m_synchInterval, &TraciClient::SumoSimulationStep, this);
+        m_stepEvent = Simulator::Schedule(m_synchInterval, &TraciClient::SumoSimulationStep, this);
+
+        if (m_registry)
+          {
+            m_registry->ReportStep(m_shard, NanoSeconds(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()));
+          }
       }
     catch (std::exception& e)
       {
@@ -304,20 +783,78 @@ namespace ns3
 
     try
       {
-        // iterate over all sumo vehicles in map
-        for (std::map<std::string, Ptr<Node> >::iterator it = m_vehicleNodeMap.begin(); it != m_vehicleNodeMap.end(); ++it)
+        // subscription results of all vehicles, received with the last simulation step
+        const libsumo::SubscriptionResults& subscriptions = GetVehicleSubscriptionResults();
+
+        // without subscriptions, ask sumo for all positions in a single batch (direct calls with libsumo)
+        if (!m_subscriptionMode && m_backend == SOCKET_BACKEND)
+          {
+            std::vector<int> vars = {VAR_POSITION};
+            if (m_extrapolate)
+              {
+                vars.push_back(VAR_SPEED);
+                vars.push_back(VAR_ANGLE);
+              }
+            PrefetchVehicleVariables(m_vehicleNodeMap.GetVehicles(), vars);
+          }
+
+        // collect the positions of all sumo vehicles in map, then apply them in one pass
+        const std::vector<VehicleHandle>& vehicles = m_vehicleNodeMap.GetVehicles();
+        m_positionVehicles.clear();
+        m_positions.clear();
+        m_velocities.clear();
+        m_positionVehicles.reserve(vehicles.size());
+        m_positions.reserve(vehicles.size());
+        for (std::vector<VehicleHandle>::const_iterator it = vehicles.begin(); it != vehicles.end(); ++it)
           {
             // get current sumo vehicle from map
-            std::string veh(it->first);
+            const std::string& veh = m_vehicleIds.GetName(*it);
+
+            libsumo::TraCIPosition pos;
+            if (m_subscriptionMode)
+              {
+                // read vehicle position from the subscription results; no extra round trip to sumo
+                libsumo::SubscriptionResults::const_iterator res = subscriptions.find(veh);
+                if (res == subscriptions.end() || res->second.find(VAR_POSITION) == res->second.end())
+                  {
+                    NS_LOG_WARN("No subscription result for vehicle " << veh << "; skip position update");
+                    continue;
+                  }
+                pos = *std::static_pointer_cast<libsumo::TraCIPosition>(res->second.at(VAR_POSITION));
+              }
+            else
+              {
+                // get vehicle position from the prefetched batch, single query if sumo could not answer it there
+                std::shared_ptr<libsumo::TraCIPosition> res = std::dynamic_pointer_cast<libsumo::TraCIPosition>(FindLocalVariable(*it, VAR_POSITION));
+                if (res)
+                  {
+                    pos = *res;
+                  }
+                else if (m_backend == LIBSUMO_BACKEND)
+                  {
+                    pos = LibsumoBackend::GetVehiclePosition(veh);
+                  }
+                else
+                  {
+                    pos = this->TraCIAPI::vehicle.getPosition(veh);
+                  }
+              }
 
-            // get vehicle position from sumo
-            libsumo::TraCIPosition pos(this->TraCIAPI::vehicle.getPosition(veh));
+            // ns3 node position with user defined altitude
+            m_positionVehicles.push_back(*it);
+            m_positions.push_back(Vector(pos.x, pos.y, m_altitude));
 
-            // get corresponding ns3 node from map
-            Ptr<MobilityModel> mob = m_vehicleNodeMap.at(veh)->GetObject<MobilityModel>();
-            // set ns3 node position with user defined altitude
-            mob->SetPosition(Vector(pos.x, pos.y, m_altitude));
+            // speed and angle come with the subscriptions or the prefetched batch
+            if (m_extrapolate)
+              {
+                m_velocities.push_back(GetSumoVelocity(GetVehicleDouble(*it, VAR_SPEED), GetVehicleDouble(*it, VAR_ANGLE)));
+              }
           }
+
+        // set positions (and velocities) through the mobility models cached by the vehicle node map
+        uint32_t moved = m_extrapolate ? m_vehicleNodeMap.SetPositions(m_positionVehicles, m_positions, m_velocities, m_minPositionChange)
+                                       : m_vehicleNodeMap.SetPositions(m_positionVehicles, m_positions, m_minPositionChange);
+        m_positionsUpdatedTrace(moved, m_positions.size());
       }
     catch (std::exception& e)
       {
@@ -325,8 +862,33 @@ namespace ns3
       }
   }
 
+  Vector
+  TraciClient::GetSumoVelocity(double speed, double angle)
+  {
+    // sumo angles are in degrees, clockwise from north (positive y axis)
+    double rad = angle * M_PI / 180.0;
+    return Vector(speed * std::sin(rad), speed * std::cos(rad), 0.0);
+  }
+
+  void
+  TraciClient::SubscribeVehicle(VehicleHandle veh)
+  {
+    NS_LOG_FUNCTION(this << veh);
+
+    // variables delivered with every simulation step response until the vehicle arrives
+    std::vector<int> vars = {VAR_POSITION, VAR_SPEED, VAR_ANGLE, VAR_LANE_INDEX};
+    if (m_backend == LIBSUMO_BACKEND)
+      {
+        LibsumoBackend::SubscribeVehicle(m_vehicleIds.GetName(veh), vars, 0.0, std::numeric_limits<double>::max());
+      }
+    else
+      {
+        this->TraCIAPI::vehicle.subscribe(m_vehicleIds.GetName(veh), vars, 0.0, std::numeric_limits<double>::max());
+      }
+  }
+
   void
-  TraciClient::GetSumoVehicles(std::vector<std::string>& sumoVehicles)
+  TraciClient::GetSumoVehicles(std::vector<VehicleHandle>& sumoVehicles, bool allVehicles)
   {
     NS_LOG_FUNCTION(this);
 
@@ -338,47 +900,51 @@ namespace ns3
 
     try
       {
+        // at the start of an episode, all vehicles in the simulation are new
+        if (allVehicles)
+          {
+            std::vector<std::string> vehicles = m_backend == LIBSUMO_BACKEND ? LibsumoBackend::GetVehicleIDList() : this->TraCIAPI::vehicle.getIDList();
+            for (std::vector<std::string>::iterator it = vehicles.begin(); it != vehicles.end(); ++it)
+              {
+                if (randVar->GetValue() <= m_penetrationRate)
+                  {
+                    sumoVehicles.push_back(m_vehicleIds.Intern(*it));
+                  }
+              }
+            return;
+          }
+
         // ask sumo for all (new) departed vehicles SINCE last simulation step (=one synch interval)
-        std::vector<std::string> departedVehicles = this->TraCIAPI::simulation.getDepartedIDList();
+        std::vector<std::string> departedVehicles = m_backend == LIBSUMO_BACKEND ? LibsumoBackend::GetDepartedIDList() : this->TraCIAPI::simulation.getDepartedIDList();
 
         // ask sumo for all (new) arrived vehicles SINCE last simulation step (=one synch interval)
-        std::vector<std::string> arrivedVehicles = this->TraCIAPI::simulation.getArrivedIDList();
+        std::vector<std::string> arrivedIDs = m_backend == LIBSUMO_BACKEND ? LibsumoBackend::GetArrivedIDList() : this->TraCIAPI::simulation.getArrivedIDList();
+        std::unordered_set<std::string> arrivedVehicles(arrivedIDs.begin(), arrivedIDs.end());
 
         // iterate over departed vehicles
         for (std::vector<std::string>::iterator it = departedVehicles.begin(); it != departedVehicles.end(); ++it)
           {
-            // get departed vehicle
-            std::string veh(*it);
-
-            // search for same vehicle in arrived vehicles
-            std::vector<std::string>::iterator pos = std::find(arrivedVehicles.begin(), arrivedVehicles.end(), veh);
-
             // if vehicle is found in both lists, ignore it; all others are considered as relevant vehicles for simulation
-            if (pos != arrivedVehicles.end())
+            if (arrivedVehicles.erase(*it))
               {
-                arrivedVehicles.erase(pos);
+                continue;
               }
-            else
+
+            // penetration rate determines number of included nodes; ids are interned only for included vehicles
+            if (randVar->GetValue() <= m_penetrationRate)
               {
-                // penetration rate determines number of included nodes
-                if (randVar->GetValue() <= m_penetrationRate)
-                  {
-                    sumoVehicles.push_back(veh);
-                  }
+                sumoVehicles.push_back(m_vehicleIds.Intern(*it));
               }
           }
 
         // iterate over arrived vehicles
-        for (std::vector<std::string>::iterator it = arrivedVehicles.begin(); it != arrivedVehicles.end(); ++it)
+        for (std::unordered_set<std::string>::iterator it = arrivedVehicles.begin(); it != arrivedVehicles.end(); ++it)
           {
-            // get arrived vehicle
-            std::string veh(*it);
-
-            // search for arrived vehicle in vehicleNodeMap
-            std::map<std::string, Ptr<Node> >::iterator pos = m_vehicleNodeMap.find(veh);
+            // get arrived vehicle; unknown ids were never simulated in ns3
+            VehicleHandle veh = m_vehicleIds.Lookup(*it);
 
             // if node is in map, exclude it, otherwise is was not simulated in ns3 because of the penetration rate
-            if (pos != m_vehicleNodeMap.end())
+            if (m_vehicleNodeMap.Contains(veh))
               {
                 sumoVehicles.push_back(veh);
               }
@@ -391,44 +957,60 @@ namespace ns3
   }
 
   void
-  TraciClient::SynchroniseVehicleNodeMap()
+  TraciClient::SynchroniseVehicleNodeMap(bool allVehicles)
   {
-    NS_LOG_FUNCTION(this);
+    NS_LOG_FUNCTION(this << allVehicles);
 
     try
       {
         // get departed and arrived sumo vehicles since last simulation step
-        std::vector<std::string> sumoVehicles;
-        GetSumoVehicles(sumoVehicles);
+        std::vector<VehicleHandle> sumoVehicles;
+        GetSumoVehicles(sumoVehicles, allVehicles);
 
         // iterate over all sumo vehicles with changes; include departed vehicles, exclude arrived vehicles
-        for (std::vector<std::string>::iterator it = sumoVehicles.begin(); it != sumoVehicles.end(); ++it)
+        for (std::vector<VehicleHandle>::iterator it = sumoVehicles.begin(); it != sumoVehicles.end(); ++it)
           {
             // get current vehicle
-            std::string veh(*it);
-
-            // search for vehicle in vehicleNodeMap
-            std::map<std::string, Ptr<Node> >::iterator pos = m_vehicleNodeMap.find(veh);
+            VehicleHandle veh = *it;
 
-            // if it is already in the map, remove it and exclude node
-            if (pos != m_vehicleNodeMap.end())
+            // if it is already in the map, unregister it and exclude node; an extrapolating node must not move on
+            m_vehicleNodeMap.StopNode(veh);
+            Ptr<ns3::Node> exNode = m_vehicleNodeMap.Erase(veh);
+            if (exNode)
               {
-                // get corresponding ns3 node
-                Ptr<ns3::Node> exNode = m_vehicleNodeMap.at(veh);
-
-                // call exclude function for this node
-                m_excludeNode(exNode);
+                m_releasedVehicles.push_back(veh);
 
-                // unregister in map
-                m_vehicleNodeMap.erase(veh);
+                // call exclude function for this node; with sharding, another shard may take the node over first
+                if (m_registry)
+                  {
+                    m_registry->Release(m_vehicleIds.GetName(veh), m_shard, m_excludeNode);
+                  }
+                else
+                  {
+                    m_excludeNode(exNode);
+                  }
               }
             else // if it is not in the map, create a new ns3 node for it
               {
-                // create new node by calling the include function
-                Ptr<ns3::Node> inNode = m_includeNode();
+                // take the node over if the vehicle comes from another shard, create new node by calling the include function otherwise
+                Ptr<ns3::Node> inNode = m_registry ? m_registry->Acquire(m_vehicleIds.GetName(veh), m_shard) : 0;
+                if (!inNode)
+                  {
+                    inNode = m_includeNode();
+                  }
 
                 // register in the map (link vehicle to node!)
-                m_vehicleNodeMap.insert(std::pair<std::string, Ptr<Node>>(veh, inNode));
+                m_vehicleNodeMap.Insert(veh, inNode);
+                if (m_registry)
+                  {
+                    m_registry->Register(m_vehicleIds.GetName(veh), m_shard, inNode);
+                  }
+
+                // sumo drops the subscription by itself when the vehicle arrives
+                if (m_subscriptionMode)
+                  {
+                    SubscribeVehicle(veh);
+                  }
               }
           }
       }
@@ -441,9 +1023,317 @@ namespace ns3
 uint32_t
 TraciClient::GetVehicleMapSize()
 {
-return m_vehicleNodeMap.size();
+return m_vehicleNodeMap.GetSize();
 }
 
+  Ptr<Node>
+  TraciClient::UnlinkVehicle(const std::string& veh)
+  {
+    NS_LOG_FUNCTION(this << veh);
+
+    // sumo reports the arrival of the vehicle later on, which is then ignored
+    VehicleHandle handle = m_vehicleIds.Lookup(veh);
+    Ptr<Node> node = m_vehicleNodeMap.Erase(handle);
+    if (node)
+      {
+        m_releasedVehicles.push_back(handle);
+      }
+    return node;
+  }
+
+  void
+  TraciClient::AddRsuContextSubscription(Ptr<Node> rsu, double radius, const std::vector<int>& vars)
+  {
+    NS_LOG_FUNCTION(this << rsu << radius);
+
+    // sumo context subscriptions need a sumo object as center; place a poi at the rsu position
+    RsuContext context;
+    context.poi = "ns3-rsu-" + std::to_string(rsu->GetId());
+    context.position = rsu->GetObject<MobilityModel>()->GetPosition();
+    context.radius = radius;
+    context.vars = vars;
+
+    try
+      {
+        SubscribeRsuContext(context);
+      }
+    catch (std::exception& e)
+      {
+        NS_FATAL_ERROR("Can not subscribe to rsu context (call after SumoSetup): " << e.what());
+      }
+
+    m_rsuContexts[rsu->GetId()] = context;
+  }
+
+  void
+  TraciClient::SubscribeRsuContext(const RsuContext& context)
+  {
+    NS_LOG_FUNCTION(this << context.poi);
+
+    libsumo::TraCIColor color;
+    color.r = 255;
+    color.g = 0;
+    color.b = 0;
+    color.a = 255;
+    // all vehicles within radius around the poi report the given variables
+    if (m_backend == LIBSUMO_BACKEND)
+      {
+        LibsumoBackend::AddPoi(context.poi, context.position.x, context.position.y, color, "ns3-rsu", 0);
+        LibsumoBackend::SubscribePoiContext(context.poi, CMD_GET_VEHICLE_VARIABLE, context.radius, context.vars, 0.0, std::numeric_limits<double>::max());
+      }
+    else
+      {
+        this->TraCIAPI::poi.add(context.poi, context.position.x, context.position.y, color, "ns3-rsu", 0);
+        this->TraCIAPI::poi.subscribeContext(context.poi, CMD_GET_VEHICLE_VARIABLE, context.radius, context.vars, 0.0, std::numeric_limits<double>::max());
+      }
+  }
+
+  const libsumo::SubscriptionResults&
+  TraciClient::GetRsuContext(Ptr<Node> rsu)
+  {
+    NS_LOG_FUNCTION(this << rsu);
+
+    std::map<uint32_t, RsuContext>::iterator it = m_rsuContexts.find(rsu->GetId());
+    if (it == m_rsuContexts.end())
+      {
+        NS_FATAL_ERROR("No context subscription registered for rsu node " << rsu->GetId());
+      }
+
+    // results are cleared and refilled by every simulation step
+    return GetContextSubscriptionResults(it->second.poi);
+  }
+
+  std::shared_ptr<libsumo::TraCIResult>
+  TraciClient::FindLocalVariable(VehicleHandle veh, int variable)
+  {
+    // queried before within this simulation step
+    std::map<std::pair<VehicleHandle, int>, std::shared_ptr<libsumo::TraCIResult> >::iterator cached = m_stepCache.find(std::make_pair(veh, variable));
+    if (cached != m_stepCache.end())
+      {
+        return cached->second;
+      }
+
+    // subscription results are keyed by sumo id
+    const std::string& name = m_vehicleIds.GetName(veh);
+
+    // delivered with the last simulation step by the vehicle subscription
+    const libsumo::SubscriptionResults& subscriptions = GetVehicleSubscriptionResults();
+    libsumo::SubscriptionResults::const_iterator subIt = subscriptions.find(name);
+    if (subIt != subscriptions.end())
+      {
+        libsumo::TraCIResults::const_iterator varIt = subIt->second.find(variable);
+        if (varIt != subIt->second.end())
+          {
+            return varIt->second;
+          }
+      }
+
+    // delivered with the last simulation step by a rsu context subscription
+    for (std::map<uint32_t, RsuContext>::iterator it = m_rsuContexts.begin(); it != m_rsuContexts.end(); ++it)
+      {
+        const libsumo::SubscriptionResults& context = GetContextSubscriptionResults(it->second.poi);
+
+        libsumo::SubscriptionResults::const_iterator vehIt = context.find(name);
+        if (vehIt != context.end())
+          {
+            libsumo::TraCIResults::const_iterator varIt = vehIt->second.find(variable);
+            if (varIt != vehIt->second.end())
+              {
+                return varIt->second;
+              }
+          }
+      }
+
+    return std::shared_ptr<libsumo::TraCIResult>();
+  }
+
+  double
+  TraciClient::GetVehicleDouble(VehicleHandle veh, int variable)
+  {
+    NS_LOG_FUNCTION(this << veh << variable);
+
+    std::shared_ptr<libsumo::TraCIDouble> value = std::dynamic_pointer_cast<libsumo::TraCIDouble>(FindLocalVariable(veh, variable));
+    if (value)
+      {
+        ++m_cacheHits;
+        return value->value;
+      }
+
+    ++m_cacheMisses;
+    const std::string& name = m_vehicleIds.GetName(veh);
+    value = std::make_shared<libsumo::TraCIDouble>(m_backend == LIBSUMO_BACKEND ? LibsumoBackend::GetVehicleDouble(name, variable)
+                                                                               : this->TraCIAPI::getDouble(CMD_GET_VEHICLE_VARIABLE, variable, name));
+    m_stepCache[std::make_pair(veh, variable)] = value;
+    return value->value;
+  }
+
+  int
+  TraciClient::GetVehicleInt(VehicleHandle veh, int variable)
+  {
+    NS_LOG_FUNCTION(this << veh << variable);
+
+    std::shared_ptr<libsumo::TraCIInt> value = std::dynamic_pointer_cast<libsumo::TraCIInt>(FindLocalVariable(veh, variable));
+    if (value)
+      {
+        ++m_cacheHits;
+        return value->value;
+      }
+
+    ++m_cacheMisses;
+    const std::string& name = m_vehicleIds.GetName(veh);
+    value = std::make_shared<libsumo::TraCIInt>(m_backend == LIBSUMO_BACKEND ? LibsumoBackend::GetVehicleInt(name, variable)
+                                                                            : this->TraCIAPI::getInt(CMD_GET_VEHICLE_VARIABLE, variable, name));
+    m_stepCache[std::make_pair(veh, variable)] = value;
+    return value->value;
+  }
+
+  std::pair<VehicleHandle, double>
+  TraciClient::GetVehicleLeader(VehicleHandle veh, double dist)
+  {
+    NS_LOG_FUNCTION(this << veh << dist);
+
+    std::pair<VehicleHandle, double> key(veh, dist);
+    std::map<std::pair<VehicleHandle, double>, std::pair<VehicleHandle, double> >::iterator cached = m_leaderCache.find(key);
+    if (cached != m_leaderCache.end())
+      {
+        ++m_cacheHits;
+        return cached->second;
+      }
+
+    ++m_cacheMisses;
+    const std::string& name = m_vehicleIds.GetName(veh);
+    std::pair<std::string, double> reply = m_backend == LIBSUMO_BACKEND ? LibsumoBackend::GetVehicleLeader(name, dist)
+                                                                        : this->TraCIAPI::vehicle.getLeader(name, dist);
+
+    // sumo reports an empty id if there is no leader; the leader may be an untracked vehicle
+    std::pair<VehicleHandle, double> leader(VehicleIdTable::INVALID, reply.second);
+    if (!reply.first.empty())
+      {
+        leader.first = m_vehicleIds.Intern(reply.first);
+      }
+    m_leaderCache[key] = leader;
+    return leader;
+  }
+
+  void
+  TraciClient::PrefetchVehicleVariables(const std::vector<VehicleHandle>& vehicles, const std::vector<int>& vars)
+  {
+    NS_LOG_FUNCTION(this << vehicles.size() << vars.size());
+
+    // libsumo queries are plain function calls; nothing to batch
+    if (m_backend == LIBSUMO_BACKEND)
+      {
+        return;
+      }
+
+    // queue every variable not known yet within this step; (vehicle, variable) per batch index
+    std::vector<std::pair<VehicleHandle, int> > queued;
+    for (std::vector<VehicleHandle>::const_iterator veh = vehicles.begin(); veh != vehicles.end(); ++veh)
+      {
+        for (std::vector<int>::const_iterator var = vars.begin(); var != vars.end(); ++var)
+          {
+            if (!FindLocalVariable(*veh, *var))
+              {
+                int index = this->TraCIAPI::queueGetVariable(CMD_GET_VEHICLE_VARIABLE, *var, m_vehicleIds.GetName(*veh));
+                queued.resize(index + 1, std::make_pair(VehicleIdTable::INVALID, 0));
+                queued[index] = std::make_pair(*veh, *var);
+              }
+          }
+      }
+
+    if (queued.empty())
+      {
+        return;
+      }
+
+    // queued set commands are sent with the same batch
+    FlushCommands();
+
+    for (uint32_t i = 0; i < queued.size(); ++i)
+      {
+        if (queued[i].first == VehicleIdTable::INVALID)
+          {
+            continue;
+          }
+        std::shared_ptr<libsumo::TraCIResult> res = this->TraCIAPI::getBatchResult(i);
+        if (res)
+          {
+            ++m_cacheMisses;
+            m_stepCache[queued[i]] = res;
+          }
+      }
+  }
+
+  void
+  TraciClient::SetVehicleSpeed(VehicleHandle veh, double speed)
+  {
+    NS_LOG_FUNCTION(this << veh << speed);
+
+    if (m_backend == LIBSUMO_BACKEND)
+      {
+        LibsumoBackend::SetVehicleSpeed(m_vehicleIds.GetName(veh), speed);
+        return;
+      }
+
+    tcpip::Storage content;
+    content.writeUnsignedByte(TYPE_DOUBLE);
+    content.writeDouble(speed);
+    this->TraCIAPI::queueSetValue(CMD_SET_VEHICLE_VARIABLE, VAR_SPEED, m_vehicleIds.GetName(veh), content);
+  }
+
+  void
+  TraciClient::FlushCommands()
+  {
+    NS_LOG_FUNCTION(this << this->TraCIAPI::getBatchSize());
+
+    try
+      {
+        this->TraCIAPI::flushBatch();
+      }
+    catch (libsumo::TraCIException& e)
+      {
+        // e.g. a vehicle left the network between queueing and flushing; sumo executed the other commands and all
+        // responses were read, the rejected gets have no result
+        NS_LOG_WARN("Sumo rejected batched commands, the first error was: " << e.what());
+      }
+  }
+
+  uint64_t
+  TraciClient::GetCacheHits() const
+  {
+    return m_cacheHits;
+  }
+
+  uint64_t
+  TraciClient::GetCacheMisses() const
+  {
+    return m_cacheMisses;
+  }
+
+  void
+  TraciClient::ClearStepCache(void)
+  {
+    NS_LOG_FUNCTION(this);
+
+    // leaders without node were interned for the cache only
+    for (std::map<std::pair<VehicleHandle, double>, std::pair<VehicleHandle, double> >::iterator it = m_leaderCache.begin(); it != m_leaderCache.end(); ++it)
+      {
+        m_releasedVehicles.push_back(it->second.first);
+      }
+    m_stepCache.clear();
+    m_leaderCache.clear();
+
+    // a handle is assigned again by the next Intern, so only vehicles that are (still) not linked are released
+    for (std::vector<VehicleHandle>::iterator it = m_releasedVehicles.begin(); it != m_releasedVehicles.end(); ++it)
+      {
+        if (!m_vehicleNodeMap.Contains(*it))
+          {
+            m_vehicleIds.Release(*it);
+          }
+      }
+    m_releasedVehicles.clear();
+  }
+
 bool
 TraciClient::PortFreeCheck (uint32_t portNum)
 {
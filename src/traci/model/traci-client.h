@@ -24,6 +24,7 @@
 #define TRACI_H
 
 #include <map>
+#include <unordered_set>
 #include <vector>
 #include <string>
 #include <functional>
@@ -31,12 +32,18 @@
 #include <signal.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <sys/types.h>
 
 #include "ns3/core-module.h"
 #include "ns3/mobility-module.h"
+#include "ns3/traced-callback.h"
 
 #include "sumo-TraCIAPI.h"
 #include "sumo-TraCIDefs.h"
+#include "libsumo-backend.h"
+#include "vehicle-id-table.h"
+#include "vehicle-node-map.h"
+#include "vehicle-registry.h"
 
 namespace ns3 {
 
@@ -46,6 +53,20 @@ public:
   // register this type with the TypeId system.
   static TypeId GetTypeId (void);
 
+  // how sumo is run: as child process connected via a traci socket, or embedded via libsumo
+  enum SumoBackend
+  {
+    SOCKET_BACKEND,
+    LIBSUMO_BACKEND
+  };
+
+  // how SumoReset brings sumo back to the start: reload the configuration, or restore the state saved by SumoSetup
+  enum ResetMode
+  {
+    LOAD_RESET,
+    LOAD_STATE_RESET
+  };
+
   // constructor and destructor
   TraciClient (void);
   ~TraciClient(void);
@@ -55,33 +76,149 @@ public:
 
   void SumoStop();
 
+  // start a new episode in the running sumo instance: all nodes are excluded and sumo is reset to StartTime, then the
+  // vehicles present at that time are included again; all handles of the previous episode are released with their nodes
+  void SumoReset();
+
   // get associated sumo vehicle for ns3 node
   std::string GetVehicleId(Ptr<Node> node);
 
+  // handle of the sumo vehicle associated with a ns3 node; VehicleIdTable::INVALID if the node is not linked
+  VehicleHandle GetVehicleHandle(Ptr<Node> node) const;
+
+  // handle of a sumo vehicle id (VehicleIdTable::INVALID if unknown) and sumo id of a handle; use at the traci boundary only
+  VehicleHandle GetVehicleHandle(const std::string& veh) const;
+  const std::string& GetVehicleName(VehicleHandle veh) const;
+
   uint32_t GetVehicleMapSize(); // size of vehicle map
 
+  // unlink a vehicle without excluding its node, which is handed over to another shard; 0 if the vehicle is not linked
+  Ptr<Node> UnlinkVehicle(const std::string& veh);
+
+  // register a sumo context subscription around a (stationary) rsu node; vehicles within radius report the given variables with every simulation step
+  void AddRsuContextSubscription(Ptr<Node> rsu, double radius, const std::vector<int>& vars);
+
+  // table of all vehicles around the rsu as reported with the last simulation step (vehicle -> variable -> value)
+  const libsumo::SubscriptionResults& GetRsuContext(Ptr<Node> rsu);
+
+  // read a vehicle variable; served from the step cache, the vehicle subscriptions or the rsu context tables,
+  // falls back to a direct traci query whose result is cached until the next simulation step
+  double GetVehicleDouble(VehicleHandle veh, int variable);
+  int GetVehicleInt(VehicleHandle veh, int variable);
+
+  // leader of a vehicle (VehicleIdTable::INVALID if there is none) and its distance; cached until the next simulation step,
+  // as is the handle of a leader that is not linked to a node
+  std::pair<VehicleHandle, double> GetVehicleLeader(VehicleHandle veh, double dist);
+
+  // fetch variables of many vehicles with a single traci round trip into the step cache; variables available locally are skipped
+  void PrefetchVehicleVariables(const std::vector<VehicleHandle>& vehicles, const std::vector<int>& vars);
+
+  // queue a speed change; queued commands are sent as one batch before the next simulation step
+  void SetVehicleSpeed(VehicleHandle veh, double speed);
+
+  // velocity vector of a sumo vehicle from its speed (m/s) and angle (degrees, clockwise from north)
+  static Vector GetSumoVelocity(double speed, double angle);
+
+  // number of vehicle queries served locally (hits) and fetched from sumo (misses)
+  uint64_t GetCacheHits() const;
+  uint64_t GetCacheMisses() const;
+
+  /**
+   * TracedCallback signature for the sumo start up.
+   *
+   * \param [in] startupTime Wall clock time from spawning sumo until the traci connection was established.
+   * \param [in] attempts Number of connection attempts.
+   */
+  typedef void (* SumoStartupTracedCallback)(Time startupTime, uint32_t attempts);
+
+  /**
+   * TracedCallback signature for the position synchronisation.
+   *
+   * \param [in] moved Number of nodes whose position was set.
+   * \param [in] vehicles Number of vehicles with a known position.
+   */
+  typedef void (* PositionsUpdatedTracedCallback)(uint32_t moved, uint32_t vehicles);
+
 private:
   // perform sumo simulation for a certain time step
   void SumoSimulationStep(void);
 
+  // link the vehicles present at the start, update their positions and schedule the first synchronisation step
+  void StartEpisode(void);
+
+  // send all queued commands as one batch; sumo errors of single commands are logged
+  void FlushCommands(void);
+
   // get current positions from sumo vehicles and update corresponding ns3 nodes positions
   void UpdatePositions(void);
 
-  // get new (departed) and removed (arrived) vehicles from sumo
-  void GetSumoVehicles(std::vector<std::string>& sumoVehicles);
+  // subscribe a departed sumo vehicle to position, speed, angle and lane; results arrive with every simulation step
+  void SubscribeVehicle(VehicleHandle veh);
+
+  // sumo context subscription around a rsu; kept to renew it after a reset
+  struct RsuContext
+  {
+    std::string poi;
+    Vector position;
+    double radius;
+    std::vector<int> vars;
+  };
+  void SubscribeRsuContext(const RsuContext& context);
+
+  // get new (departed) and removed (arrived) vehicles from sumo, or all vehicles currently in the simulation; included vehicles are interned
+  void GetSumoVehicles(std::vector<VehicleHandle>& sumoVehicles, bool allVehicles);
 
   // synchronise ns3 nodes with sumo vehicles
-  void SynchroniseVehicleNodeMap(void);
+  void SynchroniseVehicleNodeMap(bool allVehicles = false);
+
+  // start sumo as child process and connect to it via traci as soon as its socket is ready
+  void StartSumoProcess(void);
+
+  // wait up to grace for the sumo child process to exit, terminate it otherwise
+  void ReapSumoProcess(Time grace);
 
   // build command line string for sumo start up
   std::string GetSumoCmdString (void);
 
-  // map every sumo vehicle to a ns3 node
-  std::map< std::string, Ptr<Node> > m_vehicleNodeMap;
+  // sumo command line options without binary; the remote port is only needed for the socket backend
+  std::vector<std::string> GetSumoArgs (bool remotePort);
+
+  // backend dependent sumo access
+  void DoSimulationStep (double time);
+  const libsumo::SubscriptionResults& GetVehicleSubscriptionResults (void);
+  const libsumo::SubscriptionResults& GetContextSubscriptionResults (const std::string& poi);
+
+  // search the step cache, vehicle subscriptions and rsu context tables for a vehicle variable; null if not available locally
+  std::shared_ptr<libsumo::TraCIResult> FindLocalVariable(VehicleHandle veh, int variable);
+
+  // drop the vehicle state of the last step and release the handles of vehicles without node
+  void ClearStepCache(void);
+
+  // compact handles of the sumo vehicles linked to a node (and of leaders until the next step)
+  VehicleIdTable m_vehicleIds;
+
+  // handles of unlinked vehicles; released with the step cache, which may still refer to them
+  std::vector<VehicleHandle> m_releasedVehicles;
+
+  // map every sumo vehicle to a ns3 node and back
+  VehicleNodeMap m_vehicleNodeMap;
 
   // a vehicle is untracked if it is simulated in sumo but not linked to a ns3 node because of an penetration rate < 1.0
   std::vector<std::string> m_untrackedVehicles;
 
+  // rsu context subscriptions (rsu node id -> context)
+  std::map<uint32_t, RsuContext> m_rsuContexts;
+
+  // vehicle variables queried since the last simulation step ((vehicle, variable) -> value)
+  std::map<std::pair<VehicleHandle, int>, std::shared_ptr<libsumo::TraCIResult> > m_stepCache;
+  std::map<std::pair<VehicleHandle, double>, std::pair<VehicleHandle, double> > m_leaderCache;
+  uint64_t m_cacheHits;
+  uint64_t m_cacheMisses;
+
+  // vehicles shared with the clients of other sumo instances; 0 without sharding
+  Ptr<VehicleRegistry> m_registry;
+  uint32_t m_shard;
+
   // function pointers to node include/exclude functions 
   std::function<Ptr<Node>()> m_includeNode;
   std::function<void(Ptr<Node>)> m_excludeNode;
@@ -97,6 +234,17 @@ private:
   std::string m_sumoBinaryPath;
   uint16_t m_sumoPort;
   bool m_sumoGUI;
+  bool m_subscriptionMode;
+  bool m_lookAhead;
+  SumoBackend m_backend;
+  ResetMode m_resetMode;
+  std::string m_sumoStateFile;
+
+  // ns3 time + offset = sumo time; sumo is at StartTime at the begin of every episode
+  ns3::Time m_sumoTimeOffset;
+
+  // next synchronisation step; cancelled by a reset
+  EventId m_stepEvent;
 
   double m_penetrationRate;
   ns3::Time m_synchInterval;
@@ -105,8 +253,22 @@ private:
   bool m_sumoLogFile;
   bool m_sumoStepLog;
   double m_altitude;
+  double m_minPositionChange;
+  bool m_extrapolate;
+
+  // vehicles and positions of the last synchronisation step; kept to reuse their storage
+  std::vector<VehicleHandle> m_positionVehicles;
+  std::vector<Vector> m_positions;
+  std::vector<Vector> m_velocities;
   int m_sumoSeed;
   ns3::Time m_sumoWaitForSocket;
+  ns3::Time m_sumoConnectBackoff;
+
+  // sumo child process; -1 if not running
+  pid_t m_sumoPid;
+
+  TracedCallback<Time, uint32_t> m_sumoStartupTrace;
+  TracedCallback<uint32_t, uint32_t> m_positionsUpdatedTrace;
 
 };
 
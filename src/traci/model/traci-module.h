@@ -12,5 +12,10 @@
 #include "sumo-TraCIAPI.h"
 #include "sumo-TraCIConstants.h"
 #include "sumo-TraCIDefs.h"
+#include "libsumo-backend.h"
 #include "traci-client.h"
+#include "vehicle-id-table.h"
+#include "vehicle-node-map.h"
+#include "vehicle-registry.h"
+#include "vehicle-node-pool.h"
 #endif
@@ -0,0 +1,112 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/fatal-error.h"
+
+#include "vehicle-id-table.h"
+
+namespace ns3
+{
+  const VehicleHandle VehicleIdTable::INVALID;
+
+  VehicleIdTable::VehicleIdTable (void)
+  {
+  }
+
+  VehicleHandle
+  VehicleIdTable::Intern (const std::string& veh)
+  {
+    VehicleHandle next = m_free.empty () ? static_cast<VehicleHandle> (m_names.size ()) : *m_free.begin ();
+    std::pair<std::unordered_map<std::string, VehicleHandle>::iterator, bool> res =
+        m_handles.insert (std::make_pair (veh, next));
+    if (res.second)
+      {
+        if (next == m_names.size ())
+          {
+            m_names.push_back (veh);
+          }
+        else
+          {
+            m_free.erase (m_free.begin ());
+            m_names[next] = veh;
+          }
+      }
+    return res.first->second;
+  }
+
+  VehicleHandle
+  VehicleIdTable::Lookup (const std::string& veh) const
+  {
+    std::unordered_map<std::string, VehicleHandle>::const_iterator it = m_handles.find (veh);
+    if (it == m_handles.end ())
+      {
+        return INVALID;
+      }
+    return it->second;
+  }
+
+  const std::string&
+  VehicleIdTable::GetName (VehicleHandle handle) const
+  {
+    if (handle >= m_names.size () || m_names[handle].empty ())
+      {
+        NS_FATAL_ERROR ("Unknown vehicle handle " << handle);
+      }
+    return m_names[handle];
+  }
+
+  void
+  VehicleIdTable::Release (VehicleHandle handle)
+  {
+    if (handle >= m_names.size () || m_names[handle].empty ())
+      {
+        return;
+      }
+
+    m_handles.erase (m_names[handle]);
+    m_names[handle].clear ();
+    m_free.insert (handle);
+
+    // shrink the handle range if its top is free
+    while (!m_names.empty () && m_names.back ().empty ())
+      {
+        m_free.erase (static_cast<VehicleHandle> (m_names.size () - 1));
+        m_names.pop_back ();
+      }
+  }
+
+  uint32_t
+  VehicleIdTable::GetSize (void) const
+  {
+    return m_handles.size ();
+  }
+
+  uint32_t
+  VehicleIdTable::GetCapacity (void) const
+  {
+    return m_names.size ();
+  }
+
+  void
+  VehicleIdTable::Clear (void)
+  {
+    m_handles.clear ();
+    m_names.clear ();
+    m_free.clear ();
+  }
+
+} // namespace ns3
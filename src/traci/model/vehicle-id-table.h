@@ -0,0 +1,85 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef VEHICLE_ID_TABLE_H
+#define VEHICLE_ID_TABLE_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <set>
+#include <unordered_map>
+
+namespace ns3 {
+
+// compact handle of an interned sumo vehicle id
+typedef uint32_t VehicleHandle;
+
+/**
+ * Interning table for sumo vehicle ids.
+ *
+ * Every id gets a dense 32-bit handle the first time it is seen. Handles are
+ * local to the table of one TraciClient: the clients of several sumo
+ * instances (shards) assign different handles to the same vehicle, so a
+ * handle must not leave the process, e.g. in a packet. Use the sumo id there.
+ *
+ * Handles of released ids are assigned again, lowest first, so the handle
+ * range (and every array indexed by handle) is bounded by the number of ids
+ * interned at the same time rather than by all vehicles ever seen.
+ */
+class VehicleIdTable
+{
+public:
+  // handle of an unknown vehicle
+  static const VehicleHandle INVALID = 0xffffffff;
+
+  VehicleIdTable (void);
+
+  // handle of a vehicle id; a new handle is assigned if the id is unknown
+  VehicleHandle Intern (const std::string& veh);
+
+  // handle of a vehicle id or INVALID if the id was never interned
+  VehicleHandle Lookup (const std::string& veh) const;
+
+  // sumo id of a handle; needed at the traci boundary only
+  const std::string& GetName (VehicleHandle handle) const;
+
+  // forget the id of a handle, which may be assigned to another id afterwards; unknown handles are ignored
+  void Release (VehicleHandle handle);
+
+  // number of interned ids
+  uint32_t GetSize (void) const;
+
+  // upper bound of all handles in use
+  uint32_t GetCapacity (void) const;
+
+  void Clear (void);
+
+private:
+  // vehicle id -> handle
+  std::unordered_map<std::string, VehicleHandle> m_handles;
+
+  // handle -> vehicle id; empty for released handles
+  std::vector<std::string> m_names;
+
+  // released handles below m_names.size ()
+  std::set<VehicleHandle> m_free;
+};
+
+} // namespace ns3
+
+#endif /* VEHICLE_ID_TABLE_H */
@@ -0,0 +1,256 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <limits>
+
+#include "ns3/assert.h"
+#include "ns3/abort.h"
+
+#include "vehicle-node-map.h"
+
+namespace ns3
+{
+  VehicleNodeMap::VehicleNodeMap (void)
+  {
+  }
+
+  bool
+  VehicleNodeMap::Insert (VehicleHandle veh, Ptr<Node> node)
+  {
+    if (Contains (veh))
+      {
+        return false;
+      }
+
+    if (veh >= m_nodes.size ())
+      {
+        m_nodes.resize (veh + 1);
+        m_mobility.resize (veh + 1);
+        m_velocityModels.resize (veh + 1);
+        m_setPositions.resize (veh + 1);
+        m_linkedPos.resize (veh + 1);
+      }
+    m_nodes[veh] = node;
+    m_mobility[veh] = node->GetObject<MobilityModel> ();
+    m_velocityModels[veh] = DynamicCast<ConstantVelocityMobilityModel> (m_mobility[veh]);
+    double nan = std::numeric_limits<double>::quiet_NaN ();
+    m_setPositions[veh] = Vector (nan, nan, nan);
+    m_linkedPos[veh] = m_linked.size ();
+    m_linked.push_back (veh);
+
+    uint32_t id = node->GetId ();
+    if (id >= m_vehicles.size ())
+      {
+        m_vehicles.resize (id + 1, VehicleIdTable::INVALID);
+      }
+    m_vehicles[id] = veh;
+
+    return true;
+  }
+
+  Ptr<Node>
+  VehicleNodeMap::Erase (VehicleHandle veh)
+  {
+    if (!Contains (veh))
+      {
+        return 0;
+      }
+
+    Ptr<Node> node = m_nodes[veh];
+    m_nodes[veh] = 0;
+    m_mobility[veh] = 0;
+    m_velocityModels[veh] = 0;
+    m_vehicles[node->GetId ()] = VehicleIdTable::INVALID;
+
+    // move the last linked vehicle into the gap
+    VehicleHandle last = m_linked.back ();
+    m_linked[m_linkedPos[veh]] = last;
+    m_linkedPos[last] = m_linkedPos[veh];
+    m_linked.pop_back ();
+
+    Trim ();
+    return node;
+  }
+
+  void
+  VehicleNodeMap::Trim (void)
+  {
+    std::size_t size = m_nodes.size ();
+    while (size > 0 && !m_nodes[size - 1])
+      {
+        --size;
+      }
+    if (size < m_nodes.size ())
+      {
+        m_nodes.resize (size);
+        m_mobility.resize (size);
+        m_velocityModels.resize (size);
+        m_setPositions.resize (size);
+        m_linkedPos.resize (size);
+      }
+
+    size = m_vehicles.size ();
+    while (size > 0 && m_vehicles[size - 1] == VehicleIdTable::INVALID)
+      {
+        --size;
+      }
+    m_vehicles.resize (size);
+  }
+
+  Ptr<Node>
+  VehicleNodeMap::GetNode (VehicleHandle veh) const
+  {
+    if (veh >= m_nodes.size ())
+      {
+        return 0;
+      }
+    return m_nodes[veh];
+  }
+
+  VehicleHandle
+  VehicleNodeMap::GetVehicle (Ptr<Node> node) const
+  {
+    return GetVehicle (node->GetId ());
+  }
+
+  VehicleHandle
+  VehicleNodeMap::GetVehicle (uint32_t nodeId) const
+  {
+    if (nodeId >= m_vehicles.size ())
+      {
+        return VehicleIdTable::INVALID;
+      }
+    return m_vehicles[nodeId];
+  }
+
+  Ptr<MobilityModel>
+  VehicleNodeMap::GetMobility (VehicleHandle veh) const
+  {
+    if (veh >= m_mobility.size ())
+      {
+        return 0;
+      }
+    return m_mobility[veh];
+  }
+
+  uint32_t
+  VehicleNodeMap::SetPositions (const std::vector<VehicleHandle>& vehicles, const std::vector<Vector>& positions, double minDistance)
+  {
+    NS_ASSERT (vehicles.size () == positions.size ());
+
+    double minDistanceSquared = minDistance * minDistance;
+    uint32_t moved = 0;
+    for (std::size_t i = 0; i < vehicles.size (); ++i)
+      {
+        MobilityModel* mob = PeekPointer (m_mobility[vehicles[i]]);
+        NS_ASSERT_MSG (mob, "Node of vehicle " << vehicles[i] << " has no MobilityModel");
+
+        // measured against the position set last, so small movements accumulate until they exceed minDistance;
+        // NaN (no position set yet) never compares as close
+        Vector& setPosition = m_setPositions[vehicles[i]];
+        if (minDistance > 0.0)
+          {
+            Vector diff = positions[i] - setPosition;
+            if (diff.x * diff.x + diff.y * diff.y + diff.z * diff.z < minDistanceSquared)
+              {
+                continue;
+              }
+          }
+        mob->SetPosition (positions[i]);
+        setPosition = positions[i];
+        ++moved;
+      }
+    return moved;
+  }
+
+  uint32_t
+  VehicleNodeMap::SetPositions (const std::vector<VehicleHandle>& vehicles, const std::vector<Vector>& positions,
+                                const std::vector<Vector>& velocities, double minDistance)
+  {
+    NS_ASSERT (vehicles.size () == positions.size () && vehicles.size () == velocities.size ());
+
+    double minDistanceSquared = minDistance * minDistance;
+    uint32_t moved = 0;
+    for (std::size_t i = 0; i < vehicles.size (); ++i)
+      {
+        ConstantVelocityMobilityModel* mob = PeekPointer (m_velocityModels[vehicles[i]]);
+        NS_ABORT_MSG_UNLESS (mob, "Node of vehicle " << vehicles[i] << " needs a ConstantVelocityMobilityModel for velocity updates");
+
+        // keep the extrapolated position while it is close enough to the reported one
+        Vector diff = positions[i] - mob->GetPosition ();
+        bool setPosition = minDistance <= 0.0 || diff.x * diff.x + diff.y * diff.y + diff.z * diff.z >= minDistanceSquared;
+
+        // a vehicle at constant speed and heading needs no update; SetPosition stops the node, though
+        Vector velocity = mob->GetVelocity ();
+        bool setVelocity = setPosition || velocity.x != velocities[i].x || velocity.y != velocities[i].y || velocity.z != velocities[i].z;
+
+        if (setPosition)
+          {
+            mob->SetPosition (positions[i]);
+          }
+        if (setVelocity)
+          {
+            mob->SetVelocity (velocities[i]);
+          }
+        if (setPosition || setVelocity)
+          {
+            ++moved;
+          }
+      }
+    return moved;
+  }
+
+  void
+  VehicleNodeMap::StopNode (VehicleHandle veh)
+  {
+    if (veh < m_velocityModels.size () && m_velocityModels[veh])
+      {
+        m_velocityModels[veh]->SetVelocity (Vector (0.0, 0.0, 0.0));
+      }
+  }
+
+  bool
+  VehicleNodeMap::Contains (VehicleHandle veh) const
+  {
+    return veh < m_nodes.size () && m_nodes[veh] != 0;
+  }
+
+  uint32_t
+  VehicleNodeMap::GetSize (void) const
+  {
+    return m_linked.size ();
+  }
+
+  void
+  VehicleNodeMap::Clear (void)
+  {
+    m_nodes.clear ();
+    m_mobility.clear ();
+    m_velocityModels.clear ();
+    m_setPositions.clear ();
+    m_vehicles.clear ();
+    m_linked.clear ();
+    m_linkedPos.clear ();
+  }
+
+  const std::vector<VehicleHandle>&
+  VehicleNodeMap::GetVehicles (void) const
+  {
+    return m_linked;
+  }
+
+} // namespace ns3
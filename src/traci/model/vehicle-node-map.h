@@ -0,0 +1,115 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef VEHICLE_NODE_MAP_H
+#define VEHICLE_NODE_MAP_H
+
+#include <vector>
+
+#include "ns3/ptr.h"
+#include "ns3/node.h"
+#include "ns3/vector.h"
+#include "ns3/mobility-model.h"
+#include "ns3/constant-velocity-mobility-model.h"
+
+#include "vehicle-id-table.h"
+
+namespace ns3 {
+
+/**
+ * Bidirectional index between sumo vehicles and ns3 nodes.
+ *
+ * Vehicles are addressed by their interned handle (see VehicleIdTable). Both
+ * directions are dense vectors, indexed by handle and by Node::GetId (), so
+ * lookups are O(1). The MobilityModel of a node is looked up once when it is
+ * linked, so positions of all vehicles can be applied without an aggregate
+ * lookup per vehicle and step.
+ *
+ * Erase trims free entries at the end of both directions, so the vectors
+ * follow the highest handle and node id in use (see VehicleIdTable, which
+ * assigns released handles again, lowest first).
+ */
+class VehicleNodeMap
+{
+public:
+  VehicleNodeMap (void);
+
+  // link a vehicle to a node; returns false if the vehicle is already linked
+  bool Insert (VehicleHandle veh, Ptr<Node> node);
+
+  // unlink a vehicle; returns its node or 0 if the vehicle is not linked
+  Ptr<Node> Erase (VehicleHandle veh);
+
+  // node of a vehicle or 0 if the vehicle is not linked
+  Ptr<Node> GetNode (VehicleHandle veh) const;
+
+  // vehicle of a node or VehicleIdTable::INVALID if the node is not linked
+  VehicleHandle GetVehicle (Ptr<Node> node) const;
+  VehicleHandle GetVehicle (uint32_t nodeId) const;
+
+  // mobility model of the node of a vehicle (cached at Insert) or 0
+  Ptr<MobilityModel> GetMobility (VehicleHandle veh) const;
+
+  // set the positions of many vehicles in one pass (positions[i] belongs to vehicles[i]); a node keeps the position
+  // set last until the vehicle is minDistance or more away from it, so small movements add up instead of being lost;
+  // the first position of a node is always set; returns the number of moved nodes
+  uint32_t SetPositions (const std::vector<VehicleHandle>& vehicles, const std::vector<Vector>& positions, double minDistance = 0.0);
+
+  // as above, but also set the velocity of every node, which must have a ConstantVelocityMobilityModel; the node
+  // moves on between two updates, and its position is only corrected if it deviates by minDistance or more from the
+  // extrapolated one; the velocity is only set if it changed or the position was corrected (which stops the node), and
+  // each set fires a course change; returns the number of nodes with a new position or velocity
+  uint32_t SetPositions (const std::vector<VehicleHandle>& vehicles, const std::vector<Vector>& positions,
+                         const std::vector<Vector>& velocities, double minDistance = 0.0);
+
+  // stop the node of a vehicle if it has a ConstantVelocityMobilityModel
+  void StopNode (VehicleHandle veh);
+
+  bool Contains (VehicleHandle veh) const;
+  uint32_t GetSize (void) const;
+  void Clear (void);
+
+  // all linked vehicles (unordered)
+  const std::vector<VehicleHandle>& GetVehicles (void) const;
+
+private:
+  // handle -> node; 0 for vehicles without node
+  std::vector<Ptr<Node> > m_nodes;
+
+  // handle -> mobility model of its node
+  std::vector<Ptr<MobilityModel> > m_mobility;
+
+  // handle -> mobility model of its node if that is a ConstantVelocityMobilityModel, 0 otherwise
+  std::vector<Ptr<ConstantVelocityMobilityModel> > m_velocityModels;
+
+  // handle -> position set last by SetPositions; NaN before the first one
+  std::vector<Vector> m_setPositions;
+
+  // node id -> handle; INVALID for nodes without vehicle
+  std::vector<VehicleHandle> m_vehicles;
+
+  // drop unused entries at the end of the vectors
+  void Trim (void);
+
+  // linked vehicles and their position in m_linked (by handle) for O(1) removal
+  std::vector<VehicleHandle> m_linked;
+  std::vector<uint32_t> m_linkedPos;
+};
+
+} // namespace ns3
+
+#endif /* VEHICLE_NODE_MAP_H */
@@ -0,0 +1,273 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "vehicle-registry.h"
+#include "traci-client.h"
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+namespace ns3
+{
+  NS_LOG_COMPONENT_DEFINE ("VehicleRegistry");
+
+  NS_OBJECT_ENSURE_REGISTERED (VehicleRegistry);
+
+  TypeId
+  VehicleRegistry::GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("ns3::VehicleRegistry")
+      .SetParent<Object> ()
+      .SetGroupName ("TraciClient")
+      .AddConstructor<VehicleRegistry> ()
+      .AddAttribute ("HandoverTimeout",
+                     "Time the node of an arrived vehicle waits for the departure of the vehicle in another shard before it is excluded.",
+                     TimeValue (Seconds (1.0)),
+                     MakeTimeAccessor (&VehicleRegistry::m_handoverTimeout),
+                     MakeTimeChecker (Seconds (0.0)))
+      .AddTraceSource ("Handover",
+                       "A vehicle and its node moved from one shard to another.",
+                       MakeTraceSourceAccessor (&VehicleRegistry::m_handoverTrace),
+                       "ns3::VehicleRegistry::HandoverTracedCallback")
+    ;
+    return tid;
+  }
+
+  VehicleRegistry::VehicleRegistry (void)
+  {
+    NS_LOG_FUNCTION (this);
+
+    m_handoverTimeout = Seconds (1.0);
+    m_linked = 0;
+    m_handovers = 0;
+  }
+
+  void
+  VehicleRegistry::DoDispose (void)
+  {
+    NS_LOG_FUNCTION (this);
+
+    for (uint32_t i = 0; i < m_stats.size (); ++i)
+      {
+        const ShardStats& stats = m_stats[i];
+        NS_LOG_INFO ("Shard " << i << ": " << stats.vehicles << " vehicles, " << stats.steps << " steps in "
+                     << stats.wallTime.GetSeconds () << " s (max " << stats.maxStepWallTime.GetSeconds () << " s), handovers in "
+                     << stats.handoversIn << ", out " << stats.handoversOut);
+      }
+
+    for (std::unordered_map<std::string, Entry>::iterator it = m_vehicles.begin (); it != m_vehicles.end (); ++it)
+      {
+        it->second.expire.Cancel ();
+      }
+    m_vehicles.clear ();
+    m_nodeVehicles.clear ();
+    m_shards.clear ();
+    Object::DoDispose ();
+  }
+
+  uint32_t
+  VehicleRegistry::AddShard (TraciClient* client)
+  {
+    NS_LOG_FUNCTION (this << client);
+
+    m_shards.push_back (client);
+    m_stats.push_back (ShardStats {0, 0, Time (0), Time (0), 0, 0});
+    return m_shards.size () - 1;
+  }
+
+  uint32_t
+  VehicleRegistry::GetNShards (void) const
+  {
+    return m_shards.size ();
+  }
+
+  TraciClient*
+  VehicleRegistry::GetShard (uint32_t shard) const
+  {
+    NS_ASSERT (shard < m_shards.size ());
+    return m_shards[shard];
+  }
+
+  Ptr<Node>
+  VehicleRegistry::Acquire (const std::string& veh, uint32_t shard)
+  {
+    NS_LOG_FUNCTION (this << veh << shard);
+
+    std::unordered_map<std::string, Entry>::iterator it = m_vehicles.find (veh);
+    if (it == m_vehicles.end ())
+      {
+        return 0;
+      }
+
+    Entry& entry = it->second;
+    if (entry.owner == int32_t (shard))
+      {
+        NS_LOG_WARN ("Vehicle " << veh << " departed again in shard " << shard);
+        return 0;
+      }
+
+    if (entry.owner < 0)
+      {
+        // arrived in its old shard before; stop waiting
+        entry.expire.Cancel ();
+      }
+    else
+      {
+        // still linked in its old shard, which ignores the arrival later on
+        Ptr<Node> node = m_shards[entry.owner]->UnlinkVehicle (veh);
+        NS_ASSERT (node == entry.node);
+        --m_stats[entry.owner].vehicles;
+        --m_linked;
+        entry.lastOwner = entry.owner;
+        entry.owner = -1;
+      }
+
+    Handover (veh, entry.lastOwner, shard);
+    return entry.node;
+  }
+
+  void
+  VehicleRegistry::Register (const std::string& veh, uint32_t shard, Ptr<Node> node)
+  {
+    NS_LOG_FUNCTION (this << veh << shard << node);
+
+    Entry& entry = m_vehicles[veh];
+    entry.owner = shard;
+    entry.lastOwner = shard;
+    entry.node = node;
+    m_nodeVehicles[node->GetId ()] = veh;
+    ++m_stats[shard].vehicles;
+    ++m_linked;
+  }
+
+  void
+  VehicleRegistry::Release (const std::string& veh, uint32_t shard, std::function<void (Ptr<Node>)> exclude)
+  {
+    NS_LOG_FUNCTION (this << veh << shard);
+
+    std::unordered_map<std::string, Entry>::iterator it = m_vehicles.find (veh);
+    if (it == m_vehicles.end () || it->second.owner != int32_t (shard))
+      {
+        return;
+      }
+
+    Entry& entry = it->second;
+    entry.owner = -1;
+    entry.lastOwner = shard;
+    --m_stats[shard].vehicles;
+    --m_linked;
+
+    // scheduled even without timeout, so shards stepping at the same time can still take the vehicle over
+    entry.expire = Simulator::Schedule (m_handoverTimeout, &VehicleRegistry::Expire, this, veh, exclude);
+  }
+
+  void
+  VehicleRegistry::Unregister (const std::string& veh, uint32_t shard)
+  {
+    NS_LOG_FUNCTION (this << veh << shard);
+
+    std::unordered_map<std::string, Entry>::iterator it = m_vehicles.find (veh);
+    if (it == m_vehicles.end () || it->second.owner != int32_t (shard))
+      {
+        return;
+      }
+
+    m_nodeVehicles.erase (it->second.node->GetId ());
+    m_vehicles.erase (it);
+    --m_stats[shard].vehicles;
+    --m_linked;
+  }
+
+  void
+  VehicleRegistry::Expire (std::string veh, std::function<void (Ptr<Node>)> exclude)
+  {
+    NS_LOG_FUNCTION (this << veh);
+
+    std::unordered_map<std::string, Entry>::iterator it = m_vehicles.find (veh);
+    NS_ASSERT (it != m_vehicles.end () && it->second.owner < 0);
+
+    Ptr<Node> node = it->second.node;
+    m_nodeVehicles.erase (node->GetId ());
+    m_vehicles.erase (it);
+    exclude (node);
+  }
+
+  void
+  VehicleRegistry::Handover (const std::string& veh, uint32_t from, uint32_t to)
+  {
+    NS_LOG_INFO ("Vehicle " << veh << " moves from shard " << from << " to shard " << to);
+
+    ++m_stats[from].handoversOut;
+    ++m_stats[to].handoversIn;
+    ++m_handovers;
+    m_handoverTrace (veh, from, to);
+  }
+
+  void
+  VehicleRegistry::ReportStep (uint32_t shard, Time wallTime)
+  {
+    ShardStats& stats = m_stats[shard];
+    ++stats.steps;
+    stats.wallTime += wallTime;
+    stats.maxStepWallTime = std::max (stats.maxStepWallTime, wallTime);
+  }
+
+  Ptr<Node>
+  VehicleRegistry::GetNode (const std::string& veh) const
+  {
+    std::unordered_map<std::string, Entry>::const_iterator it = m_vehicles.find (veh);
+    return it == m_vehicles.end () ? 0 : it->second.node;
+  }
+
+  int32_t
+  VehicleRegistry::GetOwner (const std::string& veh) const
+  {
+    std::unordered_map<std::string, Entry>::const_iterator it = m_vehicles.find (veh);
+    return it == m_vehicles.end () ? -1 : it->second.owner;
+  }
+
+  std::string
+  VehicleRegistry::GetVehicleId (Ptr<Node> node) const
+  {
+    std::unordered_map<uint32_t, std::string>::const_iterator it = m_nodeVehicles.find (node->GetId ());
+    if (it == m_nodeVehicles.end () || GetOwner (it->second) < 0)
+      {
+        return "";
+      }
+    return it->second;
+  }
+
+  uint32_t
+  VehicleRegistry::GetSize (void) const
+  {
+    return m_linked;
+  }
+
+  const VehicleRegistry::ShardStats&
+  VehicleRegistry::GetShardStats (uint32_t shard) const
+  {
+    NS_ASSERT (shard < m_stats.size ());
+    return m_stats[shard];
+  }
+
+  uint64_t
+  VehicleRegistry::GetHandovers (void) const
+  {
+    return m_handovers;
+  }
+
+} // namespace ns3
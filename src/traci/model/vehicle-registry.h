@@ -0,0 +1,152 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef VEHICLE_REGISTRY_H
+#define VEHICLE_REGISTRY_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+
+#include "ns3/object.h"
+#include "ns3/node.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/traced-callback.h"
+
+namespace ns3 {
+
+class TraciClient;
+
+/**
+ * Vehicles of several TraciClients (shards), each driving its own sumo
+ * instance, e.g. one geographic partition of a road network.
+ *
+ * Every client that has the registry set as its VehicleRegistry attribute
+ * registers as a shard in SumoSetup. The registry knows which shard owns
+ * which vehicle (by sumo id) and node. A vehicle that leaves a partition
+ * arrives in one sumo instance and departs in another one under the same id;
+ * the registry hands its node over instead of excluding and including it:
+ *
+ * - if the vehicle arrived first, its node waits up to HandoverTimeout for
+ *   the departure in another shard, then it is excluded;
+ * - if the vehicle departed first, the node is taken from the old shard,
+ *   which ignores the later arrival.
+ *
+ * Sumo instances run as separate processes, so with LookAhead the shards
+ * compute their steps in parallel.
+ */
+class VehicleRegistry : public Object
+{
+public:
+  static TypeId GetTypeId (void);
+
+  VehicleRegistry (void);
+
+  // statistics of one shard
+  struct ShardStats
+  {
+    uint32_t vehicles;       // vehicles currently owned
+    uint64_t steps;          // synchronisation steps
+    Time wallTime;           // wall clock time spent in synchronisation steps
+    Time maxStepWallTime;    // longest synchronisation step
+    uint64_t handoversIn;    // vehicles taken over from another shard
+    uint64_t handoversOut;   // vehicles handed over to another shard
+  };
+
+  // register a client as shard; returns its index (called by TraciClient::SumoSetup)
+  uint32_t AddShard (TraciClient* client);
+  uint32_t GetNShards (void) const;
+  TraciClient* GetShard (uint32_t shard) const;
+
+  // node for a vehicle that departed in a shard: the node of the vehicle in another shard (waiting after its arrival
+  // or still linked), or 0 if the vehicle is new
+  Ptr<Node> Acquire (const std::string& veh, uint32_t shard);
+
+  // vehicle is linked to node in shard
+  void Register (const std::string& veh, uint32_t shard, Ptr<Node> node);
+
+  // vehicle arrived in shard; exclude is called for its node unless another shard takes it over within HandoverTimeout
+  void Release (const std::string& veh, uint32_t shard, std::function<void (Ptr<Node>)> exclude);
+
+  // vehicle is removed from shard without handover, e.g. by a reset
+  void Unregister (const std::string& veh, uint32_t shard);
+
+  // wall clock time of a synchronisation step of a shard
+  void ReportStep (uint32_t shard, Time wallTime);
+
+  // node of a vehicle (also while waiting for a handover) or 0
+  Ptr<Node> GetNode (const std::string& veh) const;
+
+  // shard of a vehicle; -1 if unknown or waiting for a handover
+  int32_t GetOwner (const std::string& veh) const;
+
+  // sumo id of the vehicle linked to a node in any shard, "" if the node is not linked
+  std::string GetVehicleId (Ptr<Node> node) const;
+
+  // vehicles linked over all shards
+  uint32_t GetSize (void) const;
+
+  const ShardStats& GetShardStats (uint32_t shard) const;
+  uint64_t GetHandovers (void) const;
+
+  /**
+   * TracedCallback signature for vehicle handovers.
+   *
+   * \param [in] veh Sumo id of the vehicle.
+   * \param [in] from Shard the vehicle left.
+   * \param [in] to Shard the vehicle entered.
+   */
+  typedef void (* HandoverTracedCallback)(const std::string& veh, uint32_t from, uint32_t to);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  struct Entry
+  {
+    int32_t owner;            // -1 while waiting for a handover
+    uint32_t lastOwner;
+    Ptr<Node> node;
+    EventId expire;
+  };
+
+  // handover timeout of a released vehicle
+  void Expire (std::string veh, std::function<void (Ptr<Node>)> exclude);
+
+  void Handover (const std::string& veh, uint32_t from, uint32_t to);
+
+  std::unordered_map<std::string, Entry> m_vehicles;
+
+  // node id -> sumo id of linked vehicles
+  std::unordered_map<uint32_t, std::string> m_nodeVehicles;
+
+  // clients own the registry (via attribute), so shards are not reference counted
+  std::vector<TraciClient*> m_shards;
+  std::vector<ShardStats> m_stats;
+
+  Time m_handoverTimeout;
+  uint32_t m_linked;
+  uint64_t m_handovers;
+
+  TracedCallback<const std::string&, uint32_t, uint32_t> m_handoverTrace;
+};
+
+} // namespace ns3
+
+#endif /* VEHICLE_REGISTRY_H */
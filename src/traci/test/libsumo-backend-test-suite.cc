@@ -0,0 +1,122 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+
+#include "ns3/libsumo-backend.h"
+#include "ns3/test.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup traci-test
+ * \ingroup tests
+ *
+ * \brief Subscription results of a vehicle in the step of its departure
+ *
+ * TraciClient subscribes departed vehicles after the simulation step and
+ * reads their positions in the same step; the results must be there before
+ * the next step. Runs on a single straight edge written by the test.
+ */
+class LibsumoBackendDepartureTestCase : public TestCase
+{
+public:
+  LibsumoBackendDepartureTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+LibsumoBackendDepartureTestCase::LibsumoBackendDepartureTestCase ()
+  : TestCase ("Check that a vehicle subscribed after its departure has results in that step")
+{
+}
+
+void
+LibsumoBackendDepartureTestCase::DoRun (void)
+{
+  std::string net = CreateTempDirFilename ("libsumo-backend.net.xml");
+  std::ofstream (net.c_str ())
+    << "<net version=\"1.9\">\n"
+    << "  <location netOffset=\"0.00,0.00\" convBoundary=\"0.00,0.00,500.00,0.00\" origBoundary=\"0.00,0.00,500.00,0.00\" projParameter=\"!\"/>\n"
+    << "  <edge id=\"e0\" from=\"n0\" to=\"n1\" priority=\"-1\">\n"
+    << "    <lane id=\"e0_0\" index=\"0\" speed=\"13.89\" length=\"500.00\" shape=\"0.00,-1.60 500.00,-1.60\"/>\n"
+    << "  </edge>\n"
+    << "  <junction id=\"n0\" type=\"dead_end\" x=\"0.00\" y=\"0.00\" incLanes=\"\" intLanes=\"\" shape=\"0.00,0.00 0.00,-3.20\"/>\n"
+    << "  <junction id=\"n1\" type=\"dead_end\" x=\"500.00\" y=\"0.00\" incLanes=\"e0_0\" intLanes=\"\" shape=\"500.00,-3.20 500.00,0.00\"/>\n"
+    << "</net>\n";
+  std::string routes = CreateTempDirFilename ("libsumo-backend.rou.xml");
+  std::ofstream (routes.c_str ())
+    << "<routes>\n"
+    << "  <vehicle id=\"v0\" depart=\"0.00\" departSpeed=\"max\">\n"
+    << "    <route edges=\"e0\"/>\n"
+    << "  </vehicle>\n"
+    << "</routes>\n";
+
+  std::vector<std::string> args = {"-n", net, "-r", routes, "--step-length", "1", "--no-step-log", "--no-warnings"};
+  LibsumoBackend::Load (args);
+  LibsumoBackend::SimulationStep (1.0);
+  std::vector<std::string> departed = LibsumoBackend::GetDepartedIDList ();
+  NS_TEST_ASSERT_MSG_EQ ((std::find (departed.begin (), departed.end (), "v0") != departed.end ()), true, "departure of v0");
+  NS_TEST_ASSERT_MSG_EQ (LibsumoBackend::GetVehicleSubscriptionResults ().count ("v0"), 0, "results before the subscription");
+
+  // as TraciClient::SubscribeVehicle after GetSumoVehicles, before UpdatePositions
+  std::vector<int> vars = {VAR_POSITION, VAR_SPEED};
+  LibsumoBackend::SubscribeVehicle ("v0", vars, 0.0, std::numeric_limits<double>::max ());
+  const libsumo::SubscriptionResults& results = LibsumoBackend::GetVehicleSubscriptionResults ();
+  libsumo::SubscriptionResults::const_iterator res = results.find ("v0");
+  NS_TEST_ASSERT_MSG_EQ ((res != results.end ()), true, "results in the step of the subscription");
+  NS_TEST_ASSERT_MSG_EQ (res->second.count (VAR_POSITION), 1, "position in the step of the subscription");
+  libsumo::TraCIPosition first = *std::static_pointer_cast<libsumo::TraCIPosition> (res->second.at (VAR_POSITION));
+  libsumo::TraCIPosition position = LibsumoBackend::GetVehiclePosition ("v0");
+  NS_TEST_EXPECT_MSG_EQ_TOL (first.x, position.x, 1e-6, "subscribed position of v0");
+  NS_TEST_EXPECT_MSG_EQ_TOL (first.y, -1.6, 1e-6, "subscribed lateral position of v0");
+
+  // the next step replaces the results of the subscription
+  LibsumoBackend::SimulationStep (2.0);
+  res = LibsumoBackend::GetVehicleSubscriptionResults ().find ("v0");
+  NS_TEST_ASSERT_MSG_EQ ((res != LibsumoBackend::GetVehicleSubscriptionResults ().end ()), true, "results in the next step");
+  libsumo::TraCIPosition next = *std::static_pointer_cast<libsumo::TraCIPosition> (res->second.at (VAR_POSITION));
+  NS_TEST_EXPECT_MSG_GT (next.x, first.x, "position after the next step");
+
+  LibsumoBackend::Close ();
+}
+
+/**
+ * \ingroup traci-test
+ * \ingroup tests
+ *
+ * \brief Libsumo backend test suite; empty if ns3 was built without libsumo
+ */
+class LibsumoBackendTestSuite : public TestSuite
+{
+public:
+  LibsumoBackendTestSuite ();
+};
+
+LibsumoBackendTestSuite::LibsumoBackendTestSuite ()
+  : TestSuite ("traci-libsumo-backend", UNIT)
+{
+  if (LibsumoBackend::IsAvailable ())
+    {
+      AddTestCase (new LibsumoBackendDepartureTestCase, TestCase::QUICK);
+    }
+}
+
+static LibsumoBackendTestSuite g_libsumoBackendTestSuite; ///< the test suite
@@ -0,0 +1,206 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "ns3/sumo-storage.h"
+#include "ns3/test.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup traci-test
+ * \ingroup tests
+ *
+ * \brief Bulk reads and writes of the traci storage
+ */
+class SumoStorageBulkTestCase : public TestCase
+{
+public:
+  SumoStorageBulkTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SumoStorageBulkTestCase::SumoStorageBulkTestCase ()
+  : TestCase ("Check that bulk reads and writes match the single value ones")
+{
+}
+
+void
+SumoStorageBulkTestCase::DoRun (void)
+{
+  double values[] = {1.0, -2.5, 1e300};
+
+  // traci uses network byte order: 1.0 is 3f f0 00 00 00 00 00 00
+  tcpip::Storage bulk;
+  bulk.writeDoubles (values, 3);
+  NS_TEST_ASSERT_MSG_EQ (bulk.size (), 24, "size of three doubles");
+  NS_TEST_ASSERT_MSG_EQ (int (*bulk.begin ()), 0x3f, "first byte of 1.0");
+  NS_TEST_ASSERT_MSG_EQ (int (*(bulk.begin () + 1)), 0xf0, "second byte of 1.0");
+  NS_TEST_ASSERT_MSG_EQ (int (*(bulk.begin () + 7)), 0x00, "last byte of 1.0");
+
+  tcpip::Storage single;
+  for (int i = 0; i < 3; ++i)
+    {
+      single.writeDouble (values[i]);
+    }
+  NS_TEST_ASSERT_MSG_EQ (std::equal (bulk.begin (), bulk.end (), single.begin ()), true, "bulk write differs from single writes");
+
+  // read back in bulk and one by one
+  double read[3] = {0.0, 0.0, 0.0};
+  single.readDoubles (read, 3);
+  for (int i = 0; i < 3; ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (read[i], values[i], "bulk read of value " << i);
+      NS_TEST_ASSERT_MSG_EQ (bulk.readDouble (), values[i], "single read of value " << i);
+    }
+
+  int ints[] = {1, -1, 0x12345678};
+  tcpip::Storage intStorage;
+  intStorage.writeInts (ints, 3);
+  NS_TEST_ASSERT_MSG_EQ (int (*(intStorage.begin () + 8)), 0x12, "first byte of 0x12345678");
+  NS_TEST_ASSERT_MSG_EQ (intStorage.readInt (), 1, "int 0");
+  int readInts[2] = {0, 0};
+  intStorage.readInts (readInts, 2);
+  NS_TEST_ASSERT_MSG_EQ (readInts[0], -1, "int 1");
+  NS_TEST_ASSERT_MSG_EQ (readInts[1], 0x12345678, "int 2");
+
+  // writing nothing keeps the storage empty
+  tcpip::Storage empty;
+  empty.writeDoubles (values, 0);
+  NS_TEST_ASSERT_MSG_EQ (empty.size (), 0, "size after writing no values");
+}
+
+/**
+ * \ingroup traci-test
+ * \ingroup tests
+ *
+ * \brief Bounds check of bulk reads
+ */
+class SumoStorageBoundsTestCase : public TestCase
+{
+public:
+  SumoStorageBoundsTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SumoStorageBoundsTestCase::SumoStorageBoundsTestCase ()
+  : TestCase ("Check that bulk reads beyond the end throw and read nothing")
+{
+}
+
+void
+SumoStorageBoundsTestCase::DoRun (void)
+{
+  double values[] = {1.0, 2.0};
+  tcpip::Storage storage;
+  storage.writeDoubles (values, 2);
+
+  double read[3] = {0.0, 0.0, 0.0};
+  bool thrown = false;
+  try
+    {
+      storage.readDoubles (read, 3);
+    }
+  catch (std::invalid_argument&)
+    {
+      thrown = true;
+    }
+  NS_TEST_ASSERT_MSG_EQ (thrown, true, "reading three of two doubles");
+  NS_TEST_ASSERT_MSG_EQ (read[0], 0.0, "value copied by a failed read");
+  NS_TEST_ASSERT_MSG_EQ (storage.position (), 0, "position after a failed read");
+
+  storage.readDoubles (read, 2);
+  NS_TEST_ASSERT_MSG_EQ (read[1], 2.0, "values after a failed read");
+  NS_TEST_ASSERT_MSG_EQ (storage.valid_pos (), false, "all values read");
+}
+
+/**
+ * \ingroup traci-test
+ * \ingroup tests
+ *
+ * \brief Receiving into a reused storage
+ */
+class SumoStorageReceiveTestCase : public TestCase
+{
+public:
+  SumoStorageReceiveTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SumoStorageReceiveTestCase::SumoStorageReceiveTestCase ()
+  : TestCase ("Check that resetForReceive replaces the content and rewinds")
+{
+}
+
+void
+SumoStorageReceiveTestCase::DoRun (void)
+{
+  tcpip::Storage storage;
+  storage.writeInt (42);
+  storage.writeString ("left over");
+  storage.readInt ();
+
+  // as a socket would fill it: 0x00000007, then the double 1.0
+  unsigned char message[] = {0x00, 0x00, 0x00, 0x07, 0x3f, 0xf0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+  unsigned char* buffer = storage.resetForReceive (sizeof (message));
+  std::memcpy (buffer, message, sizeof (message));
+
+  NS_TEST_ASSERT_MSG_EQ (storage.size (), sizeof (message), "size after receive");
+  NS_TEST_ASSERT_MSG_EQ (storage.position (), 0, "position after receive");
+  NS_TEST_ASSERT_MSG_EQ (storage.readInt (), 7, "received int");
+  double value = 0.0;
+  storage.readDoubles (&value, 1);
+  NS_TEST_ASSERT_MSG_EQ (value, 1.0, "received double");
+  NS_TEST_ASSERT_MSG_EQ (storage.valid_pos (), false, "all received bytes read");
+
+  // a shorter message replaces the longer one completely
+  buffer = storage.resetForReceive (1);
+  buffer[0] = 0xab;
+  NS_TEST_ASSERT_MSG_EQ (storage.size (), 1, "size after a shorter receive");
+  NS_TEST_ASSERT_MSG_EQ (storage.readUnsignedByte (), 0xab, "byte of the shorter message");
+}
+
+/**
+ * \ingroup traci-test
+ * \ingroup tests
+ *
+ * \brief Traci storage test suite
+ */
+class SumoStorageTestSuite : public TestSuite
+{
+public:
+  SumoStorageTestSuite ();
+};
+
+SumoStorageTestSuite::SumoStorageTestSuite ()
+  : TestSuite ("traci-storage", UNIT)
+{
+  AddTestCase (new SumoStorageBulkTestCase, TestCase::QUICK);
+  AddTestCase (new SumoStorageBoundsTestCase, TestCase::QUICK);
+  AddTestCase (new SumoStorageReceiveTestCase, TestCase::QUICK);
+}
+
+static SumoStorageTestSuite g_sumoStorageTestSuite; ///< the test suite
@@ -0,0 +1,245 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cmath>
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/constant-velocity-mobility-model.h"
+#include "ns3/traci-client.h"
+#include "ns3/test.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("TraciExtrapolationTest");
+
+/**
+ * \ingroup traci-test
+ * \ingroup tests
+ *
+ * \brief Conversion of sumo speed and angle into a ns3 velocity vector
+ */
+class TraciSumoVelocityTestCase : public TestCase
+{
+public:
+  TraciSumoVelocityTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+TraciSumoVelocityTestCase::TraciSumoVelocityTestCase ()
+  : TestCase ("Check the velocity of sumo angles (clockwise from north)")
+{
+}
+
+void
+TraciSumoVelocityTestCase::DoRun (void)
+{
+  double tol = 1e-9;
+  Vector north = TraciClient::GetSumoVelocity (10.0, 0.0);
+  NS_TEST_ASSERT_MSG_EQ_TOL (north.x, 0.0, tol, "north: x");
+  NS_TEST_ASSERT_MSG_EQ_TOL (north.y, 10.0, tol, "north: y");
+  Vector east = TraciClient::GetSumoVelocity (10.0, 90.0);
+  NS_TEST_ASSERT_MSG_EQ_TOL (east.x, 10.0, tol, "east: x");
+  NS_TEST_ASSERT_MSG_EQ_TOL (east.y, 0.0, tol, "east: y");
+  Vector south = TraciClient::GetSumoVelocity (10.0, 180.0);
+  NS_TEST_ASSERT_MSG_EQ_TOL (south.x, 0.0, tol, "south: x");
+  NS_TEST_ASSERT_MSG_EQ_TOL (south.y, -10.0, tol, "south: y");
+  Vector west = TraciClient::GetSumoVelocity (10.0, 270.0);
+  NS_TEST_ASSERT_MSG_EQ_TOL (west.x, -10.0, tol, "west: x");
+  NS_TEST_ASSERT_MSG_EQ_TOL (west.y, 0.0, tol, "west: y");
+  NS_TEST_ASSERT_MSG_EQ_TOL (west.z, 0.0, tol, "west: z");
+}
+
+/**
+ * \ingroup traci-test
+ * \ingroup tests
+ *
+ * \brief Position error of a coarse synchronisation versus the 0.1 s synchronisation
+ *
+ * A vehicle drives north on a straight road, accelerates, and turns right on
+ * a circular arc, as sumo would report it. Two nodes are synchronised every
+ * second: one keeps its position until the next synchronisation step, the
+ * other one extrapolates with the reported speed and angle. Every 0.1 s, the
+ * positions of both nodes are compared with the trajectory, which is where a
+ * node synchronised every 0.1 s would be.
+ */
+class TraciExtrapolationTestCase : public TestCase
+{
+public:
+  TraciExtrapolationTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * State of the vehicle as reported by sumo.
+   * \param t time in s
+   * \param [out] position position in m
+   * \param [out] speed speed in m/s
+   * \param [out] angle angle in degrees, clockwise from north
+   */
+  static void GetVehicleState (double t, Vector& position, double& speed, double& angle);
+
+  /// Synchronise both nodes with the vehicle state.
+  void Synchronise (void);
+
+  /// Compare both nodes with the vehicle state.
+  void Measure (void);
+
+  VehicleIdTable m_vehicleIds;        ///< vehicle ids
+  VehicleNodeMap m_holdMap;           ///< vehicle -> node keeping its position
+  VehicleNodeMap m_extrapolateMap;    ///< vehicle -> extrapolating node
+  VehicleHandle m_veh;                ///< the vehicle
+  Ptr<MobilityModel> m_hold;          ///< mobility of the node keeping its position
+  Ptr<MobilityModel> m_extrapolate;   ///< mobility of the extrapolating node
+  double m_holdSum;                   ///< sum of position errors without extrapolation
+  double m_holdMax;                   ///< maximum position error without extrapolation
+  double m_extrapolateSum;            ///< sum of position errors with extrapolation
+  double m_extrapolateMax;            ///< maximum position error with extrapolation
+  uint32_t m_samples;                 ///< number of compared positions
+};
+
+TraciExtrapolationTestCase::TraciExtrapolationTestCase ()
+  : TestCase ("Check the position error of extrapolated nodes with 1 s synchronisation"),
+    m_veh (VehicleIdTable::INVALID),
+    m_holdSum (0.0),
+    m_holdMax (0.0),
+    m_extrapolateSum (0.0),
+    m_extrapolateMax (0.0),
+    m_samples (0)
+{
+}
+
+void
+TraciExtrapolationTestCase::GetVehicleState (double t, Vector& position, double& speed, double& angle)
+{
+  // 0-10 s: 10 m/s north; 10-20 s: accelerate with 0.5 m/s^2; 20-30 s: right turn with radius 50 m at 15 m/s
+  const double radius = 50.0;
+  if (t <= 10.0)
+    {
+      speed = 10.0;
+      angle = 0.0;
+      position = Vector (0.0, 10.0 * t, 0.0);
+    }
+  else if (t <= 20.0)
+    {
+      double dt = t - 10.0;
+      speed = 10.0 + 0.5 * dt;
+      angle = 0.0;
+      position = Vector (0.0, 100.0 + 10.0 * dt + 0.25 * dt * dt, 0.0);
+    }
+  else
+    {
+      speed = 15.0;
+      double phi = speed * (t - 20.0) / radius;
+      angle = phi * 180.0 / M_PI;
+      position = Vector (radius - radius * std::cos (phi), 225.0 + radius * std::sin (phi), 0.0);
+    }
+}
+
+void
+TraciExtrapolationTestCase::Synchronise (void)
+{
+  Vector position;
+  double speed;
+  double angle;
+  GetVehicleState (Simulator::Now ().GetSeconds (), position, speed, angle);
+
+  std::vector<VehicleHandle> vehicles (1, m_veh);
+  m_holdMap.SetPositions (vehicles, std::vector<Vector> (1, position));
+  m_extrapolateMap.SetPositions (vehicles, std::vector<Vector> (1, position),
+                                 std::vector<Vector> (1, TraciClient::GetSumoVelocity (speed, angle)));
+}
+
+void
+TraciExtrapolationTestCase::Measure (void)
+{
+  Vector position;
+  double speed;
+  double angle;
+  GetVehicleState (Simulator::Now ().GetSeconds (), position, speed, angle);
+
+  double hold = CalculateDistance (position, m_hold->GetPosition ());
+  double extrapolate = CalculateDistance (position, m_extrapolate->GetPosition ());
+  m_holdSum += hold;
+  m_holdMax = std::max (m_holdMax, hold);
+  m_extrapolateSum += extrapolate;
+  m_extrapolateMax = std::max (m_extrapolateMax, extrapolate);
+  ++m_samples;
+}
+
+void
+TraciExtrapolationTestCase::DoRun (void)
+{
+  Ptr<Node> holdNode = CreateObject<Node> ();
+  m_hold = CreateObject<ConstantPositionMobilityModel> ();
+  holdNode->AggregateObject (m_hold);
+  Ptr<Node> extrapolateNode = CreateObject<Node> ();
+  m_extrapolate = CreateObject<ConstantVelocityMobilityModel> ();
+  extrapolateNode->AggregateObject (m_extrapolate);
+
+  m_veh = m_vehicleIds.Intern ("veh0");
+  m_holdMap.Insert (m_veh, holdNode);
+  m_extrapolateMap.Insert (m_veh, extrapolateNode);
+
+  // synchronise at full seconds first, then measure at every 0.1 s (except at the synchronisation steps)
+  for (uint32_t s = 0; s < 30; ++s)
+    {
+      Simulator::Schedule (Seconds (s), &TraciExtrapolationTestCase::Synchronise, this);
+      for (uint32_t i = 1; i < 10; ++i)
+        {
+          Simulator::Schedule (Seconds (s) + MilliSeconds (100 * i), &TraciExtrapolationTestCase::Measure, this);
+        }
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  double holdMean = m_holdSum / m_samples;
+  double extrapolateMean = m_extrapolateSum / m_samples;
+  NS_LOG_INFO ("Position error versus 0.1 s synchronisation over " << m_samples << " samples: "
+               << "hold mean " << holdMean << " m, max " << m_holdMax << " m; "
+               << "extrapolate mean " << extrapolateMean << " m, max " << m_extrapolateMax << " m");
+
+  // exact on the straight road; a / 2 * t^2 while accelerating; v^2 / (2 r) * t^2 in the turn
+  NS_TEST_ASSERT_MSG_LT (m_extrapolateMax, 2.5, "Extrapolation deviates too far from the trajectory");
+  NS_TEST_ASSERT_MSG_LT (extrapolateMean, 0.1 * holdMean, "Extrapolation is not better than keeping the position");
+}
+
+/**
+ * \ingroup traci-test
+ * \ingroup tests
+ *
+ * \brief Traci extrapolation test suite
+ */
+class TraciExtrapolationTestSuite : public TestSuite
+{
+public:
+  TraciExtrapolationTestSuite ();
+};
+
+TraciExtrapolationTestSuite::TraciExtrapolationTestSuite ()
+  : TestSuite ("traci-extrapolation", UNIT)
+{
+  AddTestCase (new TraciSumoVelocityTestCase, TestCase::QUICK);
+  AddTestCase (new TraciExtrapolationTestCase, TestCase::QUICK);
+}
+
+static TraciExtrapolationTestSuite g_traciExtrapolationTestSuite; ///< the test suite
@@ -0,0 +1,142 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/vehicle-id-table.h"
+#include "ns3/test.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup traci-test
+ * \ingroup tests
+ *
+ * \brief Interning, lookup and clearing of sumo vehicle ids
+ */
+class VehicleIdTableInternTestCase : public TestCase
+{
+public:
+  VehicleIdTableInternTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+VehicleIdTableInternTestCase::VehicleIdTableInternTestCase ()
+  : TestCase ("Check that vehicle ids get dense handles and are found again")
+{
+}
+
+void
+VehicleIdTableInternTestCase::DoRun (void)
+{
+  VehicleIdTable table;
+  NS_TEST_ASSERT_MSG_EQ (table.GetSize (), 0, "new table is not empty");
+  NS_TEST_ASSERT_MSG_EQ (table.Lookup ("veh0"), VehicleIdTable::INVALID, "unknown id has a handle");
+
+  VehicleHandle a = table.Intern ("veh0");
+  VehicleHandle b = table.Intern ("veh1");
+  NS_TEST_ASSERT_MSG_EQ (a, 0, "first handle");
+  NS_TEST_ASSERT_MSG_EQ (b, 1, "second handle");
+  NS_TEST_ASSERT_MSG_EQ (table.Intern ("veh0"), a, "interning an id twice gives another handle");
+  NS_TEST_ASSERT_MSG_EQ (table.GetSize (), 2, "size after interning two ids");
+  NS_TEST_ASSERT_MSG_EQ (table.Lookup ("veh1"), b, "lookup of an interned id");
+  NS_TEST_ASSERT_MSG_EQ (table.GetName (a), "veh0", "name of the first handle");
+  NS_TEST_ASSERT_MSG_EQ (table.GetName (b), "veh1", "name of the second handle");
+
+  table.Clear ();
+  NS_TEST_ASSERT_MSG_EQ (table.GetSize (), 0, "size after clear");
+  NS_TEST_ASSERT_MSG_EQ (table.GetCapacity (), 0, "handle range after clear");
+  NS_TEST_ASSERT_MSG_EQ (table.Lookup ("veh0"), VehicleIdTable::INVALID, "cleared id has a handle");
+  NS_TEST_ASSERT_MSG_EQ (table.Intern ("veh1"), 0, "handles start at 0 again after clear");
+}
+
+/**
+ * \ingroup traci-test
+ * \ingroup tests
+ *
+ * \brief Release and reuse of vehicle handles
+ */
+class VehicleIdTableReleaseTestCase : public TestCase
+{
+public:
+  VehicleIdTableReleaseTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+VehicleIdTableReleaseTestCase::VehicleIdTableReleaseTestCase ()
+  : TestCase ("Check that released handles are assigned again, lowest first")
+{
+}
+
+void
+VehicleIdTableReleaseTestCase::DoRun (void)
+{
+  VehicleIdTable table;
+  for (int i = 0; i < 5; ++i)
+    {
+      table.Intern ("veh" + std::to_string (i));
+    }
+
+  table.Release (3);
+  table.Release (1);
+  NS_TEST_ASSERT_MSG_EQ (table.GetSize (), 3, "size after releasing two handles");
+  NS_TEST_ASSERT_MSG_EQ (table.GetCapacity (), 5, "handle range with free handles in between");
+  NS_TEST_ASSERT_MSG_EQ (table.Lookup ("veh1"), VehicleIdTable::INVALID, "released id has a handle");
+
+  // releasing a free or unknown handle does nothing
+  table.Release (1);
+  table.Release (17);
+  table.Release (VehicleIdTable::INVALID);
+  NS_TEST_ASSERT_MSG_EQ (table.GetSize (), 3, "size after releasing free handles");
+
+  NS_TEST_ASSERT_MSG_EQ (table.Intern ("new0"), 1, "lowest free handle");
+  NS_TEST_ASSERT_MSG_EQ (table.Intern ("new1"), 3, "next free handle");
+  NS_TEST_ASSERT_MSG_EQ (table.Intern ("new2"), 5, "new handle without free ones");
+  NS_TEST_ASSERT_MSG_EQ (table.GetName (1), "new0", "name of a reused handle");
+  NS_TEST_ASSERT_MSG_EQ (table.Lookup ("veh4"), 4, "other ids keep their handles");
+
+  // the handle range shrinks once its top is free
+  table.Release (4);
+  NS_TEST_ASSERT_MSG_EQ (table.GetCapacity (), 6, "handle range with a free handle below the top");
+  table.Release (5);
+  NS_TEST_ASSERT_MSG_EQ (table.GetCapacity (), 4, "handle range after releasing the top handles");
+  NS_TEST_ASSERT_MSG_EQ (table.Intern ("new3"), 4, "handle after the range shrank");
+  NS_TEST_ASSERT_MSG_EQ (table.GetSize (), 5, "size after reuse");
+}
+
+/**
+ * \ingroup traci-test
+ * \ingroup tests
+ *
+ * \brief Vehicle id table test suite
+ */
+class VehicleIdTableTestSuite : public TestSuite
+{
+public:
+  VehicleIdTableTestSuite ();
+};
+
+VehicleIdTableTestSuite::VehicleIdTableTestSuite ()
+  : TestSuite ("traci-vehicle-id-table", UNIT)
+{
+  AddTestCase (new VehicleIdTableInternTestCase, TestCase::QUICK);
+  AddTestCase (new VehicleIdTableReleaseTestCase, TestCase::QUICK);
+}
+
+static VehicleIdTableTestSuite g_vehicleIdTableTestSuite; ///< the test suite
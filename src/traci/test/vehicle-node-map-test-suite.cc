@@ -0,0 +1,250 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/callback.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/constant-velocity-mobility-model.h"
+#include "ns3/vehicle-node-map.h"
+#include "ns3/test.h"
+
+using namespace ns3;
+
+namespace {
+
+Ptr<Node>
+CreateNode (Ptr<MobilityModel> mobility)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  node->AggregateObject (mobility);
+  return node;
+}
+
+} // anonymous namespace
+
+/**
+ * \ingroup traci-test
+ * \ingroup tests
+ *
+ * \brief Links between vehicles and nodes in both directions
+ */
+class VehicleNodeMapIndexTestCase : public TestCase
+{
+public:
+  VehicleNodeMapIndexTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+VehicleNodeMapIndexTestCase::VehicleNodeMapIndexTestCase ()
+  : TestCase ("Check the node and reverse vehicle index of the vehicle node map")
+{
+}
+
+void
+VehicleNodeMapIndexTestCase::DoRun (void)
+{
+  VehicleNodeMap map;
+  Ptr<Node> a = CreateNode (CreateObject<ConstantPositionMobilityModel> ());
+  Ptr<Node> b = CreateNode (CreateObject<ConstantPositionMobilityModel> ());
+  Ptr<Node> c = CreateNode (CreateObject<ConstantPositionMobilityModel> ());
+
+  NS_TEST_ASSERT_MSG_EQ (map.Insert (7, a), true, "insert a");
+  NS_TEST_ASSERT_MSG_EQ (map.Insert (2, b), true, "insert b");
+  NS_TEST_ASSERT_MSG_EQ (map.Insert (7, c), false, "a linked vehicle is linked again");
+  NS_TEST_ASSERT_MSG_EQ (map.GetSize (), 2, "size after two inserts");
+
+  NS_TEST_ASSERT_MSG_EQ (map.GetNode (7), a, "node of vehicle 7");
+  NS_TEST_ASSERT_MSG_EQ (map.GetNode (2), b, "node of vehicle 2");
+  NS_TEST_ASSERT_MSG_EQ (map.GetNode (3), Ptr<Node> (), "node of a vehicle that is not linked");
+  NS_TEST_ASSERT_MSG_EQ (map.GetNode (VehicleIdTable::INVALID), Ptr<Node> (), "node of the invalid handle");
+  NS_TEST_ASSERT_MSG_EQ (map.GetVehicle (a), 7, "vehicle of node a");
+  NS_TEST_ASSERT_MSG_EQ (map.GetVehicle (b->GetId ()), 2, "vehicle of node b by id");
+  NS_TEST_ASSERT_MSG_EQ (map.GetVehicle (c), VehicleIdTable::INVALID, "vehicle of a node that is not linked");
+  NS_TEST_ASSERT_MSG_EQ (map.GetMobility (7), a->GetObject<MobilityModel> (), "cached mobility model");
+
+  // erasing the vehicle with the highest handle and node id leaves the other one intact
+  NS_TEST_ASSERT_MSG_EQ (map.Erase (7), a, "erase returns the node");
+  NS_TEST_ASSERT_MSG_EQ (map.Erase (7), Ptr<Node> (), "erasing twice");
+  NS_TEST_ASSERT_MSG_EQ (map.Contains (7), false, "erased vehicle is linked");
+  NS_TEST_ASSERT_MSG_EQ (map.GetVehicle (a), VehicleIdTable::INVALID, "erased node is linked");
+  NS_TEST_ASSERT_MSG_EQ (map.GetNode (2), b, "other node after erase");
+  NS_TEST_ASSERT_MSG_EQ (map.GetVehicle (b), 2, "other vehicle after erase");
+  NS_TEST_ASSERT_MSG_EQ (map.GetVehicles ().size (), 1, "linked vehicles after erase");
+  NS_TEST_ASSERT_MSG_EQ (map.GetVehicles ()[0], 2, "remaining linked vehicle");
+
+  // the handle can be linked to another node again
+  NS_TEST_ASSERT_MSG_EQ (map.Insert (7, c), true, "insert c");
+  NS_TEST_ASSERT_MSG_EQ (map.GetVehicle (c), 7, "vehicle of node c");
+  NS_TEST_ASSERT_MSG_EQ (map.GetVehicles ().size (), 2, "linked vehicles after reinsert");
+
+  map.Clear ();
+  NS_TEST_ASSERT_MSG_EQ (map.GetSize (), 0, "size after clear");
+  NS_TEST_ASSERT_MSG_EQ (map.GetVehicle (b), VehicleIdTable::INVALID, "node linked after clear");
+}
+
+/**
+ * \ingroup traci-test
+ * \ingroup tests
+ *
+ * \brief MinPositionChange of SetPositions
+ */
+class VehicleNodeMapMinDistanceTestCase : public TestCase
+{
+public:
+  VehicleNodeMapMinDistanceTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+VehicleNodeMapMinDistanceTestCase::VehicleNodeMapMinDistanceTestCase ()
+  : TestCase ("Check that small movements add up until they exceed the minimum distance")
+{
+}
+
+void
+VehicleNodeMapMinDistanceTestCase::DoRun (void)
+{
+  VehicleNodeMap map;
+  Ptr<MobilityModel> mob = CreateObject<ConstantPositionMobilityModel> ();
+  mob->SetPosition (Vector (0.3, 0.0, 0.0));
+  map.Insert (0, CreateNode (mob));
+  std::vector<VehicleHandle> vehicles (1, 0);
+
+  // the first position is set even if the node is close to it already
+  NS_TEST_ASSERT_MSG_EQ (map.SetPositions (vehicles, std::vector<Vector> (1, Vector (0.0, 0.0, 0.0)), 1.0), 1, "first position");
+  NS_TEST_ASSERT_MSG_EQ (mob->GetPosition ().x, 0.0, "first position: x");
+
+  // 0.4 m steps: each is below 1 m, but the distance to the position set last exceeds 1 m after three of them
+  double x[] = {0.4, 0.8, 1.2, 1.6, 2.0, 2.4};
+  uint32_t expected[] = {0, 0, 1, 0, 0, 1};
+  double position[] = {0.0, 0.0, 1.2, 1.2, 1.2, 2.4};
+  for (uint32_t i = 0; i < 6; ++i)
+    {
+      uint32_t moved = map.SetPositions (vehicles, std::vector<Vector> (1, Vector (x[i], 0.0, 0.0)), 1.0);
+      NS_TEST_ASSERT_MSG_EQ (moved, expected[i], "moved nodes at x = " << x[i]);
+      NS_TEST_ASSERT_MSG_EQ_TOL (mob->GetPosition ().x, position[i], 1e-9, "node position at x = " << x[i]);
+    }
+
+  // the threshold is measured against the position set last, not the one of the mobility model
+  mob->SetPosition (Vector (0.0, 0.0, 0.0));
+  NS_TEST_ASSERT_MSG_EQ (map.SetPositions (vehicles, std::vector<Vector> (1, Vector (2.6, 0.0, 0.0)), 1.0), 0, "close to the position set last");
+
+  // without minimum distance every position is set
+  NS_TEST_ASSERT_MSG_EQ (map.SetPositions (vehicles, std::vector<Vector> (1, Vector (2.6, 0.0, 0.0))), 1, "without minimum distance");
+  NS_TEST_ASSERT_MSG_EQ_TOL (mob->GetPosition ().x, 2.6, 1e-9, "position without minimum distance");
+}
+
+/**
+ * \ingroup traci-test
+ * \ingroup tests
+ *
+ * \brief Velocity updates and StopNode of extrapolating nodes
+ */
+class VehicleNodeMapVelocityTestCase : public TestCase
+{
+public:
+  VehicleNodeMapVelocityTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /// Count a course change.
+  void CourseChange (Ptr<const MobilityModel> mobility);
+
+  uint32_t m_courseChanges; ///< course changes so far
+};
+
+VehicleNodeMapVelocityTestCase::VehicleNodeMapVelocityTestCase ()
+  : TestCase ("Check velocity updates and stopping of extrapolating nodes"),
+    m_courseChanges (0)
+{
+}
+
+void
+VehicleNodeMapVelocityTestCase::CourseChange (Ptr<const MobilityModel> mobility)
+{
+  ++m_courseChanges;
+}
+
+void
+VehicleNodeMapVelocityTestCase::DoRun (void)
+{
+  VehicleNodeMap map;
+  Ptr<ConstantVelocityMobilityModel> mob = CreateObject<ConstantVelocityMobilityModel> ();
+  mob->TraceConnectWithoutContext ("CourseChange", MakeCallback (&VehicleNodeMapVelocityTestCase::CourseChange, this));
+  map.Insert (0, CreateNode (mob));
+  std::vector<VehicleHandle> vehicles (1, 0);
+  std::vector<Vector> velocities (1, Vector (10.0, 0.0, 0.0));
+
+  // the node is where the vehicle starts, so only the velocity is set
+  NS_TEST_ASSERT_MSG_EQ (map.SetPositions (vehicles, std::vector<Vector> (1, Vector (0.0, 0.0, 0.0)), velocities, 1.0), 1, "first update");
+  NS_TEST_ASSERT_MSG_EQ (m_courseChanges, 1, "course changes of the first update");
+  NS_TEST_ASSERT_MSG_EQ (mob->GetVelocity ().x, 10.0, "velocity of the first update");
+
+  // the extrapolated position matches the reported one and the velocity is the same: nothing to do
+  m_courseChanges = 0;
+  Simulator::Stop (Seconds (1.0));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (map.SetPositions (vehicles, std::vector<Vector> (1, Vector (10.2, 0.0, 0.0)), velocities, 1.0), 0, "unchanged vehicle");
+  NS_TEST_ASSERT_MSG_EQ (m_courseChanges, 0, "course changes of an unchanged vehicle");
+
+  // a new velocity alone keeps the extrapolated position
+  velocities[0] = Vector (0.0, 5.0, 0.0);
+  NS_TEST_ASSERT_MSG_EQ (map.SetPositions (vehicles, std::vector<Vector> (1, Vector (10.2, 0.0, 0.0)), velocities, 1.0), 1, "new velocity");
+  NS_TEST_ASSERT_MSG_EQ (m_courseChanges, 1, "course changes of a new velocity");
+  NS_TEST_ASSERT_MSG_EQ_TOL (mob->GetPosition ().x, 10.0, 1e-9, "extrapolated position kept");
+  NS_TEST_ASSERT_MSG_EQ (mob->GetVelocity ().y, 5.0, "new velocity");
+
+  // a corrected position stops the model, so the velocity is set again
+  m_courseChanges = 0;
+  NS_TEST_ASSERT_MSG_EQ (map.SetPositions (vehicles, std::vector<Vector> (1, Vector (12.0, 0.0, 0.0)), velocities, 1.0), 1, "corrected position");
+  NS_TEST_ASSERT_MSG_EQ (m_courseChanges, 2, "course changes of a corrected position");
+  NS_TEST_ASSERT_MSG_EQ (mob->GetPosition ().x, 12.0, "corrected position");
+  NS_TEST_ASSERT_MSG_EQ (mob->GetVelocity ().y, 5.0, "velocity after the correction");
+
+  map.StopNode (0);
+  NS_TEST_ASSERT_MSG_EQ (mob->GetVelocity ().y, 0.0, "velocity of a stopped node");
+  map.StopNode (1);
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup traci-test
+ * \ingroup tests
+ *
+ * \brief Vehicle node map test suite
+ */
+class VehicleNodeMapTestSuite : public TestSuite
+{
+public:
+  VehicleNodeMapTestSuite ();
+};
+
+VehicleNodeMapTestSuite::VehicleNodeMapTestSuite ()
+  : TestSuite ("traci-vehicle-node-map", UNIT)
+{
+  AddTestCase (new VehicleNodeMapIndexTestCase, TestCase::QUICK);
+  AddTestCase (new VehicleNodeMapMinDistanceTestCase, TestCase::QUICK);
+  AddTestCase (new VehicleNodeMapVelocityTestCase, TestCase::QUICK);
+}
+
+static VehicleNodeMapTestSuite g_vehicleNodeMapTestSuite; ///< the test suite
@@ -0,0 +1,229 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <functional>
+
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/nstime.h"
+#include "ns3/vehicle-registry.h"
+#include "ns3/test.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup traci-test
+ * \ingroup tests
+ *
+ * \brief Handover of vehicles between shards
+ *
+ * The shards have no TraciClient: without a vehicle that is still linked in
+ * its old shard when it departs in the new one, the registry does not call
+ * its clients.
+ */
+class VehicleRegistryHandoverTestCase : public TestCase
+{
+public:
+  VehicleRegistryHandoverTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /// Exclude function of the shards.
+  void Exclude (Ptr<Node> node);
+
+  /// Vehicle "a" arrives in shard 0.
+  void ArriveA (void);
+
+  /// Vehicle "a" departs in shard 1.
+  void DepartA (void);
+
+  /// Vehicle "b" arrives in shard 1 and never departs again.
+  void ArriveB (void);
+
+  /// Check the state after the timeouts.
+  void Check (void);
+
+  Ptr<VehicleRegistry> m_registry;   ///< the registry
+  Ptr<Node> m_nodeA;                 ///< node of vehicle "a"
+  Ptr<Node> m_nodeB;                 ///< node of vehicle "b"
+  std::function<void (Ptr<Node>)> m_exclude; ///< Exclude as exclude function
+  std::vector<Ptr<Node> > m_excluded; ///< excluded nodes
+  std::vector<Time> m_excludeTimes;   ///< times of the exclusions
+};
+
+VehicleRegistryHandoverTestCase::VehicleRegistryHandoverTestCase ()
+  : TestCase ("Check handovers within and exclusion after the handover timeout")
+{
+}
+
+void
+VehicleRegistryHandoverTestCase::Exclude (Ptr<Node> node)
+{
+  m_excluded.push_back (node);
+  m_excludeTimes.push_back (Simulator::Now ());
+}
+
+void
+VehicleRegistryHandoverTestCase::ArriveA (void)
+{
+  m_registry->Release ("a", 0, m_exclude);
+  NS_TEST_EXPECT_MSG_EQ (m_registry->GetOwner ("a"), -1, "owner of a vehicle waiting for its handover");
+  NS_TEST_EXPECT_MSG_EQ (m_registry->GetNode ("a"), m_nodeA, "node of a vehicle waiting for its handover");
+  NS_TEST_EXPECT_MSG_EQ (m_registry->GetVehicleId (m_nodeA), "", "vehicle of a waiting node");
+  NS_TEST_EXPECT_MSG_EQ (m_registry->GetSize (), 1, "linked vehicles while one waits");
+}
+
+void
+VehicleRegistryHandoverTestCase::DepartA (void)
+{
+  // the node of the arrived vehicle is taken over
+  Ptr<Node> node = m_registry->Acquire ("a", 1);
+  NS_TEST_EXPECT_MSG_EQ (node, m_nodeA, "node taken over");
+  m_registry->Register ("a", 1, node);
+  NS_TEST_EXPECT_MSG_EQ (m_registry->GetOwner ("a"), 1, "owner after the handover");
+  NS_TEST_EXPECT_MSG_EQ (m_registry->GetVehicleId (m_nodeA), "a", "vehicle of the node after the handover");
+  NS_TEST_EXPECT_MSG_EQ (m_registry->GetHandovers (), 1, "handovers");
+  NS_TEST_EXPECT_MSG_EQ (m_registry->GetShardStats (0).handoversOut, 1, "handovers out of shard 0");
+  NS_TEST_EXPECT_MSG_EQ (m_registry->GetShardStats (1).handoversIn, 1, "handovers into shard 1");
+  NS_TEST_EXPECT_MSG_EQ (m_registry->GetShardStats (1).vehicles, 2, "vehicles of shard 1");
+}
+
+void
+VehicleRegistryHandoverTestCase::ArriveB (void)
+{
+  m_registry->Release ("b", 1, m_exclude);
+
+  // a release by another shard than the owner is ignored
+  m_registry->Release ("a", 0, m_exclude);
+  NS_TEST_EXPECT_MSG_EQ (m_registry->GetOwner ("a"), 1, "owner after a release by another shard");
+}
+
+void
+VehicleRegistryHandoverTestCase::Check (void)
+{
+  // only the vehicle that never departed again is excluded, once the timeout expired
+  NS_TEST_EXPECT_MSG_EQ (m_excluded.size (), 1, "excluded nodes");
+  if (m_excluded.size () == 1)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_excluded[0], m_nodeB, "excluded node");
+      NS_TEST_EXPECT_MSG_EQ (m_excludeTimes[0], Seconds (3.0), "exclusion time");
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_registry->GetNode ("b"), Ptr<Node> (), "node of an expired vehicle");
+  NS_TEST_EXPECT_MSG_EQ (m_registry->GetVehicleId (m_nodeB), "", "vehicle of an excluded node");
+  NS_TEST_EXPECT_MSG_EQ (m_registry->GetNode ("a"), m_nodeA, "node of the vehicle handed over");
+  NS_TEST_EXPECT_MSG_EQ (m_registry->GetSize (), 1, "linked vehicles");
+}
+
+void
+VehicleRegistryHandoverTestCase::DoRun (void)
+{
+  m_exclude = std::bind (&VehicleRegistryHandoverTestCase::Exclude, this, std::placeholders::_1);
+  m_registry = CreateObject<VehicleRegistry> ();
+  m_registry->SetAttribute ("HandoverTimeout", TimeValue (Seconds (1.0)));
+  NS_TEST_ASSERT_MSG_EQ (m_registry->AddShard (0), 0, "index of shard 0");
+  NS_TEST_ASSERT_MSG_EQ (m_registry->AddShard (0), 1, "index of shard 1");
+
+  m_nodeA = CreateObject<Node> ();
+  m_nodeB = CreateObject<Node> ();
+  NS_TEST_ASSERT_MSG_EQ (m_registry->Acquire ("a", 0), Ptr<Node> (), "node of a new vehicle");
+  m_registry->Register ("a", 0, m_nodeA);
+  m_registry->Register ("b", 1, m_nodeB);
+  NS_TEST_ASSERT_MSG_EQ (m_registry->GetOwner ("a"), 0, "owner of a");
+  NS_TEST_ASSERT_MSG_EQ (m_registry->GetVehicleId (m_nodeB), "b", "vehicle of node b");
+  NS_TEST_ASSERT_MSG_EQ (m_registry->GetSize (), 2, "linked vehicles");
+
+  // "a" departs in shard 1 within the timeout, "b" does not depart again
+  Simulator::Schedule (Seconds (1.0), &VehicleRegistryHandoverTestCase::ArriveA, this);
+  Simulator::Schedule (Seconds (1.5), &VehicleRegistryHandoverTestCase::DepartA, this);
+  Simulator::Schedule (Seconds (2.0), &VehicleRegistryHandoverTestCase::ArriveB, this);
+  Simulator::Schedule (Seconds (5.0), &VehicleRegistryHandoverTestCase::Check, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  m_registry->Dispose ();
+  m_registry = 0;
+}
+
+/**
+ * \ingroup traci-test
+ * \ingroup tests
+ *
+ * \brief Removal of vehicles without handover
+ */
+class VehicleRegistryUnregisterTestCase : public TestCase
+{
+public:
+  VehicleRegistryUnregisterTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+VehicleRegistryUnregisterTestCase::VehicleRegistryUnregisterTestCase ()
+  : TestCase ("Check that unregistered vehicles are gone at once")
+{
+}
+
+void
+VehicleRegistryUnregisterTestCase::DoRun (void)
+{
+  Ptr<VehicleRegistry> registry = CreateObject<VehicleRegistry> ();
+  registry->AddShard (0);
+  registry->AddShard (0);
+  Ptr<Node> node = CreateObject<Node> ();
+  registry->Register ("a", 0, node);
+
+  // only the owner can unregister a vehicle
+  registry->Unregister ("a", 1);
+  NS_TEST_ASSERT_MSG_EQ (registry->GetOwner ("a"), 0, "owner after unregistering in another shard");
+
+  registry->Unregister ("a", 0);
+  NS_TEST_ASSERT_MSG_EQ (registry->GetOwner ("a"), -1, "owner after unregistering");
+  NS_TEST_ASSERT_MSG_EQ (registry->GetNode ("a"), Ptr<Node> (), "node after unregistering");
+  NS_TEST_ASSERT_MSG_EQ (registry->GetVehicleId (node), "", "vehicle after unregistering");
+  NS_TEST_ASSERT_MSG_EQ (registry->GetSize (), 0, "linked vehicles after unregistering");
+  NS_TEST_ASSERT_MSG_EQ (registry->GetShardStats (0).vehicles, 0, "vehicles of shard 0");
+
+  // the vehicle departs as a new one, e.g. after a reset
+  NS_TEST_ASSERT_MSG_EQ (registry->Acquire ("a", 1), Ptr<Node> (), "node of an unregistered vehicle");
+  NS_TEST_ASSERT_MSG_EQ (registry->GetHandovers (), 0, "handovers");
+
+  registry->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup traci-test
+ * \ingroup tests
+ *
+ * \brief Vehicle registry test suite
+ */
+class VehicleRegistryTestSuite : public TestSuite
+{
+public:
+  VehicleRegistryTestSuite ();
+};
+
+VehicleRegistryTestSuite::VehicleRegistryTestSuite ()
+  : TestSuite ("traci-vehicle-registry", UNIT)
+{
+  AddTestCase (new VehicleRegistryHandoverTestCase, TestCase::QUICK);
+  AddTestCase (new VehicleRegistryUnregisterTestCase, TestCase::QUICK);
+}
+
+static VehicleRegistryTestSuite g_vehicleRegistryTestSuite; ///< the test suite